@@ -0,0 +1,120 @@
+// bench_render.cpp
+//
+
+#include "bench_render.h"
+
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bench {
+
+//------------------------------------------------------------------------------
+void add_explosion(std::vector<render::particle>& particles, std::minstd_rand& r, time_value time, vec2 position, float strength)
+{
+    float scale = std::sqrt(strength);
+    render::particle p{};
+    p.time = time;
+
+    // shock wave
+    p.position = position;
+    p.color = color4(1.0f, 1.0f, 0.5f, 0.5f);
+    p.color_velocity = -p.color * color4(0, 1, 3, 3);
+    p.size = 12.0f * scale;
+    p.size_velocity = 192.0f * scale;
+    p.flags = render::particle::invert;
+    particles.push_back(p);
+
+    // smoke
+    for (int ii = 0; ii < 96 * scale; ++ii) {
+        float a = uniform(r, 0.f, 2.f * math::pi<float>);
+        float d = uniform(r, 0.f, 12.f * scale);
+        p = render::particle{};
+        p.time = time;
+        p.position = position + vec2(std::cos(a), std::sin(a)) * d;
+        a = uniform(r, 0.f, 2.f * math::pi<float>);
+        d = std::sqrt(uniform(r, 0.f, 1.f)) * 128.f * strength;
+        p.velocity = vec2(std::cos(a), std::sin(a)) * d;
+        p.size = uniform(r, 4.f, 12.f) * scale;
+        p.size_velocity = 2.0f * strength;
+        p.color = color4(0.5f, 0.5f, 0.5f, uniform(r, .1f, .2f));
+        p.color_velocity = color4(0, 0, 0, -p.color.a / uniform(r, 2.f, 3.5f));
+        p.drag = uniform(r, 3.f, 4.f) * scale;
+        particles.push_back(p);
+    }
+
+    // fire
+    for (int ii = 0; ii < 64 * scale; ++ii) {
+        float a = uniform(r, 0.f, 2.f * math::pi<float>);
+        float d = uniform(r, 0.f, 8.f) * scale;
+        p = render::particle{};
+        p.time = time;
+        p.position = position + vec2(std::cos(a), std::sin(a)) * d;
+        a = uniform(r, 0.f, 2.f * math::pi<float>);
+        d = std::sqrt(uniform(r, 0.f, 1.f)) * 128.0f * strength;
+        p.velocity = vec2(std::cos(a), std::sin(a)) * d;
+        p.color = color4(1.0f, uniform(r, 0.f, 1.f), 0.0f, 0.1f);
+        p.color_velocity = color4(0, 0, 0, -p.color.a / (0.5f + square(uniform(r, 0.f, 1.f)) * 2.5f));
+        p.size = uniform(r, 8.f, 24.f) * scale;
+        p.size_velocity = 1.0f * strength;
+        p.drag = uniform(r, 2.f, 4.f) * scale;
+        particles.push_back(p);
+    }
+
+    // debris
+    for (int ii = 0; ii < 32 * scale; ++ii) {
+        float a = uniform(r, 0.f, 2.f * math::pi<float>);
+        float d = uniform(r, 0.f, 2.f * scale);
+        p = render::particle{};
+        p.time = time;
+        p.position = position + vec2(std::cos(a), std::sin(a)) * d;
+        a = uniform(r, 0.f, 2.f * math::pi<float>);
+        d = uniform(r, 0.f, 128.f) * scale;
+        p.velocity = vec2(std::cos(a), std::sin(a)) * d;
+        p.color = color4(1, uniform(r, .5f, 1.f), 0, 1);
+        p.color_velocity = color4(0, 0, 0, -1.5f - uniform(r, 0.f, 1.f));
+        p.size = 0.5f;
+        p.drag = uniform(r, .5f, 1.f);
+        p.flags = render::particle::tail;
+        particles.push_back(p);
+    }
+}
+
+//------------------------------------------------------------------------------
+void record_frame(render::command_list& commands,
+                  frame_assets const& assets,
+                  std::vector<tank_state> const& tanks,
+                  std::vector<vec2> const& projectiles,
+                  render::particle_tessellator const& particles)
+{
+    commands.clear();
+    commands.set_view(render::view{vec2(320, 240), vec2(640, 480), rect{}});
+
+    for (auto const& t : tanks) {
+        commands.draw_model(assets.body, mat3::transform(t.position, t.angle), t.color);
+    }
+    for (auto const& t : tanks) {
+        commands.draw_model(assets.turret, mat3::transform(t.position, t.turret_angle), t.color);
+    }
+
+    for (auto const& t : tanks) {
+        commands.draw_box(vec2(20,2), t.position + vec2(0,25), color4(0.5,0.5,0.5,1));
+        commands.draw_box(vec2(15,2), t.position + vec2(0,25), color4(0,1,0,1));
+        commands.draw_box(vec2(20,2), t.position + vec2(0,22), color4(0.5,0.5,0.5,1));
+        commands.draw_box(vec2(10,2), t.position + vec2(0,22), color4(1,0,0,1));
+    }
+    for (auto const& p : projectiles) {
+        commands.draw_line(p, p - vec2(8, 0), color4(1,0.5,0,1), color4(1,0.5,0,0));
+    }
+
+    commands.draw_particles(particles.vertices().data(), particles.vertices().size(),
+                            particles.indices().data(), particles.indices().size());
+
+    commands.set_view(render::view{vec2(320, 240), vec2(640, 480), rect{}});
+    for (std::size_t ii = 0; ii < tanks.size(); ++ii) {
+        commands.draw_box(vec2(7,7), vec2(500, 26 + 12.f * ii), tanks[ii].color);
+        commands.draw_string(assets.font, player_name, vec2(510, 30 + 12.f * ii), color4(1,1,1,1), vec2(1,1));
+    }
+    commands.draw_line(vec2(490, 16), vec2(630, 16), color4(1,1,1,1), color4(1,1,1,.5f));
+}
+
+} // namespace bench
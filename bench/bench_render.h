@@ -0,0 +1,56 @@
+// bench_render.h
+//
+
+#pragma once
+
+#include "bench_shared.h"
+
+#include "cm_shared.h"
+#include "r_command.h"
+#include "r_particle.h"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bench {
+
+constexpr time_delta frame_time = time_delta::from_microseconds(16667);
+//! same as the game frame time, tails are drawn from the previous game frame
+constexpr time_delta tail_delay = time_delta::from_milliseconds(50);
+
+//------------------------------------------------------------------------------
+//! Spawn the particles of an explosion effect in the same way as the game.
+void add_explosion(std::vector<render::particle>& particles, std::minstd_rand& r, time_value time, vec2 position, float strength = 1.f);
+
+//------------------------------------------------------------------------------
+struct tank_state
+{
+    vec2 position;
+    float angle;
+    float turret_angle;
+    color4 color;
+};
+
+//------------------------------------------------------------------------------
+//! Models and font referenced by recorded frames.
+struct frame_assets
+{
+    render::model const* body;
+    render::model const* turret;
+    render::font const* font;
+};
+
+//! Text drawn for each player on the scoreboard
+constexpr char player_name[] = "player ^f00tank";
+
+//------------------------------------------------------------------------------
+//! Record a frame in the same order as the game: world view, all tank bodies,
+//! all turrets, status bars and projectile trails, particles and then the user
+//! interface.
+void record_frame(render::command_list& commands,
+                  frame_assets const& assets,
+                  std::vector<tank_state> const& tanks,
+                  std::vector<vec2> const& projectiles,
+                  render::particle_tessellator const& particles);
+
+} // namespace bench
@@ -0,0 +1,30 @@
+// bench_shared.h
+//
+
+#pragma once
+
+#include <chrono>
+#include <random>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------
+inline double seconds(clock::time_point start, clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+//------------------------------------------------------------------------------
+//! Returns a uniformly distributed number in the range [min, max]. Standard
+//! distributions are implementation-defined so the engine output is used
+//! directly to generate the same scenarios on every platform.
+inline float uniform(std::minstd_rand& engine, float min, float max)
+{
+    float t = float(engine() - engine.min()) / float(engine.max() - engine.min());
+    return min + (max - min) * t;
+}
+
+} // namespace bench
@@ -0,0 +1,230 @@
+// command_bench.cpp
+//
+
+#include "bench_render.h"
+
+#include "cm_shared.h"
+#include "r_backend.h"
+#include "r_particle.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+using bench::frame_assets;
+using bench::record_frame;
+using bench::seconds;
+using bench::tank_state;
+using bench::uniform;
+
+// commands only refer to these by address, the null backend never reads them
+int body_model_storage, turret_model_storage, font_storage;
+render::model const* const body_model = reinterpret_cast<render::model const*>(&body_model_storage);
+render::model const* const turret_model = reinterpret_cast<render::model const*>(&turret_model_storage);
+render::font const* const font = reinterpret_cast<render::font const*>(&font_storage);
+frame_assets const assets{body_model, turret_model, font};
+
+//------------------------------------------------------------------------------
+//! Returns the number of commands which do not match what was recorded.
+std::size_t check_frame(render::command_list const& commands,
+                        std::vector<tank_state> const& tanks,
+                        std::vector<vec2> const& projectiles,
+                        render::particle_tessellator const& particles)
+{
+    std::size_t errors = 0;
+    std::size_t body_index = 0;
+    std::size_t turret_index = 0;
+    std::size_t projectile_index = 0;
+
+    for (auto const& cmd : commands) {
+        switch (cmd.type) {
+            case render::command_type::draw_model: {
+                auto const& m = cmd.as<render::draw_model_command>();
+                if (m.model == body_model && body_index < tanks.size()) {
+                    tank_state const& t = tanks[body_index++];
+                    mat3 expected = mat3::transform(t.position, t.angle);
+                    errors += memcmp(&m.transform, &expected, sizeof(mat3)) || memcmp(&m.color, &t.color, sizeof(color4)) ? 1 : 0;
+                } else if (m.model == turret_model && turret_index < body_index) {
+                    tank_state const& t = tanks[turret_index++];
+                    mat3 expected = mat3::transform(t.position, t.turret_angle);
+                    errors += memcmp(&m.transform, &expected, sizeof(mat3)) || memcmp(&m.color, &t.color, sizeof(color4)) ? 1 : 0;
+                } else {
+                    ++errors;
+                }
+                break;
+            }
+
+            case render::command_type::draw_line: {
+                // the last line is the user interface divider
+                auto const& l = cmd.as<render::draw_line_command>();
+                if (projectile_index < projectiles.size()) {
+                    vec2 p = projectiles[projectile_index++];
+                    errors += l.start != p || l.end != p - vec2(8, 0) ? 1 : 0;
+                }
+                break;
+            }
+
+            case render::command_type::draw_particles: {
+                auto const& p = cmd.as<render::draw_particles_command>();
+                bool mismatch = p.num_vertices != particles.vertices().size()
+                    || p.num_indices != particles.indices().size()
+                    || memcmp(p.vertices(), particles.vertices().data(), p.num_vertices * sizeof(render::particle_vertex))
+                    || memcmp(p.indices(), particles.indices().data(), p.num_indices * sizeof(uint32_t));
+                errors += mismatch ? 1 : 0;
+                break;
+            }
+
+            case render::command_type::draw_string: {
+                auto const& s = cmd.as<render::draw_string_command>();
+                std::size_t length = strlen(bench::player_name);
+                errors += s.font != font || s.length != length || memcmp(s.text(), bench::player_name, length) ? 1 : 0;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    return errors + (body_index != tanks.size()) + (turret_index != tanks.size())
+         + (projectile_index != projectiles.size());
+}
+
+//------------------------------------------------------------------------------
+//! Returns the number of model instances which were not gathered into one batch
+//! of all tank bodies followed by one batch of all turrets, in the order they
+//! were drawn.
+std::size_t check_instances(render::model_batcher const& models,
+                            std::vector<tank_state> const& tanks)
+{
+    auto const& batches = models.batches();
+    auto const& instances = models.instances();
+
+    if (tanks.empty()) {
+        return batches.size();
+    } else if (batches.size() != 2 || batches[0].model != body_model || batches[1].model != turret_model
+            || batches[0].num_instances != tanks.size() || batches[1].num_instances != tanks.size()) {
+        return 2 * tanks.size();
+    }
+
+    auto differs = [](render::model_instance const& instance, mat3 const& m, color4 const& color) {
+        return instance.x_axis != vec2(m[0][0], m[0][1])
+            || instance.y_axis != vec2(m[1][0], m[1][1])
+            || instance.translation != vec2(m[2][0], m[2][1])
+            || memcmp(&instance.color, &color, sizeof(color4));
+    };
+
+    std::size_t errors = 0;
+    for (std::size_t ii = 0; ii < tanks.size(); ++ii) {
+        tank_state const& t = tanks[ii];
+        errors += differs(instances[batches[0].first_instance + ii], mat3::transform(t.position, t.angle), t.color);
+        errors += differs(instances[batches[1].first_instance + ii], mat3::transform(t.position, t.turret_angle), t.color);
+    }
+    return errors;
+}
+
+//------------------------------------------------------------------------------
+void print_usage()
+{
+    printf("usage: command_bench [options]\n"
+           "  --tanks <count>        number of tanks\n"
+           "  --frames <count>       number of frames to run\n"
+           "  --check                fail if any recorded command does not match\n"
+           "                         what was drawn, or if tank bodies and turrets\n"
+           "                         are not each gathered into one batch\n");
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int num_tanks = 16;
+    int num_frames = 600;
+    bool check = false;
+
+    for (int ii = 1; ii < argc; ++ii) {
+        bool has_value = ii + 1 < argc;
+        if (strcmp(argv[ii], "--tanks") == 0 && has_value) {
+            num_tanks = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--frames") == 0 && has_value) {
+            num_frames = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--check") == 0) {
+            check = true;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::minstd_rand r(1);
+
+    std::vector<tank_state> tanks(num_tanks);
+    std::vector<vec2> projectiles(num_tanks * 4);
+
+    // a fixed set of particles, tessellation is measured by particle_bench
+    render::particle_store store;
+    for (int ii = 0; ii < 2048; ++ii) {
+        render::particle p{};
+        p.position = vec2(uniform(r, 0.f, 640.f), uniform(r, 0.f, 480.f));
+        p.size = uniform(r, .5f, 12.f);
+        p.color = color4(1, 1, 1, uniform(r, .1f, 1.f));
+        store.add(p);
+    }
+    store.update(time_value::zero, time_delta::zero);
+    render::particle_tessellator particles;
+    particles.tessellate(store, 2.f);
+
+    render::command_list commands;
+    render::null_backend backend;
+
+    double record_time = 0;
+    double execute_time = 0;
+    std::size_t errors = 0;
+
+    for (int frame = 0; frame < num_frames; ++frame) {
+        for (auto& t : tanks) {
+            t = {vec2(uniform(r, 0.f, 640.f), uniform(r, 0.f, 480.f)),
+                 uniform(r, 0.f, 6.f), uniform(r, 0.f, 6.f),
+                 color4(uniform(r, 0.f, 1.f), uniform(r, 0.f, 1.f), uniform(r, 0.f, 1.f), 1)};
+        }
+        for (auto& p : projectiles) {
+            p = vec2(uniform(r, 0.f, 640.f), uniform(r, 0.f, 480.f));
+        }
+
+        auto t0 = bench::clock::now();
+        record_frame(commands, assets, tanks, projectiles, particles);
+        auto t1 = bench::clock::now();
+        backend.execute(commands);
+        auto t2 = bench::clock::now();
+
+        record_time += seconds(t0, t1);
+        execute_time += seconds(t1, t2);
+        errors += check_frame(commands, tanks, projectiles, particles);
+        errors += check_instances(backend.models(), tanks);
+    }
+
+    auto const& stats = backend.get_stats();
+    std::size_t expected_commands = 2 + num_tanks * 6 + projectiles.size() + 1 + num_tanks * 2 + 1;
+
+    printf("%6s %6s %10s %10s %10s %10s %10s %10s %10s\n",
+           "tanks", "frames", "commands", "batches", "instances", "bytes", "record us", "execute us", "errors");
+    printf("%6d %6d %10zu %10zu %10zu %10zu %10.1f %10.1f %10zu\n",
+           num_tanks, num_frames, stats.commands, stats.batches, stats.instances, stats.bytes,
+           record_time * 1e6 / num_frames, execute_time * 1e6 / num_frames, errors);
+
+    // one batch for all bodies and one for all turrets
+    std::size_t expected_model_batches = num_tanks ? 2 : 0;
+
+    if (check && (errors || stats.commands != expected_commands || stats.vertices != particles.vertices().size()
+                  || stats.model_batches != expected_model_batches)) {
+        printf("recorded commands do not match what was drawn\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
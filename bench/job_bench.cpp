@@ -0,0 +1,228 @@
+// job_bench.cpp
+//
+
+#include "bench_shared.h"
+
+#include "cm_job.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+using bench::seconds;
+
+//------------------------------------------------------------------------------
+//! Arbitrary amount of floating point work for a single element.
+float kernel(std::size_t index, int cost)
+{
+    float x = float(index);
+    for (int ii = 0; ii < cost; ++ii) {
+        x = std::sqrt(x * x + 1.f);
+    }
+    return x;
+}
+
+//------------------------------------------------------------------------------
+//! Run known workloads and return the number of failed checks.
+int check_jobs(job::system& jobs, int num_threads)
+{
+    int errors = 0;
+    auto expect = [&errors](bool condition, char const* message) {
+        if (!condition) {
+            printf("check failed: %s\n", message);
+            ++errors;
+        }
+    };
+
+    // every element is visited exactly once
+    {
+        std::vector<std::atomic<int>> visits(100003);
+        for (auto& v : visits) {
+            v = 0;
+        }
+        jobs.parallel_for(0, visits.size(), 64, [&visits](std::size_t first, std::size_t last) {
+            for (std::size_t ii = first; ii < last; ++ii) {
+                visits[ii].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        bool once = true;
+        for (auto const& v : visits) {
+            once &= v.load() == 1;
+        }
+        expect(once, "parallel_for visits each element once");
+
+        bool called = false;
+        jobs.parallel_for(8, 8, 1, [&called](std::size_t, std::size_t) { called = true; });
+        expect(!called, "parallel_for skips empty ranges");
+    }
+
+    // jobs fork and join other jobs from inside the pool
+    {
+        std::atomic<int> count(0);
+        jobs.parallel_for(0, 16, 1, [&jobs, &count](std::size_t first, std::size_t last) {
+            for (std::size_t ii = first; ii < last; ++ii) {
+                jobs.parallel_for(0, 256, 8, [&count](std::size_t begin, std::size_t end) {
+                    count.fetch_add(int(end - begin), std::memory_order_relaxed);
+                });
+            }
+        });
+        expect(count.load() == 16 * 256, "nested parallel_for runs every subrange");
+    }
+
+    // jobs queued by a busy thread are stolen by other threads, the waiting
+    // caller is also able to steal so a single worker is enough
+    if (num_threads > 0) {
+        std::thread::id owner;
+        std::vector<std::thread::id> runners(32);
+
+        job::counter outer;
+        jobs.submit([&]() {
+            owner = std::this_thread::get_id();
+
+            job::counter inner;
+            for (std::size_t ii = 0; ii < runners.size(); ++ii) {
+                jobs.submit([&runners, ii]() {
+                    runners[ii] = std::this_thread::get_id();
+                    kernel(ii, 20000);
+                }, inner);
+            }
+
+            // keep the owner busy so that its queue can only drain by stealing
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            jobs.wait(inner);
+        }, outer);
+        jobs.wait(outer);
+
+        std::set<std::thread::id> threads(runners.begin(), runners.end());
+        threads.erase(owner);
+        expect(threads.size() > 0, "queued jobs are stolen from a busy thread");
+    }
+
+    // uneven subranges still complete with every result written
+    {
+        std::vector<float> results(4096);
+        jobs.parallel_for(0, results.size(), 16, [&results](std::size_t first, std::size_t last) {
+            for (std::size_t ii = first; ii < last; ++ii) {
+                results[ii] = kernel(ii, ii < 64 ? 20000 : 10);
+            }
+        });
+
+        bool match = true;
+        for (std::size_t ii = 0; ii < results.size(); ++ii) {
+            match &= results[ii] == kernel(ii, ii < 64 ? 20000 : 10);
+        }
+        expect(match, "uneven parallel_for matches serial results");
+    }
+
+    // one thread for each hardware thread except the caller, and restarting
+    {
+        jobs.init(0);
+        unsigned hardware = std::thread::hardware_concurrency();
+        expect(jobs.num_threads() == (hardware > 1 ? hardware - 1 : 0), "init(0) starts one thread per core");
+
+        jobs.shutdown();
+        expect(jobs.num_threads() == 0, "shutdown stops all threads");
+
+        std::atomic<int> count(0);
+        jobs.parallel_for(0, 100, 10, [&count](std::size_t first, std::size_t last) {
+            count.fetch_add(int(last - first), std::memory_order_relaxed);
+        });
+        expect(count.load() == 100, "parallel_for runs inline without threads");
+
+        job::counter pending;
+        jobs.submit([]() {}, pending);
+        jobs.shutdown();
+        expect(pending.done(), "shutdown releases discarded jobs");
+
+        jobs.init(num_threads);
+        expect(jobs.num_threads() == std::size_t(num_threads), "init after shutdown restarts threads");
+    }
+
+    return errors;
+}
+
+//------------------------------------------------------------------------------
+void print_usage()
+{
+    printf("usage: job_bench [options]\n"
+           "  --threads <count>      number of worker threads, 0 for one per core\n"
+           "  --elements <count>     number of elements in each parallel_for\n"
+           "  --cost <count>         iterations of work for each element\n"
+           "  --runs <count>         number of times to run each workload\n"
+           "  --check                fail if the job system produces wrong results\n");
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int num_threads = 0;
+    int num_elements = 65536;
+    int cost = 64;
+    int num_runs = 20;
+    bool check = false;
+
+    for (int ii = 1; ii < argc; ++ii) {
+        bool has_value = ii + 1 < argc;
+        if (strcmp(argv[ii], "--threads") == 0 && has_value) {
+            num_threads = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--elements") == 0 && has_value) {
+            num_elements = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--cost") == 0 && has_value) {
+            cost = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--runs") == 0 && has_value) {
+            num_runs = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--check") == 0) {
+            check = true;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    job::system jobs;
+    jobs.init(num_threads);
+
+    if (check && check_jobs(jobs, static_cast<int>(jobs.num_threads()))) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> results(std::max(num_elements, 1));
+    auto run = [&](std::size_t first, std::size_t last) {
+        for (std::size_t ii = first; ii < last; ++ii) {
+            results[ii] = kernel(ii, cost);
+        }
+    };
+
+    auto t0 = bench::clock::now();
+    for (int run_index = 0; run_index < num_runs; ++run_index) {
+        run(0, results.size());
+    }
+    auto t1 = bench::clock::now();
+    for (int run_index = 0; run_index < num_runs; ++run_index) {
+        jobs.parallel_for(0, results.size(), 256, run);
+    }
+    auto t2 = bench::clock::now();
+
+    double serial_ms = seconds(t0, t1) * 1e3 / std::max(num_runs, 1);
+    double parallel_ms = seconds(t1, t2) * 1e3 / std::max(num_runs, 1);
+    printf("%8s %8s %6s %10s %12s %8s\n",
+           "elements", "threads", "cost", "serial ms", "parallel ms", "speedup");
+    printf("%8d %8zu %6d %10.3f %12.3f %7.2fx\n",
+           num_elements, jobs.num_threads(), cost, serial_ms, parallel_ms,
+           parallel_ms > 0 ? serial_ms / parallel_ms : 0.0);
+
+    return EXIT_SUCCESS;
+}
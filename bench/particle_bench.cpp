@@ -0,0 +1,422 @@
+// particle_bench.cpp
+//
+
+#include "bench_render.h"
+
+#include "cm_shared.h"
+#include "r_particle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+using bench::add_explosion;
+using bench::frame_time;
+using bench::seconds;
+using bench::tail_delay;
+using bench::uniform;
+
+//------------------------------------------------------------------------------
+struct scenario
+{
+    char const* name;
+    int interval; //!< frames between explosions
+    int count; //!< explosions spawned at each interval
+    float strength;
+};
+
+scenario const scenarios[] = {
+    {"steady", 10, 1, 1.0f},
+    {"heavy", 1, 1, 2.0f},
+    {"burst", 60, 32, 1.0f},
+};
+
+//------------------------------------------------------------------------------
+//! Order-independent sums of the evaluated state of visible particles.
+struct checksum
+{
+    std::size_t count;
+    double position;
+    double tail_position;
+    double radius;
+    double color;
+
+    void add(vec2 position, vec2 tail_position, float radius, color4 color) {
+        ++count;
+        this->position += double(position.x) + double(position.y);
+        this->tail_position += double(tail_position.x) + double(tail_position.y);
+        this->radius += double(radius);
+        this->color += double(color.r) + double(color.g) + double(color.b) + double(color.a);
+    }
+
+    //! largest relative difference of any sum
+    double compare(checksum const& other) const {
+        auto rel = [](double a, double b) {
+            return std::abs(a - b) / std::max(1.0, std::max(std::abs(a), std::abs(b)));
+        };
+        return std::max(std::max(rel(position, other.position), rel(tail_position, other.tail_position)),
+                        std::max(rel(radius, other.radius), rel(color, other.color)));
+    }
+};
+
+//------------------------------------------------------------------------------
+//! Evaluate particles stored as an array of structures, with expired particles
+//! removed one at a time and drag evaluated per particle as the game did.
+checksum update_aos(std::vector<render::particle>& particles, time_value time)
+{
+    for (std::size_t ii = 0; ii < particles.size(); ++ii) {
+        float ptime = (time - particles[ii].time).to_seconds();
+        if (particles[ii].color.a + particles[ii].color_velocity.a * ptime < 0.0f
+                || particles[ii].size + particles[ii].size_velocity * ptime < 0.0f) {
+            particles[ii] = particles.back();
+            particles.pop_back();
+            --ii;
+        }
+    }
+
+    checksum sum{};
+    for (auto const& p : particles) {
+        float ptime = (time - p.time).to_seconds();
+        if (ptime < 0) {
+            continue;
+        }
+
+        float vtime = p.drag ? tanhf(p.drag * ptime) / p.drag : ptime;
+        float radius = p.size + p.size_velocity * ptime;
+        color4 color = p.color + p.color_velocity * ptime;
+        vec2 position = p.position + p.velocity * vtime + p.acceleration * 0.5f * vtime * vtime;
+
+        float tail_time = std::max<float>(0.0f, (time - p.time - tail_delay).to_seconds());
+        float tail_vtime = p.drag ? tanhf(p.drag * tail_time) / p.drag : tail_time;
+        vec2 tail_position = p.position + p.velocity * tail_vtime + p.acceleration * 0.5f * tail_vtime * tail_vtime;
+
+        sum.add(position, tail_position, radius, color);
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+//! Evaluate particles with `render::particle_store`.
+checksum update_soa(render::particle_store& particles, time_value time)
+{
+    particles.update(time, tail_delay);
+
+    checksum sum{};
+    for (std::size_t ii = 0; ii < particles.size(); ++ii) {
+        if (particles.age(ii) < 0) {
+            continue;
+        }
+        sum.add(particles.position(ii), particles.tail_position(ii), particles.radius(ii), particles.color(ii));
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+//! Tessellate a single particle as a triangle fan in the same way that the
+//! renderer did with immediate mode, including the closing vertex.
+void tessellate_fan(std::vector<render::particle_vertex>& fan, render::particle_store const& particles, std::size_t idx, float view_scale)
+{
+    constexpr int num_segments = render::particle_tessellator::num_segments;
+    float const k_angle = 2.f * math::pi<float> / num_segments;
+
+    float radius = particles.radius(idx);
+    color4 color = particles.color(idx);
+    vec2 position = particles.position(idx);
+    render::particle::flag_bits flags = particles.flags(idx);
+
+    color4 color_in = flags & render::particle::invert ? color * color4(1,1,1,0.25f) : color;
+    color4 color_out = flags & render::particle::invert ? color : color * color4(1,1,1,0.25f);
+
+    int n = 1 + static_cast<int>(math::pi<float> * sqrtf(std::max(0.f, radius * view_scale - 0.25f)));
+
+    fan.clear();
+    fan.push_back({position, color_in});
+
+    if (!(flags & render::particle::tail)) {
+        int k = std::max<int>(1, num_segments / n);
+        for (int ii = 0; ii < num_segments; ii += k) {
+            fan.push_back({position + vec2(std::cos(k_angle * ii), std::sin(k_angle * ii)) * radius, color_out});
+        }
+        fan.push_back({vec2(position.x + radius, position.y), color_out});
+    } else {
+        vec2 normal = position - particles.tail_position(idx);
+        float distance = normal.length();
+        normal /= distance;
+        distance = std::max<float>(distance, radius);
+        vec2 tangent = vec2(-normal.y, normal.x);
+
+        int n0 = std::max<int>(4, n);
+        int k0 = std::max<int>(1, num_segments / n0);
+        for (int ii = 0; ii < num_segments; ii += k0) {
+            float c = std::cos(k_angle * ii);
+            float s = std::sin(k_angle * ii);
+            if (ii < num_segments / 2) {
+                fan.push_back({position + (tangent * c + normal * s) * radius, color_in});
+            } else {
+                fan.push_back({position + tangent * c * radius + normal * s * distance, color_out * -s + color_in * (1.0f + s)});
+            }
+        }
+        fan.push_back({position + tangent * radius, color_in});
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Returns the number of particles whose tessellation differs from the
+//! immediate mode fan by more than `tolerance`.
+std::size_t check_tessellation(render::particle_tessellator const& tess, render::particle_store const& particles, float view_scale, float tolerance)
+{
+    std::vector<render::particle_vertex> fan;
+    auto const& vertices = tess.vertices();
+    auto const& indices = tess.indices();
+    std::size_t base = 0;
+    std::size_t first_index = 0;
+    std::size_t mismatches = 0;
+
+    auto differs = [tolerance](render::particle_vertex const& a, render::particle_vertex const& b) {
+        return (a.position - b.position).length() > tolerance * std::max(1.f, b.position.length())
+            || std::abs(a.color.r - b.color.r) > tolerance || std::abs(a.color.g - b.color.g) > tolerance
+            || std::abs(a.color.b - b.color.b) > tolerance || std::abs(a.color.a - b.color.a) > tolerance;
+    };
+
+    for (std::size_t idx = 0; idx < particles.size(); ++idx) {
+        if (particles.age(idx) < 0 || particles.culled(idx)) {
+            continue;
+        }
+
+        tessellate_fan(fan, particles, idx, view_scale);
+
+        // the tessellator closes the fan by index instead of a vertex
+        std::size_t n = fan.size() - 2;
+        bool mismatch = base + 1 + n > vertices.size() || first_index + 3 * n > indices.size();
+        for (std::size_t ii = 0; !mismatch && ii < n + 1; ++ii) {
+            mismatch = differs(vertices[base + ii], fan[ii]);
+        }
+        for (std::size_t ii = 0; !mismatch && ii < n; ++ii) {
+            std::size_t expected[3] = {base, base + 1 + ii, base + 1 + (ii + 1) % n};
+            for (int jj = 0; jj < 3; ++jj) {
+                mismatch |= indices[first_index + 3 * ii + jj] != expected[jj];
+            }
+        }
+        if (!mismatch) {
+            mismatch = differs(vertices[base + 1], fan.back());
+        }
+
+        mismatches += mismatch ? 1 : 0;
+        base += 1 + n;
+        first_index += 3 * n;
+    }
+
+    if (base != vertices.size() || first_index != indices.size()) {
+        ++mismatches;
+    }
+    return mismatches;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the number of culled particles whose immediate mode fan intersects
+//! `view`, culling must be conservative.
+std::size_t check_culling(render::particle_store const& particles, bounds const& view, float view_scale)
+{
+    std::vector<render::particle_vertex> fan;
+    std::size_t errors = 0;
+
+    for (std::size_t idx = 0; idx < particles.size(); ++idx) {
+        if (particles.age(idx) < 0 || !particles.culled(idx)) {
+            continue;
+        }
+
+        tessellate_fan(fan, particles, idx, view_scale);
+
+        bounds b(fan[0].position, fan[0].position);
+        for (auto const& v : fan) {
+            b.add(v.position);
+        }
+        errors += b.intersects(view) ? 1 : 0;
+    }
+    return errors;
+}
+
+//------------------------------------------------------------------------------
+struct result
+{
+    double aos_time; //!< seconds updating the array of structures
+    double soa_time; //!< seconds updating the particle store
+    double tess_time; //!< seconds tessellating the particle store
+    std::size_t vertices; //!< number of vertices summed over all frames
+    std::size_t tess_mismatches; //!< particles tessellated differently than immediate mode
+    double cull_time; //!< seconds culling and tessellating for the zoomed view
+    std::size_t culled; //!< number of particles culled summed over all frames
+    std::size_t cull_errors; //!< culled particles which intersect the zoomed view
+    std::size_t particle_frames; //!< number of particles summed over all frames
+    std::size_t max_particles;
+    std::size_t count_mismatches; //!< frames where the number of visible particles differ
+    double max_error; //!< largest relative difference between checksums
+};
+
+//------------------------------------------------------------------------------
+result run_scenario(scenario const& sc, int num_frames)
+{
+    //! pixels per unit at 1280x960 with the game's 640x480 view
+    constexpr float view_scale = 2.f;
+    //! a view zoomed in on a quarter of the arena
+    bounds const zoom_view(vec2(-160, -120), vec2(160, 120));
+
+    std::minstd_rand r(1);
+    result res{};
+
+    std::vector<render::particle> aos;
+    render::particle_store soa;
+    render::particle_tessellator tess;
+    std::vector<render::particle> spawned;
+
+    time_value time = time_value::zero;
+    for (int frame = 0; frame < num_frames; ++frame, time += frame_time) {
+        spawned.clear();
+        if (frame % sc.interval == 0) {
+            for (int ii = 0; ii < sc.count; ++ii) {
+                vec2 position(uniform(r, -320.f, 320.f), uniform(r, -240.f, 240.f));
+                add_explosion(spawned, r, time, position, sc.strength);
+            }
+        }
+
+        auto t0 = bench::clock::now();
+        aos.insert(aos.end(), spawned.begin(), spawned.end());
+        checksum aos_sum = update_aos(aos, time);
+
+        auto t1 = bench::clock::now();
+        for (auto const& p : spawned) {
+            soa.add(p);
+        }
+        checksum soa_sum = update_soa(soa, time);
+
+        auto t2 = bench::clock::now();
+        tess.tessellate(soa, view_scale);
+        auto t3 = bench::clock::now();
+
+        res.aos_time += seconds(t0, t1);
+        res.soa_time += seconds(t1, t2);
+        res.tess_time += seconds(t2, t3);
+        res.vertices += tess.vertices().size();
+        res.tess_mismatches += check_tessellation(tess, soa, view_scale, 1e-4f);
+
+        auto t4 = bench::clock::now();
+        res.culled += soa.cull(zoom_view);
+        tess.tessellate(soa, 2.f * view_scale);
+        auto t5 = bench::clock::now();
+
+        res.cull_time += seconds(t4, t5);
+        res.tess_mismatches += check_tessellation(tess, soa, 2.f * view_scale, 1e-4f);
+        res.cull_errors += check_culling(soa, zoom_view, 2.f * view_scale);
+        res.particle_frames += aos.size();
+        res.max_particles = std::max(res.max_particles, aos.size());
+        if (aos_sum.count != soa_sum.count) {
+            ++res.count_mismatches;
+        }
+        res.max_error = std::max(res.max_error, aos_sum.compare(soa_sum));
+    }
+
+    return res;
+}
+
+//------------------------------------------------------------------------------
+void print_header()
+{
+    printf("%-10s %6s %10s %10s %10s %10s %10s %8s %10s %10s %10s %10s %8s %10s %10s %8s\n",
+           "scenario", "frames", "particles", "peak", "aos us", "soa us", "aos ns/p", "soa ns/p", "mismatch", "max error",
+           "vertices", "tess us", "tess bad", "culled", "zoom us", "cull bad");
+}
+
+//------------------------------------------------------------------------------
+void print_result(char const* name, int num_frames, result const& res)
+{
+    double particles = res.particle_frames ? double(res.particle_frames) : 1.0;
+
+    // times are per frame, or per particle, including removal of expired particles
+    printf("%-10s %6d %10.1f %10zu %10.1f %10.1f %10.2f %8.2f %10zu %10.2e %10.1f %10.1f %8zu %10.1f %10.1f %8zu\n",
+           name, num_frames,
+           double(res.particle_frames) / num_frames,
+           res.max_particles,
+           res.aos_time * 1e6 / num_frames,
+           res.soa_time * 1e6 / num_frames,
+           res.aos_time * 1e9 / particles,
+           res.soa_time * 1e9 / particles,
+           res.count_mismatches,
+           res.max_error,
+           double(res.vertices) / num_frames,
+           res.tess_time * 1e6 / num_frames,
+           res.tess_mismatches,
+           double(res.culled) / num_frames,
+           res.cull_time * 1e6 / num_frames,
+           res.cull_errors);
+}
+
+//------------------------------------------------------------------------------
+void print_usage()
+{
+    printf("usage: particle_bench [options]\n"
+           "  --scenario <name>      run a single scenario\n"
+           "  --frames <count>       number of frames to run\n"
+           "  --check                fail if any particle is tessellated differently\n"
+           "                         than the immediate mode renderer or is culled\n"
+           "                         while visible\n");
+    printf("scenarios:");
+    for (auto const& sc : scenarios) {
+        printf(" %s", sc.name);
+    }
+    printf("\n");
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    char const* scenario_name = nullptr;
+    int num_frames = 600;
+    bool check = false;
+
+    for (int ii = 1; ii < argc; ++ii) {
+        bool has_value = ii + 1 < argc;
+        if (strcmp(argv[ii], "--scenario") == 0 && has_value) {
+            scenario_name = argv[++ii];
+        } else if (strcmp(argv[ii], "--frames") == 0 && has_value) {
+            num_frames = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--check") == 0) {
+            check = true;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::size_t tess_mismatches = 0;
+    std::size_t cull_errors = 0;
+
+    print_header();
+    for (auto const& sc : scenarios) {
+        if (scenario_name && strcmp(sc.name, scenario_name) != 0) {
+            continue;
+        }
+        auto res = run_scenario(sc, num_frames);
+        print_result(sc.name, num_frames, res);
+        tess_mismatches += res.tess_mismatches;
+        cull_errors += res.cull_errors;
+    }
+
+    if (check && tess_mismatches) {
+        printf("%zu particles tessellated incorrectly\n", tess_mismatches);
+        return EXIT_FAILURE;
+    }
+    if (check && cull_errors) {
+        printf("%zu visible particles culled\n", cull_errors);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
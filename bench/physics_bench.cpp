@@ -0,0 +1,618 @@
+// physics_bench.cpp
+//
+
+#include "bench_shared.h"
+
+#include "cm_job.h"
+#include "cm_profile.h"
+#include "p_collide.h"
+#include "p_material.h"
+#include "p_rigidbody.h"
+#include "p_shape.h"
+#include "p_trace.h"
+#include "p_world.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+time_value time_value::current()
+{
+    static auto offset = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::now() - offset;
+    return time_value::from_microseconds(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+using bench::seconds;
+using bench::uniform;
+
+constexpr float delta_time = 0.05f;
+constexpr vec2 arena_size = vec2(640.f, 480.f);
+
+//! relative tolerance for comparing checksums against golden output, results
+//! may differ slightly between compilers and math libraries
+constexpr double checksum_tolerance = 1e-3;
+
+//------------------------------------------------------------------------------
+//! Physics world which exposes the phases of a step so they can be timed.
+class bench_world : public physics::world
+{
+public:
+    using physics::world::world;
+    using physics::world::overlap;
+    using physics::world::body;
+    using physics::world::generate_overlaps;
+};
+
+//------------------------------------------------------------------------------
+//! Bodies and the shapes and materials they reference.
+struct scene
+{
+    physics::material material{0.5f, 1.0f};
+    physics::material projectile_material{0.5f, 1.0f};
+    physics::material wall_material{0.5f, 1.0f};
+
+    std::vector<std::unique_ptr<physics::shape>> shapes;
+    std::vector<std::unique_ptr<physics::rigid_body>> bodies;
+
+    //! projectiles which are moved with segment queries instead of bodies
+    std::vector<vec2> points;
+    std::vector<vec2> point_velocities;
+
+    physics::rigid_body* add_body(std::unique_ptr<physics::shape>&& shape, physics::material const* mat, float mass, vec2 position) {
+        shapes.push_back(std::move(shape));
+        bodies.push_back(std::make_unique<physics::rigid_body>(shapes.back().get(), mat, mass));
+        bodies.back()->set_position(position);
+        return bodies.back().get();
+    }
+
+    physics::rigid_body* add_circle(float radius, vec2 position) {
+        return add_body(std::make_unique<physics::circle_shape>(radius), &material, 1.0f, position);
+    }
+
+    physics::rigid_body* add_box(vec2 size, vec2 position) {
+        return add_body(std::make_unique<physics::box_shape>(size), &material, 1.0f, position);
+    }
+
+    physics::rigid_body* add_polygon(vec2 const* points, std::size_t num_points, vec2 position) {
+        return add_body(std::make_unique<physics::polygon_shape>(points, num_points), &material, 1.0f, position);
+    }
+
+    //! add static walls around the arena
+    void add_walls() {
+        vec2 half_size = arena_size * 0.5f;
+        add_body(std::make_unique<physics::box_shape>(vec2(arena_size.x + 32.f, 16.f)), &wall_material, 0.f, vec2(0.f, -half_size.y - 8.f));
+        add_body(std::make_unique<physics::box_shape>(vec2(arena_size.x + 32.f, 16.f)), &wall_material, 0.f, vec2(0.f, half_size.y + 8.f));
+        add_body(std::make_unique<physics::box_shape>(vec2(16.f, arena_size.y + 32.f)), &wall_material, 0.f, vec2(-half_size.x - 8.f, 0.f));
+        add_body(std::make_unique<physics::box_shape>(vec2(16.f, arena_size.y + 32.f)), &wall_material, 0.f, vec2(half_size.x + 8.f, 0.f));
+    }
+};
+
+//------------------------------------------------------------------------------
+//! Circles and boxes of random size scattered over the arena.
+void build_random(scene& s, std::minstd_rand& r, std::size_t num_bodies)
+{
+    vec2 half_size = arena_size * 0.5f;
+    for (std::size_t ii = 0; ii < num_bodies; ++ii) {
+        vec2 position(uniform(r, -half_size.x, half_size.x), uniform(r, -half_size.y, half_size.y));
+        physics::rigid_body* body = (ii & 1) ? s.add_box(vec2(uniform(r, 8.f, 24.f), uniform(r, 8.f, 24.f)), position)
+                                             : s.add_circle(uniform(r, 4.f, 12.f), position);
+        body->set_rotation(uniform(r, -math::pi<float>, math::pi<float>));
+        body->set_linear_velocity(vec2(uniform(r, -64.f, 64.f), uniform(r, -64.f, 64.f)));
+        body->set_angular_velocity(uniform(r, -1.f, 1.f));
+    }
+    s.add_walls();
+}
+
+//------------------------------------------------------------------------------
+//! Dense clusters of bodies converging on the center of the arena.
+void build_crowd(scene& s, std::minstd_rand& r, std::size_t num_bodies)
+{
+    vec2 const centers[] = {vec2(-160.f, -120.f), vec2(160.f, -120.f), vec2(-160.f, 120.f), vec2(160.f, 120.f)};
+    for (std::size_t ii = 0; ii < num_bodies; ++ii) {
+        vec2 center = centers[ii % 4];
+        vec2 position = center + vec2(uniform(r, -48.f, 48.f), uniform(r, -48.f, 48.f));
+        physics::rigid_body* body = (ii & 1) ? s.add_box(vec2(12.f, 8.f), position)
+                                             : s.add_circle(5.f, position);
+        body->set_rotation(uniform(r, -math::pi<float>, math::pi<float>));
+        body->set_linear_velocity(-center.normalize() * 32.f);
+    }
+    s.add_walls();
+}
+
+//------------------------------------------------------------------------------
+//! Random convex polygons and circles scattered over the arena.
+void build_polygons(scene& s, std::minstd_rand& r, std::size_t num_bodies)
+{
+    vec2 half_size = arena_size * 0.5f;
+    for (std::size_t ii = 0; ii < num_bodies; ++ii) {
+        vec2 position(uniform(r, -half_size.x, half_size.x), uniform(r, -half_size.y, half_size.y));
+        physics::rigid_body* body;
+        if (ii % 4) {
+            // points scattered around a circle so that the hull is never degenerate
+            vec2 points[8];
+            float radius = uniform(r, 6.f, 14.f);
+            for (std::size_t jj = 0; jj < 8; ++jj) {
+                float angle = (float(jj) + uniform(r, 0.f, 0.8f)) * (2.f * math::pi<float> / 8.f);
+                points[jj] = vec2(std::cos(angle), std::sin(angle)) * radius * uniform(r, 0.6f, 1.f);
+            }
+            body = s.add_polygon(points, 8, position);
+        } else {
+            body = s.add_circle(uniform(r, 4.f, 12.f), position);
+        }
+        body->set_rotation(uniform(r, -math::pi<float>, math::pi<float>));
+        body->set_linear_velocity(vec2(uniform(r, -64.f, 64.f), uniform(r, -64.f, 64.f)));
+        body->set_angular_velocity(uniform(r, -1.f, 1.f));
+    }
+    s.add_walls();
+}
+
+//------------------------------------------------------------------------------
+//! Fast projectiles fired across the arena through a group of tanks.
+void build_projectiles(scene& s, std::minstd_rand& r, std::size_t num_bodies, bool segments)
+{
+    std::size_t num_tanks = std::min<std::size_t>(16, num_bodies);
+    for (std::size_t ii = 0; ii < num_tanks; ++ii) {
+        vec2 position(float(ii % 4) * 64.f - 96.f, float(ii / 4) * 64.f - 96.f);
+        physics::rigid_body* body = s.add_box(vec2(24.f, 16.f), position);
+        body->set_rotation(uniform(r, -math::pi<float>, math::pi<float>));
+        body->set_linear_velocity(vec2(uniform(r, -16.f, 16.f), uniform(r, -16.f, 16.f)));
+    }
+
+    vec2 half_size = arena_size * 0.5f;
+    for (std::size_t ii = num_tanks; ii < num_bodies; ++ii) {
+        float side = (ii & 1) ? 1.f : -1.f;
+        vec2 position(side * (half_size.x - 8.f), uniform(r, -half_size.y, half_size.y));
+        vec2 target(uniform(r, -128.f, 128.f), uniform(r, -128.f, 128.f));
+        vec2 velocity = (target - position).normalize() * 800.f;
+        if (segments) {
+            s.points.push_back(position);
+            s.point_velocities.push_back(velocity);
+        } else {
+            physics::rigid_body* body = s.add_body(std::make_unique<physics::circle_shape>(1.5f), &s.projectile_material, 1e-3f, position);
+            body->set_linear_velocity(velocity);
+        }
+    }
+    s.add_walls();
+}
+
+//------------------------------------------------------------------------------
+void build_projectile_bodies(scene& s, std::minstd_rand& r, std::size_t num_bodies)
+{
+    build_projectiles(s, r, num_bodies, false);
+}
+
+//------------------------------------------------------------------------------
+//! Same as `build_projectile_bodies` but projectiles are traced as segments.
+void build_projectile_segments(scene& s, std::minstd_rand& r, std::size_t num_bodies)
+{
+    build_projectiles(s, r, num_bodies, true);
+}
+
+//------------------------------------------------------------------------------
+//! Boxes packed edge to edge which jostle briefly and come to rest.
+void build_resting(scene& s, std::minstd_rand& r, std::size_t num_bodies)
+{
+    std::size_t columns = std::max<std::size_t>(1, std::size_t(std::sqrt(float(num_bodies))));
+    for (std::size_t ii = 0; ii < num_bodies; ++ii) {
+        vec2 position(float(ii % columns) * 16.f, float(ii / columns) * 16.f);
+        position -= vec2(float(columns) * 8.f, float(num_bodies / columns) * 8.f);
+        physics::rigid_body* body = s.add_box(vec2(16.f, 16.f), position);
+        body->set_linear_velocity(vec2(uniform(r, -4.f, 4.f), uniform(r, -4.f, 4.f)));
+    }
+    s.add_walls();
+}
+
+//------------------------------------------------------------------------------
+struct scenario
+{
+    char const* name;
+    void (*build)(scene& s, std::minstd_rand& r, std::size_t num_bodies);
+    std::size_t num_bodies;
+    int num_steps;
+    float damping; //!< fraction of velocity kept after each step
+};
+
+scenario const scenarios[] = {
+    {"random", build_random, 256, 200, 1.0f},
+    {"crowd", build_crowd, 256, 200, 1.0f},
+    {"polygons", build_polygons, 256, 200, 1.0f},
+    {"projectiles", build_projectile_bodies, 256, 200, 1.0f},
+    {"segments", build_projectile_segments, 256, 200, 1.0f},
+    {"resting", build_resting, 256, 200, 0.9f},
+};
+
+//------------------------------------------------------------------------------
+struct result
+{
+    std::size_t collisions; //!< number of collision callbacks
+    double checksum; //!< sum of final positions and rotations
+
+    double step_time; //!< seconds in world::step
+    double overlap_time; //!< seconds in world::generate_overlaps
+    double trace_time; //!< seconds tracing all overlapping pairs
+    double collide_time; //!< seconds colliding all overlapping pairs
+
+    std::size_t pairs; //!< overlapping pairs summed over all steps
+    std::size_t false_pairs; //!< overlapping pairs which did not collide
+    std::size_t culled_pairs; //!< false pairs rejected before running GJK
+    std::size_t gjk_iterations;
+    std::size_t epa_iterations;
+    std::size_t awake; //!< awake bodies after the final step
+};
+
+//------------------------------------------------------------------------------
+//! Move segment projectiles with a batched query, projectiles which hit a body
+//! are removed in the same way as projectiles in the game.
+void move_points(bench_world& world, scene& s, result& res)
+{
+    if (!s.points.size()) {
+        return;
+    }
+
+    std::vector<physics::world::segment> segments(s.points.size());
+    std::vector<physics::world::segment_hit> hits;
+    for (std::size_t ii = 0; ii < s.points.size(); ++ii) {
+        segments[ii] = {s.points[ii], s.points[ii] + s.point_velocities[ii] * delta_time};
+    }
+
+    world.trace_segments(segments, hits);
+
+    std::size_t count = 0;
+    for (std::size_t ii = 0; ii < s.points.size(); ++ii) {
+        if (hits[ii].body) {
+            ++res.collisions;
+            continue;
+        }
+        s.points[count] = segments[ii].end;
+        s.point_velocities[count] = s.point_velocities[ii];
+        ++count;
+    }
+    s.points.resize(count);
+    s.point_velocities.resize(count);
+}
+
+//------------------------------------------------------------------------------
+result run_scenario(scenario const& sc, std::size_t num_bodies, int num_steps)
+{
+    result res{};
+    scene s;
+    std::minstd_rand r;
+
+    sc.build(s, r, num_bodies);
+
+    // projectiles pass through each other as in the game
+    physics::material const* projectile_material = &s.projectile_material;
+    auto filter = [projectile_material](physics::rigid_body const* body_a, physics::rigid_body const* body_b) {
+        return body_a->get_material() != projectile_material
+            || body_b->get_material() != projectile_material;
+    };
+
+    auto collision = [&res](physics::rigid_body const*, physics::rigid_body const*, physics::collision const&) {
+        ++res.collisions;
+        return true;
+    };
+
+    bench_world world(filter, collision);
+    for (auto& body : s.bodies) {
+        world.add_body(body.get());
+    }
+
+    for (int step = 0; step < num_steps; ++step) {
+        // broadphase and narrowphase are timed separately on the state at the
+        // start of the step, without the pair cache used by `world::step`
+        auto t0 = bench::clock::now();
+        std::vector<bench_world::overlap> overlaps = world.generate_overlaps(delta_time);
+        auto t1 = bench::clock::now();
+
+        for (auto const& pair : overlaps) {
+            physics::trace tr(world.body(pair.first), world.body(pair.second), delta_time);
+            (void)tr;
+        }
+        auto t2 = bench::clock::now();
+
+        for (auto const& pair : overlaps) {
+            physics::collide c(world.body(pair.first)->get_motion(), world.body(pair.second)->get_motion());
+            (void)c;
+        }
+        auto t3 = bench::clock::now();
+
+        world.step(delta_time);
+        move_points(world, s, res);
+        auto t4 = bench::clock::now();
+
+        profile::end_frame();
+
+        res.overlap_time += seconds(t0, t1);
+        res.trace_time += seconds(t1, t2);
+        res.collide_time += seconds(t2, t3);
+        res.step_time += seconds(t3, t4);
+
+        physics::world::stats const& stats = world.get_stats();
+        res.pairs += stats.overlaps;
+        res.false_pairs += stats.false_overlaps;
+        res.culled_pairs += stats.culled_overlaps;
+        res.gjk_iterations += stats.gjk_iterations;
+        res.epa_iterations += stats.epa_iterations;
+        res.awake = stats.awake;
+
+        if (sc.damping < 1.f) {
+            for (auto& body : s.bodies) {
+                body->set_linear_velocity(body->get_linear_velocity() * sc.damping);
+                body->set_angular_velocity(body->get_angular_velocity() * sc.damping);
+            }
+        }
+    }
+
+    for (auto const& body : s.bodies) {
+        res.checksum += double(body->get_position().x) + double(body->get_position().y) + double(body->get_rotation());
+    }
+    for (auto const& point : s.points) {
+        res.checksum += double(point.x) + double(point.y);
+    }
+
+    return res;
+}
+
+//------------------------------------------------------------------------------
+scenario const* find_scenario(char const* name)
+{
+    for (auto const& sc : scenarios) {
+        if (strcmp(sc.name, name) == 0) {
+            return &sc;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+void print_header()
+{
+    printf("%-12s %6s %6s %10s %10s %10s %10s %10s %10s %10s %8s %8s %6s %10s %16s\n",
+           "scenario", "bodies", "steps", "step us", "overlap us", "trace ns", "collide ns",
+           "pairs", "false", "culled", "gjk", "epa", "awake", "collisions", "checksum");
+}
+
+//------------------------------------------------------------------------------
+void print_result(char const* name, std::size_t num_bodies, int num_steps, result const& res)
+{
+    double pairs = res.pairs ? double(res.pairs) : 1.0;
+
+    // times are per step, or per pair for the narrowphase, and iteration
+    // counts are per pair as measured inside `world::step`
+    printf("%-12s %6zu %6d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %8.2f %8.2f %6zu %10zu %16.6f\n",
+           name, num_bodies, num_steps,
+           res.step_time * 1e6 / num_steps,
+           res.overlap_time * 1e6 / num_steps,
+           res.trace_time * 1e9 / pairs,
+           res.collide_time * 1e9 / pairs,
+           double(res.pairs) / num_steps,
+           double(res.false_pairs) / num_steps,
+           double(res.culled_pairs) / num_steps,
+           double(res.gjk_iterations) / pairs,
+           double(res.epa_iterations) / pairs,
+           res.awake,
+           res.collisions,
+           res.checksum);
+}
+
+//------------------------------------------------------------------------------
+//! Run each scenario listed in the golden file with the same parameters and
+//! compare the results, returns false if any scenario does not match.
+bool check_golden(char const* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "could not open golden file '%s'\n", filename);
+        return false;
+    }
+
+    bool success = true;
+    int num_checked = 0;
+    char name[64];
+    std::size_t num_bodies, collisions;
+    int num_steps;
+    double checksum;
+
+    print_header();
+    while (fscanf(file, "%63s %zu %d %zu %lf", name, &num_bodies, &num_steps, &collisions, &checksum) == 5) {
+        scenario const* sc = find_scenario(name);
+        if (!sc) {
+            fprintf(stderr, "%s: unknown scenario\n", name);
+            success = false;
+            continue;
+        }
+
+        result res = run_scenario(*sc, num_bodies, num_steps);
+        print_result(name, num_bodies, num_steps, res);
+        ++num_checked;
+
+        if (res.collisions != collisions) {
+            fprintf(stderr, "%s: expected %zu collisions, got %zu\n", name, collisions, res.collisions);
+            success = false;
+        }
+        if (std::abs(res.checksum - checksum) > checksum_tolerance * std::max(1.0, std::abs(checksum))) {
+            fprintf(stderr, "%s: expected checksum %.6f, got %.6f\n", name, checksum, res.checksum);
+            success = false;
+        }
+    }
+
+    fclose(file);
+
+    if (!num_checked) {
+        fprintf(stderr, "no scenarios in golden file '%s'\n", filename);
+        return false;
+    }
+    return success;
+}
+
+//------------------------------------------------------------------------------
+bool write_golden(char const* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "could not open golden file '%s'\n", filename);
+        return false;
+    }
+
+    print_header();
+    for (auto const& sc : scenarios) {
+        result res = run_scenario(sc, sc.num_bodies, sc.num_steps);
+        print_result(sc.name, sc.num_bodies, sc.num_steps, res);
+        fprintf(file, "%s %zu %d %zu %.6f\n", sc.name, sc.num_bodies, sc.num_steps, res.collisions, res.checksum);
+    }
+
+    fclose(file);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! Print the zones of the final step and check that the capture was written
+//! and contains the zones of each phase of a step.
+bool check_profile(char const* filename)
+{
+    printf("\n%-24s %8s %10s\n", "zone", "count", "total us");
+    for (auto const& zone : profile::summary()) {
+        printf("%*s%-*s %8zu %10lld\n", int(zone.depth * 2), "", int(24 - zone.depth * 2), zone.name,
+               zone.count, static_cast<long long>(zone.total.to_microseconds()));
+    }
+
+    if (profile::capturing()) {
+        fprintf(stderr, "profile capture did not finish\n");
+        return false;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "could not open profile capture '%s'\n", filename);
+        return false;
+    }
+    std::string trace;
+    char buffer[4096];
+    for (std::size_t size; (size = fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+        trace.append(buffer, size);
+    }
+    fclose(file);
+
+    bool success = true;
+    for (char const* name : {"physics::world::step", "generate_overlaps",
+                             "generate_impacts", "trace_pairs", "collision_response",
+                             "integrate_bodies", "update_sleep"}) {
+        if (trace.find(std::string("\"") + name + "\"") == std::string::npos) {
+            fprintf(stderr, "profile capture is missing zone '%s'\n", name);
+            success = false;
+        }
+    }
+
+    if (profile::dropped()) {
+        fprintf(stderr, "profile capture dropped %zu zones\n", profile::dropped());
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+void print_usage()
+{
+    printf("usage: physics_bench [options]\n"
+           "  --scenario <name>      run a single scenario\n"
+           "  --bodies <count>       override the number of bodies\n"
+           "  --steps <count>        override the number of steps\n"
+           "  --threads <count>      run the narrowphase on <count> worker threads, 0 for all cores\n"
+           "  --golden <file>        compare results with golden output\n"
+           "  --write-golden <file>  write golden output for all scenarios\n"
+           "  --profile <file>       capture every step to a trace and fail if step zones are missing\n");
+    printf("scenarios:");
+    for (auto const& sc : scenarios) {
+        printf(" %s", sc.name);
+    }
+    printf("\n");
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    char const* scenario_name = nullptr;
+    char const* golden = nullptr;
+    char const* write = nullptr;
+    char const* profile_filename = nullptr;
+    std::size_t num_bodies = 0;
+    int num_steps = 0;
+    int num_threads = -1;
+
+    for (int ii = 1; ii < argc; ++ii) {
+        bool has_value = ii + 1 < argc;
+        if (strcmp(argv[ii], "--scenario") == 0 && has_value) {
+            scenario_name = argv[++ii];
+        } else if (strcmp(argv[ii], "--bodies") == 0 && has_value) {
+            num_bodies = std::strtoul(argv[++ii], nullptr, 10);
+        } else if (strcmp(argv[ii], "--steps") == 0 && has_value) {
+            num_steps = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--threads") == 0 && has_value) {
+            num_threads = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--golden") == 0 && has_value) {
+            golden = argv[++ii];
+        } else if (strcmp(argv[ii], "--write-golden") == 0 && has_value) {
+            write = argv[++ii];
+        } else if (strcmp(argv[ii], "--profile") == 0 && has_value) {
+            profile_filename = argv[++ii];
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    // the narrowphase runs on the calling thread unless a job system exists
+    std::unique_ptr<job::system> jobs;
+    if (num_threads >= 0) {
+        jobs = std::make_unique<job::system>();
+        jobs->init(num_threads);
+    }
+
+    if (golden) {
+        return check_golden(golden) ? EXIT_SUCCESS : EXIT_FAILURE;
+    } else if (write) {
+        return write_golden(write) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (profile_filename) {
+        std::size_t total_steps = 0;
+        for (auto const& sc : scenarios) {
+            if (!scenario_name || strcmp(sc.name, scenario_name) == 0) {
+                total_steps += num_steps ? num_steps : sc.num_steps;
+            }
+        }
+        profile::set_thread_name("main");
+        profile::capture(profile_filename, total_steps);
+    }
+
+    print_header();
+    for (auto const& sc : scenarios) {
+        if (scenario_name && strcmp(sc.name, scenario_name) != 0) {
+            continue;
+        }
+        std::size_t bodies = num_bodies ? num_bodies : sc.num_bodies;
+        int steps = num_steps ? num_steps : sc.num_steps;
+        print_result(sc.name, bodies, steps, run_scenario(sc, bodies, steps));
+    }
+
+    if (profile_filename) {
+        return check_profile(profile_filename) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+// software_bench.cpp
+//
+
+#include "bench_render.h"
+
+#include "cm_shared.h"
+#include "cm_job.h"
+#include "r_model.h"
+#include "r_particle.h"
+#include "r_software.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+using bench::add_explosion;
+using bench::frame_assets;
+using bench::frame_time;
+using bench::record_frame;
+using bench::seconds;
+using bench::tail_delay;
+using bench::tank_state;
+using bench::uniform;
+
+// the software backend draws text with a built-in font and ignores the font
+frame_assets const assets{&tank_body_model, &tank_turret_model, nullptr};
+
+//------------------------------------------------------------------------------
+bool near(color4 a, color4 b)
+{
+    constexpr float epsilon = 1e-4f;
+    return std::abs(a.r - b.r) < epsilon && std::abs(a.g - b.g) < epsilon
+        && std::abs(a.b - b.b) < epsilon && std::abs(a.a - b.a) < epsilon;
+}
+
+//------------------------------------------------------------------------------
+//! Render a known frame and return the number of failed checks.
+int check_frame(render::software_backend& backend, render::software_backend& reference)
+{
+    int errors = 0;
+    auto expect = [&errors](bool condition, char const* message) {
+        if (!condition) {
+            printf("check failed: %s\n", message);
+            ++errors;
+        }
+    };
+
+    color4 const tank_color(1, .5f, .25f, 1);
+    std::vector<tank_state> tanks = {{vec2(100, 100), 0, 0, tank_color}};
+
+    render::particle_store store;
+    render::particle p{};
+    p.position = vec2(300, 300);
+    p.size = 8.f;
+    p.color = color4(1, 1, 1, 1);
+    store.add(p);
+    store.update(time_value::zero, time_delta::zero);
+
+    render::particle_tessellator particles;
+    particles.tessellate(store, 1.f);
+
+    render::command_list commands;
+    record_frame(commands, assets, tanks, {}, particles);
+    commands.draw_line(vec2(100, 400.5f), vec2(200, 400.5f), color4(1,1,1,.5f), color4(1,1,1,.5f));
+
+    backend.execute(commands);
+    reference.execute(commands);
+
+    expect(near(backend.pixel(102, 106), tank_color * color4(.8f, .8f, .8f, 1)), "tank chassis");
+    expect(near(backend.pixel(100, 100), tank_color), "tank turret");
+    expect(near(backend.pixel(100, 125), color4(0, 1, 0, 1)), "status bar");
+    expect(near(backend.pixel(10, 470), color4(0, 0, 0, 0)), "background");
+    expect(backend.pixel(300, 300).a > 0.f, "particle");
+
+    bool line_covered = true;
+    for (int x = 100; x < 200; ++x) {
+        line_covered &= near(backend.pixel(x, 400), color4(.5f, .5f, .5f, .25f));
+        line_covered &= near(backend.pixel(x, 399), color4(0, 0, 0, 0));
+        line_covered &= near(backend.pixel(x, 401), color4(0, 0, 0, 0));
+    }
+    expect(line_covered, "line coverage");
+
+    int text_pixels = 0;
+    for (int y = 20; y < 32; ++y) {
+        for (int x = 510; x < 640; ++x) {
+            text_pixels += backend.pixel(x, y).a > 0.f;
+        }
+    }
+    expect(text_pixels > 0, "text");
+
+    bool identical = true;
+    for (int y = 0; y < backend.size().y; ++y) {
+        for (int x = 0; x < backend.size().x; ++x) {
+            color4 a = backend.pixel(x, y);
+            color4 b = reference.pixel(x, y);
+            identical &= memcmp(&a, &b, sizeof(color4)) == 0;
+        }
+    }
+    expect(identical, "single threaded and multithreaded output match");
+
+    // commands recorded between model draws keep their place in draw order
+    color4 const box_color(0, 0, 1, 1);
+    commands.clear();
+    commands.set_view(render::view{vec2(320, 240), vec2(640, 480), rect{}});
+    commands.draw_model(&tank_body_model, mat3::transform(vec2(100, 100), 0), color4(1, 1, 1, 1));
+    commands.draw_box(vec2(40, 40), vec2(100, 100), box_color);
+    commands.draw_model(&tank_body_model, mat3::transform(vec2(100, 100), 0), tank_color);
+    commands.draw_model(&tank_turret_model, mat3::transform(vec2(300, 100), 0), tank_color);
+    commands.draw_box(vec2(40, 40), vec2(300, 100), box_color);
+    backend.execute(commands);
+
+    expect(near(backend.pixel(102, 106), tank_color * color4(.8f, .8f, .8f, 1)), "model drawn over earlier box");
+    expect(near(backend.pixel(300, 100), box_color), "box drawn over earlier model");
+
+    return errors;
+}
+
+//------------------------------------------------------------------------------
+void print_usage()
+{
+    printf("usage: software_bench [options]\n"
+           "  --tanks <count>        number of tanks\n"
+           "  --frames <count>       number of frames to run\n"
+           "  --size <w> <h>         framebuffer size in pixels\n"
+           "  --threads <count>      number of worker threads, 0 for one per core\n"
+           "  --write <prefix>       write each frame to <prefix>0000.tga\n"
+           "  --check                fail if a known frame is not rendered correctly\n");
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    int num_tanks = 16;
+    int num_frames = 600;
+    int num_threads = 0;
+    vec2i size(640, 480);
+    char const* write_prefix = nullptr;
+    bool check = false;
+
+    for (int ii = 1; ii < argc; ++ii) {
+        bool has_value = ii + 1 < argc;
+        if (strcmp(argv[ii], "--tanks") == 0 && has_value) {
+            num_tanks = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--frames") == 0 && has_value) {
+            num_frames = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--size") == 0 && ii + 2 < argc) {
+            size.x = std::atoi(argv[++ii]);
+            size.y = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--threads") == 0 && has_value) {
+            num_threads = std::atoi(argv[++ii]);
+        } else if (strcmp(argv[ii], "--write") == 0 && has_value) {
+            write_prefix = argv[++ii];
+        } else if (strcmp(argv[ii], "--check") == 0) {
+            check = true;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    job::system jobs;
+    jobs.init(num_threads);
+
+    render::software_backend backend(&jobs);
+    backend.resize(size);
+
+    if (check) {
+        render::software_backend reference;
+        backend.resize(vec2i(640, 480));
+        reference.resize(vec2i(640, 480));
+        if (check_frame(backend, reference)) {
+            return EXIT_FAILURE;
+        }
+        backend.resize(size);
+    }
+
+    std::minstd_rand r(1);
+
+    std::vector<tank_state> tanks(num_tanks);
+    for (auto& t : tanks) {
+        t = {vec2(uniform(r, 40.f, 600.f), uniform(r, 40.f, 440.f)),
+             uniform(r, 0.f, 6.f), uniform(r, 0.f, 6.f),
+             color4(uniform(r, 0.f, 1.f), uniform(r, 0.f, 1.f), uniform(r, 0.f, 1.f), 1)};
+    }
+
+    std::vector<vec2> projectiles(num_tanks * 4);
+    std::vector<render::particle> spawned;
+
+    render::particle_store store;
+    render::particle_tessellator particles;
+    render::command_list commands;
+
+    double render_time = 0;
+    time_value time = time_value::zero;
+
+    for (int frame = 0; frame < num_frames; ++frame) {
+        time += frame_time;
+        if (frame % 30 == 0) {
+            spawned.clear();
+            add_explosion(spawned, r, time, vec2(uniform(r, 0.f, 640.f), uniform(r, 0.f, 480.f)));
+            for (auto const& p : spawned) {
+                store.add(p);
+            }
+        }
+        for (auto& t : tanks) {
+            t.angle += .01f;
+            t.turret_angle -= .02f;
+            t.position += vec2(std::cos(t.angle), std::sin(t.angle));
+        }
+        for (auto& p : projectiles) {
+            p = vec2(uniform(r, 0.f, 640.f), uniform(r, 0.f, 480.f));
+        }
+
+        store.update(time, tail_delay);
+        particles.tessellate(store, float(size.y) / 480.f);
+        record_frame(commands, assets, tanks, projectiles, particles);
+
+        auto t0 = bench::clock::now();
+        backend.execute(commands);
+        auto t1 = bench::clock::now();
+        render_time += seconds(t0, t1);
+
+        if (write_prefix) {
+            std::string filename = write_prefix + std::to_string(10000 + frame).substr(1) + ".tga";
+            if (backend.write_image(filename.c_str()) != result::success) {
+                printf("failed to write %s\n", filename.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    double ms = render_time * 1e3 / std::max(num_frames, 1);
+    printf("%6s %6s %11s %8s %10s %10s\n",
+           "tanks", "frames", "size", "threads", "render ms", "realtime");
+    printf("%6d %6d %5dx%-5d %8zu %10.2f %9.1fx\n",
+           num_tanks, num_frames, size.x, size.y, jobs.num_threads(),
+           ms, ms > 0 ? frame_time.to_seconds() * 1e3 / ms : 0.0);
+
+    return EXIT_SUCCESS;
+}
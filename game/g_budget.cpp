@@ -0,0 +1,151 @@
+// g_budget.cpp
+//
+
+#include "precompiled.h"
+#pragma hdrstop
+
+#include "g_budget.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace game {
+
+//------------------------------------------------------------------------------
+char const* degradation_name(degradation level)
+{
+    switch (level) {
+        case degradation::none: return "none";
+        case degradation::cosmetic_effects: return "no cosmetic effects";
+        case degradation::sounds: return "no sounds";
+        case degradation::snapshot_rate: return "reduced snapshot rate";
+        case degradation::projectile_limit: return "projectile limit";
+        default: return "unknown";
+    }
+}
+
+//------------------------------------------------------------------------------
+tick_budget::tick_budget()
+    : _sv_tick_budget("sv_tickBudget", 25, config::archive|config::server, "server tick budget in milliseconds, 0 to disable degradation")
+    , _sv_slow_client("sv_slowClient", 150, config::archive|config::server, "latency in milliseconds above which clients are sent fewer snapshots when degraded")
+    , _sv_max_projectiles("sv_maxProjectiles", 32, config::archive|config::server, "maximum number of projectiles when degraded")
+{
+    reset();
+}
+
+//------------------------------------------------------------------------------
+void tick_budget::reset()
+{
+    _level = degradation::none;
+    _reported_level = degradation::none;
+    _stats = {};
+    _tick_start = time_value::zero;
+    _change_average = time_delta::zero;
+    _change_overruns = 0;
+    _window_ticks = 0;
+    _window_overruns = 0;
+    _window_time = time_delta::zero;
+}
+
+//------------------------------------------------------------------------------
+void tick_budget::begin_tick()
+{
+    _tick_start = time_value::current();
+}
+
+//------------------------------------------------------------------------------
+void tick_budget::end_tick()
+{
+    time_delta duration = time_value::current() - _tick_start;
+    time_delta budget = time_delta::from_milliseconds(std::max<int>(0, _sv_tick_budget));
+
+    ++_stats.ticks;
+    _stats.last_tick = duration;
+    _stats.max_tick = std::max(_stats.max_tick, duration);
+    if (_level != degradation::none) {
+        ++_stats.degraded;
+    }
+
+    if (budget == time_delta::zero) {
+        // degradation is disabled, drop back to full quality immediately
+        if (_level != degradation::none) {
+            _level = degradation::none;
+            _change_average = time_delta::zero;
+            _change_overruns = 0;
+            ++_stats.changes;
+        }
+        _window_ticks = 0;
+        _window_overruns = 0;
+        _window_time = time_delta::zero;
+        return;
+    }
+
+    if (duration > budget) {
+        ++_stats.overruns;
+        ++_window_overruns;
+    }
+    ++_window_ticks;
+    _window_time += duration;
+
+    if (_window_ticks < window_size) {
+        return;
+    }
+
+    time_delta average = _window_time / double(_window_ticks);
+
+    if (_window_overruns * 2 >= _window_ticks && _level != degradation::projectile_limit) {
+        _level = static_cast<degradation>(static_cast<int>(_level) + 1);
+        _change_average = average;
+        _change_overruns = _window_overruns;
+        ++_stats.changes;
+    } else if (!_window_overruns && average < budget * recover_fraction && _level != degradation::none) {
+        _level = static_cast<degradation>(static_cast<int>(_level) - 1);
+        _change_average = average;
+        _change_overruns = 0;
+        ++_stats.changes;
+    }
+
+    _window_ticks = 0;
+    _window_overruns = 0;
+    _window_time = time_delta::zero;
+}
+
+//------------------------------------------------------------------------------
+void tick_budget::report(string::view name)
+{
+    if (_level == _reported_level) {
+        return;
+    }
+
+    if (_level > _reported_level) {
+        log::warning("%s: %zu of %zu ticks overran the %d ms budget, degrading to '%s'.\n",
+                     name.c_str(), _change_overruns, window_size, static_cast<int>(_sv_tick_budget),
+                     degradation_name(_level));
+    } else {
+        log::message("%s: average tick took %lld ms, recovering to '%s'.\n",
+                     name.c_str(), _change_average.to_milliseconds(), degradation_name(_level));
+    }
+
+    _reported_level = _level;
+}
+
+//------------------------------------------------------------------------------
+void tick_budget::apply(game::world& world) const
+{
+    world.set_dropped_events(_level >= degradation::cosmetic_effects,
+                             _level >= degradation::sounds);
+    world.set_projectile_limit(_level >= degradation::projectile_limit
+        ? static_cast<std::size_t>(std::max<int>(1, _sv_max_projectiles)) : 0);
+}
+
+//------------------------------------------------------------------------------
+bool tick_budget::send_snapshot(time_delta latency, int framenum) const
+{
+    if (_level < degradation::snapshot_rate) {
+        return true;
+    }
+    // slow clients are sent snapshots on even frames only
+    return latency <= time_delta::from_milliseconds(_sv_slow_client) || !(framenum & 1);
+}
+
+} // namespace game
@@ -0,0 +1,94 @@
+// g_budget.h
+//
+
+#pragma once
+
+#include "cm_config.h"
+#include "cm_string.h"
+#include "cm_time.h"
+
+////////////////////////////////////////////////////////////////////////////////
+namespace game {
+
+class world;
+
+//------------------------------------------------------------------------------
+//! Degradation applied by the server under sustained overload, each level also
+//! applies every level before it.
+enum class degradation
+{
+    none,
+    cosmetic_effects, //!< cosmetic effects are not sent to clients
+    sounds, //!< sounds are not sent to clients
+    snapshot_rate, //!< slow clients are only sent object state every other frame
+    projectile_limit, //!< new projectiles are not launched above a limit
+};
+
+//! display name of a degradation level
+char const* degradation_name(degradation level);
+
+//------------------------------------------------------------------------------
+//! Measures the time spent on each server tick against a configurable budget.
+//! Ticks are evaluated in windows of `window_size` ticks. Degradation is raised
+//! one level after a window in which at least half of the ticks overran, and is
+//! lowered one level after a window without overruns whose average tick used
+//! less than `recover_fraction` of the budget.
+class tick_budget
+{
+public:
+    //! Tick counts since the budget was reset
+    struct stats {
+        std::size_t ticks;
+        std::size_t overruns; //!< ticks which took longer than the budget
+        std::size_t degraded; //!< ticks run with any degradation applied
+        std::size_t changes; //!< number of times the degradation level changed
+        time_delta last_tick;
+        time_delta max_tick;
+    };
+
+    //! number of ticks evaluated before the degradation level can change
+    static constexpr std::size_t window_size = 20;
+    //! fraction of the budget the average tick must stay under to recover
+    static constexpr float recover_fraction = 0.75f;
+
+public:
+    tick_budget();
+
+    void reset();
+
+    void begin_tick();
+    void end_tick();
+
+    //! log any changes to the degradation level since the previous call, this
+    //! is separate from `end_tick` so that ticks can run on worker threads
+    void report(string::view name);
+
+    degradation level() const { return _level; }
+    stats const& get_stats() const { return _stats; }
+
+    //! configure the world for the current degradation level
+    void apply(game::world& world) const;
+
+    //! returns true if the full snapshot for the given frame should be sent to
+    //! a client with the given latency, otherwise only its events are sent
+    bool send_snapshot(time_delta latency, int framenum) const;
+
+protected:
+    config::integer _sv_tick_budget;
+    config::integer _sv_slow_client;
+    config::integer _sv_max_projectiles;
+
+    degradation _level;
+    degradation _reported_level; //!< level when `report` was last called
+
+    stats _stats;
+    time_value _tick_start;
+    time_delta _change_average; //!< average tick of the window which changed the level
+    std::size_t _change_overruns; //!< overruns in the window which changed the level
+
+    std::size_t _window_ticks;
+    std::size_t _window_overruns;
+    time_delta _window_time;
+};
+
+} // namespace game
@@ -93,6 +93,8 @@ void session::client_connectionless(network::address const& remote, network::mes
 
     if (message_string.starts_with("info")) {
         info_get(remote, message_string);
+    } else if (message_string.starts_with("challenge")) {
+        challenge_ack(message_string);
     } else if (message_string.starts_with("connect")) {
         connect_ack(message_string);
     } else if (message_string.starts_with("fail")) {
@@ -132,6 +134,10 @@ void session::client_packet(network::message& message)
                 _restart_time = _frametime + time_delta::from_seconds(message.read_byte() * 1.0f);
                 break;
 
+            case svc_pong:
+                read_pong(message);
+                break;
+
             default:
                 return;
         }
@@ -142,9 +148,11 @@ void session::client_packet(network::message& message)
 void session::read_snapshot(network::message& message)
 {
     _world.read_snapshot(message);
-    // gradually adjust client world time to match server
-    // to compensate for variability in packet delivery
-    _worldtime += (_world.frametime() - _worldtime) * 0.1f;
+    if (!cls.clock.synchronized()) {
+        // gradually adjust client world time to match server
+        // until the clock has been synchronized
+        _worldtime += (_world.frametime() - _worldtime) * 0.1f;
+    }
     _net_bytes[++_framenum % _net_bytes.size()] = 0;
 }
 
@@ -168,7 +176,8 @@ void session::connect_to_server (int index)
     if ( !_netserver.port )
         _netserver.port = PORT_SERVER;
 
-    cls.socket.printf(_netserver, "connect %i %s %i", PROTOCOL_VERSION, cls.info.name.data(), _netchan.netport());
+    // request a challenge, the connect request is sent by challenge_ack
+    cls.socket.printf(_netserver, "getchallenge");
 }
 
 //------------------------------------------------------------------------------
@@ -193,7 +202,23 @@ void session::connect_to_server (string::view address)
     if ( !_netserver.port )
         _netserver.port = PORT_SERVER;
 
-    cls.socket.printf(_netserver, "connect %i %s %i", PROTOCOL_VERSION, cls.info.name.data(), _netchan.netport());
+    // request a challenge, the connect request is sent by challenge_ack
+    cls.socket.printf(_netserver, "getchallenge");
+}
+
+//------------------------------------------------------------------------------
+void session::challenge_ack(string::view message_string)
+{
+    // server has sent a challenge in response to getchallenge
+
+    if (cls.active) {
+        return;
+    }
+
+    int challenge = -1;
+    sscanf(message_string, "challenge %i", &challenge);
+
+    cls.socket.printf(_netserver, "connect %i %i %s %i", PROTOCOL_VERSION, challenge, cls.info.name.data(), _netchan.netport());
 }
 
 //------------------------------------------------------------------------------
@@ -216,6 +241,10 @@ void session::connect_ack(string::view message_string)
     _clients[cls.number].speed_mod = 1.0f;
 
     _clients[0].usercmd_time = time_value::zero;
+    _clients[0].usercmd_sequence = 0;
+
+    cls.clock.reset();
+    cls.clock_time = time_value::zero;
 
     svs.clients[cls.number].active = true;
     svs.clients[cls.number].info.name, cls.info.name;
@@ -228,17 +257,39 @@ void session::connect_ack(string::view message_string)
 //------------------------------------------------------------------------------
 void session::client_send ()
 {
+    // send clock sync request, the response is handled by read_pong
+    if (cls.clock_time == time_value::zero || _frametime - cls.clock_time >= cls.clock_rate) {
+        cls.clock_time = _frametime;
+
+        _netchan.write_byte(clc_ping);
+        _netchan.write_time(time_value::current());
+        // total latency between the client's view of the world and the
+        // server receiving commands issued in response to that view
+        time_delta latency = view_delay() + cls.clock.round_trip() / 2.0;
+        _netchan.write_long(static_cast<int>(latency.to_microseconds()));
+    }
+
     if (_frametime - _clients[0].usercmd_time < _clients[0].usercmd_rate) {
         return;
     }
 
-    game::usercmd cmd = _clients[0].input.generate();
+    constexpr int backup = game_client_t::usercmd_backup;
+
+    int sequence = _clients[0].usercmd_sequence++;
+    _clients[0].usercmd_history[sequence % backup] = _clients[0].input.generate();
     _clients[0].usercmd_time = _frametime;
 
+    // send previous commands redundantly so the server can recover
+    // commands from lost packets without needing retransmission
+    int count = std::min(sequence + 1, backup);
+
     _netchan.write_byte(clc_command);
-    _netchan.write_vector(cmd.move);
-    _netchan.write_vector(cmd.look);
-    _netchan.write_byte(narrow_cast<uint8_t>(cmd.action));
+    _netchan.write_long(sequence);
+    _netchan.write_byte(count);
+    for (int ii = 0; ii < count; ++ii) {
+        _clients[0].usercmd_history[(sequence - ii) % backup].write(_netchan);
+    }
+    _netchan.write_align();
 
     // check if user info has been changed
     if (!_menu_active) {
@@ -254,6 +305,26 @@ void session::client_send ()
     }
 }
 
+//------------------------------------------------------------------------------
+void session::read_pong(network::message& message)
+{
+    time_value t0 = message.read_time();
+    time_value t1 = message.read_time();
+    time_value t2 = message.read_time();
+    time_value t3 = time_value::current();
+
+    cls.clock.add_sample(t0, t1, t2, t3);
+}
+
+//------------------------------------------------------------------------------
+time_delta session::view_delay() const
+{
+    // snapshots arrive one-way trip time after they were sent by the server.
+    // objects draw the frame following their snapshot time as a blend from
+    // the previous snapshot, so the interpolation needs no extra delay here
+    return cls.clock.round_trip() / 2.0 + time_delta::from_milliseconds(_cl_time_nudge);
+}
+
 //------------------------------------------------------------------------------
 void session::info_ask ()
 {
@@ -0,0 +1,701 @@
+// g_match.cpp
+//
+
+#include "precompiled.h"
+#pragma hdrstop
+
+#include "g_match.h"
+#include "g_tank.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace game {
+
+//------------------------------------------------------------------------------
+match::match(network::socket* socket)
+    : _socket(socket)
+    , _worldtime(time_value::zero)
+    , _start_time(time_value::zero)
+    , _num_skipped(0)
+    , _clients{}
+    , _game_clients{}
+    , _score{}
+    , _upgrade_frac("g_upgradeFrac", 0.5f, config::archive|config::server, "upgrade fraction")
+    , _upgrade_penalty("g_upgradePenalty", 0.2f, config::archive|config::server, "upgrade penalty")
+    , _upgrade_min("g_upgradeMin", 0.2f, config::archive|config::server, "minimum upgrade fraction")
+    , _upgrades("g_upgrades", true, config::archive|config::server, "enable upgrades")
+    , _sv_max_unlag("sv_maxUnlag", 200, config::archive|config::server, "maximum lag compensation for remote players in milliseconds")
+{
+}
+
+//------------------------------------------------------------------------------
+match::~match()
+{
+    stop();
+}
+
+//------------------------------------------------------------------------------
+void match::start(time_value time)
+{
+    _world.init(this, true);
+    _worldtime = time_value::zero;
+    _start_time = time;
+    _num_skipped = 0;
+    _budget.reset();
+
+    for (std::size_t ii = 0; ii < _clients.size(); ++ii) {
+        _clients[ii].active = false;
+        _clients[ii].local = false;
+        _score[ii] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+void match::stop()
+{
+    for (std::size_t ii = 0; ii < _clients.size(); ++ii) {
+        if (!_clients[ii].active) {
+            continue;
+        }
+
+        _clients[ii].netchan.reset();
+        _clients[ii].netchan.write_byte(svc_disconnect);
+        _clients[ii].netchan.transmit();
+        _clients[ii].netchan.reset();
+        _clients[ii].active = false;
+    }
+
+    _world.shutdown();
+}
+
+//------------------------------------------------------------------------------
+std::size_t match::num_clients() const
+{
+    return std::count_if(_clients.begin(), _clients.end(),
+        [](client_t const& cl) { return cl.active; });
+}
+
+//------------------------------------------------------------------------------
+int match::find_client(network::address const& remote, int netport) const
+{
+    for (std::size_t ii = 0; ii < _clients.size(); ++ii) {
+        if (_clients[ii].active
+                && _clients[ii].netchan.address() == remote
+                && _clients[ii].netchan.netport() == netport) {
+            return static_cast<int>(ii);
+        }
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+int match::client_connect(network::address const& remote, int netport, string::view name)
+{
+    for (std::size_t ii = 0; ii < _clients.size(); ++ii) {
+        auto& cl = _clients[ii];
+        if (cl.active) {
+            continue;
+        }
+
+        cl.active = true;
+        cl.local = false;
+        strncpy(cl.info.name.data(), name.c_str(), cl.info.name.size() - 1);
+        cl.info.name.back() = '\0';
+        cl.info.color = player_colors[ii % num_player_colors];
+        cl.info.weapon = weapon_type::cannon;
+        cl.netchan.setup(_socket, remote, narrow_cast<word>(netport));
+        cl.usercmds.reset();
+        cl.latency = time_delta::zero;
+        _game_clients[ii].unlag = time_delta::zero;
+
+        _socket->printf(cl.netchan.address(), "connect %zu %lld", ii, _worldtime.to_microseconds());
+
+        spawn_player(ii);
+
+        write_message(va("%s connected.", cl.info.name.data()));
+
+        // broadcast information about all clients including the new client
+        network::message_storage message;
+        for (std::size_t jj = 0; jj < _clients.size(); ++jj) {
+            if (jj != ii) {
+                write_info(cl.netchan, jj);
+            }
+        }
+        write_info(message, ii);
+        broadcast(message);
+
+        return static_cast<int>(ii);
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+void match::client_disconnect(std::size_t client)
+{
+    network::message_storage message;
+
+    if (!_clients[client].active) {
+        return;
+    }
+
+    _world.remove_player(client);
+    _clients[client].active = false;
+
+    write_info(message, client);
+    broadcast(message);
+}
+
+//------------------------------------------------------------------------------
+void match::spawn_player(std::size_t client)
+{
+    assert(_world.player(client) == nullptr);
+    game::tank* player = _world.spawn_player(client);
+    player->_color = color4(_clients[client].info.color);
+    player->_weapon = _clients[client].info.weapon;
+    player->_client = _game_clients + client;
+
+    player->respawn();
+
+    _score[client] = 0;
+
+    _game_clients[client].armor_mod = 1.0f;
+    _game_clients[client].damage_mod = 1.0f;
+    _game_clients[client].refire_mod = 1.0f;
+    _game_clients[client].speed_mod = 1.0f;
+    _game_clients[client].upgrades = 0;
+}
+
+//------------------------------------------------------------------------------
+void match::client_packet(network::message& message, std::size_t client)
+{
+    _clients[client].netchan.process(message);
+
+    while (message.bytes_remaining()) {
+        switch (message.read_byte()) {
+            case clc_command:
+                read_client_command(message, _clients[client]);
+                break;
+
+            case clc_disconnect:
+                write_message(va("%s disconnected.", _clients[client].info.name.data()));
+                client_disconnect(client);
+                return;
+
+            case clc_say:
+                write_message(va( "^%x%x%x%s^xxx: %s",
+                    (int )(_clients[client].info.color.r * 15.5f),
+                    (int )(_clients[client].info.color.g * 15.5f),
+                    (int )(_clients[client].info.color.b * 15.5f),
+                    _clients[client].info.name.data(), message.read_string()));
+                break;
+
+            case clc_upgrade:
+                read_upgrade(client, message.read_byte());
+                break;
+
+            case clc_ping:
+                read_client_ping(message, _clients[client], _game_clients[client], _worldtime, time_delta::from_milliseconds(_sv_max_unlag));
+                break;
+
+            case svc_info: {
+                network::message_storage netmsg;
+
+                read_client_info(message, _clients[client], _world.player(client));
+                write_info(netmsg, client);
+                broadcast(netmsg);
+                break;
+            }
+
+            default:
+                return;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void match::read_upgrade(std::size_t client, int upgrade)
+{
+    if (read_client_upgrade(this, _clients[client], _game_clients[client], upgrade, _upgrade_frac, _upgrade_penalty, _upgrade_min)) {
+        network::message_storage netmsg;
+
+        write_info(netmsg, client);
+        broadcast(netmsg);
+    }
+}
+
+//------------------------------------------------------------------------------
+void match::write_info(network::message& message, std::size_t client)
+{
+    write_client_info(message, client, _clients[client], _game_clients[client], _score[client]);
+}
+
+//------------------------------------------------------------------------------
+void match::check_timeouts(time_value time)
+{
+    constexpr time_delta timeout = time_delta::from_seconds(10);
+
+    for (std::size_t ii = 0; ii < _clients.size(); ++ii) {
+        if (!_clients[ii].active) {
+            continue;
+        }
+
+        if (_clients[ii].netchan.last_received() + timeout < time) {
+            _clients[ii].netchan.write_byte(svc_disconnect);
+            _clients[ii].netchan.transmit();
+            _clients[ii].netchan.reset();
+
+            write_message(va("%s timed out.", _clients[ii].info.name.data()));
+            client_disconnect(ii);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void match::set_time(time_value time)
+{
+    // frames are due at fixed offsets from the start time so that late
+    // frames do not delay the schedule of subsequent frames
+    time_delta lag = time - next_frame_time();
+    if (lag > max_frame_lag) {
+        _start_time += lag;
+        ++_num_skipped;
+    }
+
+    _worldtime = time_value(time - _start_time);
+}
+
+//------------------------------------------------------------------------------
+void match::run_frame()
+{
+    _budget.begin_tick();
+    _budget.apply(_world);
+
+    // apply exactly one buffered command per frame to each player
+    for (std::size_t ii = 0; ii < _clients.size(); ++ii) {
+        if (!_clients[ii].active) {
+            continue;
+        }
+
+        game::usercmd cmd;
+        game::tank* player = _world.player(ii);
+        if (player && _clients[ii].usercmds.next(cmd)) {
+            player->update_usercmd(cmd);
+        }
+    }
+
+    _world.run_frame();
+
+    network::message_storage message;
+    network::message_storage events;
+    _world.write_snapshot(message, events);
+
+    std::size_t length = message.bytes_remaining();
+    byte const* data = message.read(length);
+    std::size_t events_length = events.bytes_remaining();
+    byte const* events_data = events.read(events_length);
+
+    // slow clients may skip object state when the match is over budget but
+    // are always sent sounds and effects
+    for (auto& cl : _clients) {
+        if (!cl.active) {
+            continue;
+        } else if (_budget.send_snapshot(cl.latency, _world.framenum())) {
+            cl.netchan.write(data, length);
+        } else {
+            cl.netchan.write(events_data, events_length);
+        }
+    }
+
+    for (auto& cl : _clients) {
+        if (!cl.active || !cl.netchan.bytes_remaining()) {
+            continue;
+        }
+
+        cl.netchan.transmit();
+        cl.netchan.reset();
+    }
+
+    _budget.end_tick();
+}
+
+//------------------------------------------------------------------------------
+void match::add_score(std::size_t player_index, int score)
+{
+    player_index = clamp<std::size_t>(player_index, 0, MAX_PLAYERS - 1);
+
+    _score[player_index] += score;
+
+    if (_score[player_index] % 10 == 0 && _upgrades) {
+        _game_clients[player_index].upgrades++;
+    }
+
+    network::message_storage netmsg;
+    write_info(netmsg, player_index);
+    broadcast(netmsg);
+}
+
+//------------------------------------------------------------------------------
+void match::write_message(string::view message, bool broadcast)
+{
+    if (broadcast) {
+        network::message_storage netmsg;
+        netmsg.write_byte(svc_message);
+        netmsg.write_string(message.c_str());
+        this->broadcast(netmsg);
+    }
+}
+
+//------------------------------------------------------------------------------
+void match::broadcast(network::message& message)
+{
+    std::size_t length = message.bytes_remaining();
+    byte const* data = message.read(length);
+
+    for (auto& cl : _clients) {
+        if (cl.active) {
+            cl.netchan.write(data, length);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+match_server::match_server()
+    : _name{}
+    , _next(0)
+    , _finished(0)
+    , _generation(0)
+    , _exit(false)
+    , _num_frames(0)
+    , _num_overruns(0)
+    , _max_overrun(time_delta::zero)
+    , _overrun_time(time_value::zero)
+{
+}
+
+//------------------------------------------------------------------------------
+match_server::~match_server()
+{
+    stop();
+}
+
+//------------------------------------------------------------------------------
+result match_server::start(string::view name, int num_matches, int num_threads)
+{
+    stop();
+
+    strncpy(_name, name.c_str(), countof(_name) - 1);
+
+    if (!_socket.open(network::socket_type::ipv6, PORT_SERVER)) {
+        log::error("Failed to open server socket.\n");
+        return result::failure;
+    }
+    _filter.reset();
+
+    _num_frames = 0;
+    _num_overruns = 0;
+    _max_overrun = time_delta::zero;
+    _overrun_time = time_value::zero;
+
+    time_value time = time_value::current();
+    num_matches = std::max(1, num_matches);
+    for (int ii = 0; ii < num_matches; ++ii) {
+        _matches.push_back(std::make_unique<match>(&_socket));
+        _matches.back()->start(time);
+    }
+
+    // leave one hardware thread for the main thread by default
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+    num_threads = clamp(num_threads, 1, num_matches);
+
+    _exit = false;
+    for (int ii = 0; ii < num_threads; ++ii) {
+        _threads.emplace_back(&match_server::worker_thread, this);
+    }
+
+    log::message("Hosting %d matches on %d threads.\n", num_matches, num_threads);
+    return result::success;
+}
+
+//------------------------------------------------------------------------------
+void match_server::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _exit = true;
+    }
+    _start_condition.notify_all();
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+
+    // matches disconnect their clients when destroyed
+    _matches.clear();
+    _pending.clear();
+
+    _socket.close();
+}
+
+//------------------------------------------------------------------------------
+bool match_server::wait_frame() const
+{
+    if (!_matches.size()) {
+        return false;
+    }
+
+    time_value deadline = time_value::max;
+    for (auto const& m : _matches) {
+        deadline = std::min(deadline, m->next_frame_time());
+    }
+
+    time_value time = time_value::current();
+    if (deadline > time) {
+        _socket.wait(deadline - time);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void match_server::run_frame()
+{
+    // network uses application time directly so do the same here
+    time_value time = time_value::current();
+    for (auto& m : _matches) {
+        m->set_time(time);
+    }
+
+    get_packets();
+
+    for (auto& m : _matches) {
+        m->check_timeouts(time);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    time_value deadline = time_value::max;
+
+    _pending.clear();
+    for (auto& m : _matches) {
+        if (m->frame_due()) {
+            deadline = std::min(deadline, m->next_frame_time());
+            _pending.push_back(m.get());
+        }
+    }
+
+    if (!_pending.size()) {
+        return;
+    }
+
+    _next = 0;
+    _finished = 0;
+    ++_generation;
+
+    _start_condition.notify_all();
+    _finish_condition.wait(lock, [this]() { return _finished == _pending.size(); });
+
+    ++_num_frames;
+
+    // frames overrun if they finish after the following frame was due
+    time = time_value::current();
+    time_delta overrun = time - (deadline + FRAMETIME);
+    if (overrun > time_delta::zero) {
+        ++_num_overruns;
+        _max_overrun = std::max(_max_overrun, overrun);
+
+        if (time > _overrun_time + overrun_report_rate) {
+            log::warning("Server frame overran by %lld ms, %zu of %zu frames overran.\n",
+                         overrun.to_milliseconds(), _num_overruns, _num_frames);
+            _overrun_time = time;
+        }
+    }
+
+    // log degradation changes here since frames run on worker threads
+    for (std::size_t ii = 0; ii < _matches.size(); ++ii) {
+        _matches[ii]->budget().report(va("Match %zu", ii));
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::worker_thread()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t generation = _generation;
+
+    while (true) {
+        _start_condition.wait(lock, [&]() { return _exit || _generation != generation; });
+        if (_exit) {
+            return;
+        }
+
+        generation = _generation;
+
+        while (_next < _pending.size()) {
+            match* m = _pending[_next++];
+
+            lock.unlock();
+            m->run_frame();
+            lock.lock();
+
+            if (++_finished == _pending.size()) {
+                _finish_condition.notify_one();
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::get_packets()
+{
+    network::message_storage message;
+    network::address remote;
+
+    while (_socket.read(remote, message)) {
+        int prefix = message.read_long();
+        if (prefix != network::channel::prefix) {
+            message.rewind();
+            connectionless(remote, message);
+            message.reset();
+            continue;
+        }
+
+        int netport = (word )message.read_short();
+
+        // route the packet to the match which owns the connection
+        for (auto& m : _matches) {
+            int client = m->find_client(remote, netport);
+            if (client < 0) {
+                continue;
+            }
+
+            m->client_packet(message, client);
+            break;
+        }
+
+        message.reset();
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::connectionless(network::address const& remote, network::message& message)
+{
+    // drop requests from addresses that are sending too quickly before doing
+    // any work to parse the request
+    if (!_filter.accept(remote, time_value::current())) {
+        return;
+    }
+
+    string::view message_string(message.read_string());
+
+    if (message_string.starts_with("info")) {
+        info_send(remote);
+    } else if (message_string.starts_with("getchallenge")) {
+        challenge_send(remote);
+    } else if (message_string.starts_with("connect")) {
+        client_connect(remote, message_string);
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::info_send(network::address const& remote)
+{
+    // only advertise if any match has an empty slot
+    for (auto const& m : _matches) {
+        if (m->num_clients() < MAX_PLAYERS) {
+            if (_filter.respond(time_value::current())) {
+                _socket.printf(remote, "info %s", _name);
+            }
+            return;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::challenge_send(network::address const& remote)
+{
+    time_value time = time_value::current();
+    if (_filter.respond(time)) {
+        _socket.printf(remote, "challenge %i", _filter.challenge(remote, time));
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::client_connect(network::address const& remote, string::view message_string)
+{
+    int version = 0, challenge = -1, netport = 0;
+    char name[64] = {};
+    time_value time = time_value::current();
+
+    sscanf(message_string, "connect %i %i %63s %i", &version, &challenge, name, &netport);
+
+    if (version != PROTOCOL_VERSION) {
+        if (_filter.respond(time)) {
+            _socket.printf(remote, "fail \"Bad protocol version: %i\"", version);
+        }
+        return;
+    }
+
+    // ignore requests that do not echo a recent challenge, the source
+    // address of these requests has not been verified so do not respond
+    if (!_filter.check_challenge(remote, challenge, time)) {
+        return;
+    }
+
+    // ensure that this client hasn't already connected
+    for (auto const& m : _matches) {
+        if (m->find_client(remote, netport) >= 0) {
+            return;
+        }
+    }
+
+    // fill matches in order so that players are not spread thinly
+    for (auto& m : _matches) {
+        if (m->client_connect(remote, netport, name) >= 0) {
+            return;
+        }
+    }
+
+    if (_filter.respond(time)) {
+        _socket.printf(remote, "fail \"Server is full\"");
+    }
+}
+
+//------------------------------------------------------------------------------
+void match_server::print_status() const
+{
+    for (std::size_t ii = 0; ii < _matches.size(); ++ii) {
+        auto const& m = _matches[ii];
+        log::message("match %zu: %zu clients, frame %d, %zu skips\n", ii, m->num_clients(), m->framenum(), m->num_skipped());
+        auto const& tick_stats = m->budget().get_stats();
+        log::message("  ticks: %zu run, %zu overruns, %zu degraded, %lld ms max, degradation '%s', %zu events dropped\n",
+                     tick_stats.ticks, tick_stats.overruns, tick_stats.degraded, tick_stats.max_tick.to_milliseconds(),
+                     degradation_name(m->budget().level()), m->num_dropped_events());
+        auto const& physics_stats = m->physics_stats();
+        log::message("  bodies: %zu awake, %zu sleeping, %zu static\n",
+                     physics_stats.awake, physics_stats.sleeping, physics_stats.static_bodies);
+        log::message("  pairs: %zu overlapping, %zu false, %zu culled, %zu warm started, %zu gjk iterations\n",
+                     physics_stats.overlaps, physics_stats.false_overlaps, physics_stats.culled_overlaps,
+                     physics_stats.warm_started, physics_stats.gjk_iterations);
+
+        auto const& clients = m->clients();
+        for (std::size_t jj = 0; jj < clients.size(); ++jj) {
+            if (!clients[jj].active) {
+                continue;
+            }
+            log::message("  %2zu: %-24s %lld ms\n", jj, clients[jj].info.name.data(),
+                         clients[jj].latency.to_milliseconds());
+        }
+    }
+
+    log::message("frames: %zu dispatched, %zu overruns, %lld ms max overrun\n",
+                 _num_frames, _num_overruns, _max_overrun.to_milliseconds());
+
+    auto const& stats = _filter.stats();
+    log::message("connectionless: %zu requests, %zu replies, %zu address limited, %zu budget limited, %zu bad challenges\n",
+                 stats.requests, stats.responses, stats.address_limited, stats.response_limited, stats.bad_challenges);
+}
+
+} // namespace game
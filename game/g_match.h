@@ -0,0 +1,179 @@
+// g_match.h
+//
+
+#pragma once
+
+#include "g_session.h"
+#include "g_world.h"
+
+#include "net_filter.h"
+#include "net_socket.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace game {
+
+//------------------------------------------------------------------------------
+//! A single game hosted by a match server. Each match owns its world, clients,
+//! and scores and shares the socket of the match server. Packets are dispatched
+//! to the match on the main thread and frames may be run on a worker thread.
+class match : public world_host
+{
+public:
+    //! frames are skipped instead of run back to back if the match falls
+    //! further than this behind its schedule, e.g. after a long stall
+    static constexpr time_delta max_frame_lag = time_delta::from_milliseconds(250);
+
+public:
+    match(network::socket* socket);
+    ~match();
+
+    //! start the match, frames are scheduled relative to the given time
+    void start(time_value time);
+    void stop();
+
+    //! number of connected clients
+    std::size_t num_clients() const;
+
+    //! returns the index of the client with the given address, or -1
+    int find_client(network::address const& remote, int netport) const;
+
+    //! connect a new client, returns the client index or -1 if the match is full
+    int client_connect(network::address const& remote, int netport, string::view name);
+
+    //! process a sequenced packet from a connected client, the packet
+    //! header up to and including the netport must already have been read
+    void client_packet(network::message& message, std::size_t client);
+
+    //! disconnect clients that have not sent a packet recently
+    void check_timeouts(time_value time);
+
+    //! update match time from the application clock
+    void set_time(time_value time);
+
+    //! returns true if the next frame is due at the current match time
+    bool frame_due() const { return _worldtime >= time_value((1 + _world.framenum()) * FRAMETIME); }
+
+    //! application time at which the next frame is due
+    time_value next_frame_time() const { return _start_time + (1 + _world.framenum()) * FRAMETIME; }
+
+    //! run a single world frame and transmit the results to all clients
+    void run_frame();
+
+    time_value worldtime() const { return _worldtime; }
+    int framenum() const { return _world.framenum(); }
+    std::size_t num_skipped() const { return _num_skipped; }
+    std::size_t num_dropped_events() const { return _world.num_dropped_events(); }
+    tick_budget& budget() { return _budget; }
+    tick_budget const& budget() const { return _budget; }
+    physics::world::stats const& physics_stats() const { return _world.physics_stats(); }
+
+    std::array<client_t, MAX_PLAYERS> const& clients() const { return _clients; }
+
+    virtual game_client_t* client(std::size_t index) override { return _game_clients + index; }
+    virtual string::view client_name(std::size_t index) const override { return string::view(_clients[index].info.name.data()); }
+
+    virtual void add_score(std::size_t player_index, int score) override;
+    virtual void write_message(string::view message, bool broadcast = true) override;
+
+protected:
+    network::socket* _socket;
+
+    game::world _world;
+    time_value _worldtime;
+    time_value _start_time; //!< application time of frame zero
+    std::size_t _num_skipped; //!< number of times frames were skipped
+
+    //! degrades the match when its frames take too long
+    tick_budget _budget;
+
+    std::array<client_t, MAX_PLAYERS> _clients;
+    game_client_t _game_clients[MAX_PLAYERS];
+    int _score[MAX_PLAYERS];
+
+    config::scalar _upgrade_frac;
+    config::scalar _upgrade_penalty;
+    config::scalar _upgrade_min;
+    config::boolean _upgrades;
+    config::integer _sv_max_unlag;
+
+protected:
+    void spawn_player(std::size_t client);
+    void client_disconnect(std::size_t client);
+    void read_upgrade(std::size_t client, int upgrade);
+    void write_info(network::message& message, std::size_t client);
+
+    void broadcast(network::message& message);
+};
+
+//------------------------------------------------------------------------------
+//! Hosts several independent matches in a single process. All matches share
+//! one socket and one connectionless request filter, and sequenced packets are
+//! routed to the match which owns the remote connection. Matches which are due
+//! a frame are run in parallel on a pool of worker threads while the main
+//! thread waits, so match state is never accessed by two threads at once.
+class match_server
+{
+public:
+    match_server();
+    ~match_server();
+
+    //! open the server socket and start the matches and worker threads
+    result start(string::view name, int num_matches, int num_threads);
+
+    //! disconnect all clients and stop the worker threads
+    void stop();
+
+    //! block until a packet arrives or the next frame of any match is due,
+    //! returns false if there are no matches to wait on
+    bool wait_frame() const;
+
+    //! read packets and run frames for all matches which are due
+    void run_frame();
+
+    //! print matches, clients, and request filter counters to the console
+    void print_status() const;
+
+protected:
+    network::socket _socket;
+    network::request_filter _filter;
+
+    char _name[SHORT_STRING];
+
+    std::vector<std::unique_ptr<match>> _matches;
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _start_condition; //!< signaled when frames are pending
+    std::condition_variable _finish_condition; //!< signaled when all frames have finished
+    std::vector<match*> _pending; //!< matches which are due a frame
+    std::size_t _next; //!< index of the next pending match to run
+    std::size_t _finished; //!< number of pending matches which have finished
+    std::size_t _generation; //!< incremented each time frames are dispatched
+    bool _exit;
+
+    std::size_t _num_frames; //!< number of times frames were dispatched
+    std::size_t _num_overruns; //!< number of frames which finished after the following frame was due
+    time_delta _max_overrun; //!< largest overrun since the server started
+    time_value _overrun_time; //!< time of most recently reported overrun
+
+    //! minimum interval between overrun warnings
+    static constexpr time_delta overrun_report_rate = time_delta::from_seconds(5.0f);
+
+protected:
+    void worker_thread();
+
+    void get_packets();
+    void connectionless(network::address const& remote, network::message& message);
+
+    void info_send(network::address const& remote);
+    void challenge_send(network::address const& remote);
+    void client_connect(network::address const& remote, string::view message_string);
+};
+
+} // namespace game
@@ -13,6 +13,8 @@ namespace game {
 //------------------------------------------------------------------------------
 void session::get_packets ()
 {
+    PROFILE_ZONE("get_packets");
+
     network::socket* socket = svs.active ? &svs.socket : &cls.socket;
     network::message_storage message;
     network::address remote;
@@ -126,6 +128,8 @@ void session::broadcast_print (string::view message)
 //------------------------------------------------------------------------------
 void session::send_packets ()
 {
+    PROFILE_ZONE("send_packets");
+
     if (svs.active) {
         for (auto& cl : svs.clients) {
             if (cl.local || !cl.active || !cl.netchan.bytes_remaining()) {
@@ -157,32 +161,38 @@ void session::read_fail(string::view message_string)
 }
 
 //------------------------------------------------------------------------------
-void session::write_info(network::message& message, std::size_t client)
+void write_client_info(network::message& message, std::size_t index, client_t const& client, game_client_t const& game_client, int score)
 {
     message.write_byte( svc_info );
-    message.write_byte( narrow_cast<uint8_t>(client) );
-    message.write_byte( svs.clients[client].active );
-    message.write_string( svs.clients[client].info.name.data() );
+    message.write_byte( narrow_cast<uint8_t>(index) );
+    message.write_byte( client.active );
+    message.write_string( client.info.name.data() );
 
-    message.write_float( svs.clients[client].info.color.r );
-    message.write_float( svs.clients[client].info.color.g );
-    message.write_float( svs.clients[client].info.color.b );
+    message.write_float( client.info.color.r );
+    message.write_float( client.info.color.g );
+    message.write_float( client.info.color.b );
 
-    message.write_byte( narrow_cast<uint8_t>(svs.clients[client].info.weapon ) );
+    message.write_byte( narrow_cast<uint8_t>(client.info.weapon ) );
 
     //  write extra shit
 
-    message.write_byte( _clients[client].upgrades );
-    message.write_byte( narrow_cast<uint8_t>(_clients[client].armor_mod * 10) );
-    message.write_byte( narrow_cast<uint8_t>(_clients[client].damage_mod * 10) );
-    message.write_byte( narrow_cast<uint8_t>(_clients[client].refire_mod * 10) );
-    message.write_byte( narrow_cast<uint8_t>(_clients[client].speed_mod * 10) );
+    message.write_byte( game_client.upgrades );
+    message.write_byte( narrow_cast<uint8_t>(game_client.armor_mod * 10) );
+    message.write_byte( narrow_cast<uint8_t>(game_client.damage_mod * 10) );
+    message.write_byte( narrow_cast<uint8_t>(game_client.refire_mod * 10) );
+    message.write_byte( narrow_cast<uint8_t>(game_client.speed_mod * 10) );
 
     // also write score
 
     message.write_byte( svc_score );
-    message.write_byte( narrow_cast<uint8_t>(client) );
-    message.write_byte( narrow_cast<uint8_t>(_score[client]) );
+    message.write_byte( narrow_cast<uint8_t>(index) );
+    message.write_byte( narrow_cast<uint8_t>(score) );
+}
+
+//------------------------------------------------------------------------------
+void session::write_info(network::message& message, std::size_t client)
+{
+    write_client_info(message, client, svs.clients[client], _clients[client], _score[client]);
 }
 
 //------------------------------------------------------------------------------
@@ -42,9 +42,9 @@ bool object::touch(object* /*other*/, physics::collision const* /*collision*/)
 }
 
 //------------------------------------------------------------------------------
-void object::draw(render::system* renderer, time_value time) const
+void object::draw(render::system* renderer, time_value time, draw_pass pass) const
 {
-    if (_model) {
+    if (_model && pass == draw_pass::models) {
         renderer->draw_model(_model, get_transform(time), _color);
     }
 }
@@ -90,6 +90,17 @@ mat3 object::get_inverse_transform(time_value time) const
     return mat3::inverse_transform(get_position(time), get_rotation(time));
 }
 
+//------------------------------------------------------------------------------
+bounds object::get_bounds(time_value time) const
+{
+    if (_model) {
+        return _model->calculate_bounds(get_transform(time));
+    } else {
+        vec2 position = get_position(time);
+        return bounds(position, position);
+    }
+}
+
 //------------------------------------------------------------------------------
 void object::set_position(vec2 position, bool teleport/* = false*/)
 {
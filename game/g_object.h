@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "cm_bounds.h"
 #include "cm_random.h"
 #include "cm_time.h"
 #include "p_material.h"
@@ -35,6 +36,16 @@ enum class object_type
     tank,
 };
 
+//------------------------------------------------------------------------------
+//! Objects are drawn once for each pass so that all draws of a model are
+//! submitted together, which lets the renderer instance them.
+enum class draw_pass
+{
+    models, //!< object models
+    attachments, //!< models attached to object models, e.g. turrets
+    overlays, //!< lines and boxes drawn over all models
+};
+
 //------------------------------------------------------------------------------
 class object
 {
@@ -46,7 +57,7 @@ public:
 
     std::size_t spawn_id() const { return _spawn_id; }
 
-    virtual void draw(render::system* renderer, time_value time) const;
+    virtual void draw(render::system* renderer, time_value time, draw_pass pass) const;
     virtual bool touch(object *other, physics::collision const* collision);
     virtual void think();
 
@@ -65,6 +76,9 @@ public:
     //! Get frame-interpolated inverse transform matrix
     virtual mat3 get_inverse_transform(time_value time) const;
 
+    //! Get bounds of everything drawn by the object at the given time
+    virtual bounds get_bounds(time_value time) const;
+
     physics::rigid_body const& rigid_body() const { return _rigid_body; }
 
     void set_position(vec2 position, bool teleport = false);
@@ -10,42 +10,62 @@ namespace game {
 //------------------------------------------------------------------------------
 render::particle* world::add_particle (time_value time)
 {
-    _particles.emplace_back(render::particle{});
-    _particles.back().time = time;
-    return &_particles.back();
+    if (_new_particles.size() >= static_cast<std::size_t>(std::max<int>(0, _particle_budget))) {
+        ++_particles_dropped;
+        return NULL;
+    }
+
+    _new_particles.emplace_back(render::particle{});
+    _new_particles.back().time = time;
+    return &_new_particles.back();
 }
 
 //------------------------------------------------------------------------------
-void world::free_particle (render::particle *p) const
+float world::particle_detail() const
 {
-    _particles[p - _particles.data()] = _particles.back();
-    _particles.pop_back();
+    // effects spawn all of their particles until the budget is half full and
+    // then progressively fewer, down to a quarter when the budget is full
+    float budget = static_cast<float>(std::max<int>(1, _particle_budget));
+    float fraction = (_particles.size() + _new_particles.size()) / budget;
+    return clamp(1.f - 1.5f * (fraction - .5f), .25f, 1.f);
 }
 
 //------------------------------------------------------------------------------
-void world::draw_particles(render::system* renderer, time_value time) const
+void world::draw_particles(render::system* renderer, time_value time, bounds const& view) const
 {
-    for (std::size_t ii = 0; ii < _particles.size(); ++ii) {
-        float ptime = (time - _particles[ii].time).to_seconds();
-        if (_particles[ii].color.a + _particles[ii].color_velocity.a * ptime < 0.0f) {
-            free_particle(&_particles[ii]);
-            --ii;
-        } else if (_particles[ii].size + _particles[ii].size_velocity * ptime < 0.0f) {
-            free_particle(&_particles[ii]);
-            --ii;
-        }
+    std::size_t budget = static_cast<std::size_t>(std::max<int>(0, _particle_budget));
+    std::size_t evicted = 0;
+
+    // make room for new particles by evicting the least visible existing
+    // particles, new particles are already limited to the budget
+    _particles.reserve(budget);
+    if (_particles.size() + _new_particles.size() > budget) {
+        evicted = std::min(_particles.size(), _particles.size() + _new_particles.size() - budget);
+        _particles.evict(evicted);
+    }
+
+    for (auto const& p : _new_particles) {
+        _particles.add(p);
     }
 
-    renderer->draw_particles(
-        time,
-        _particles.data(),
-        _particles.size());
+    _particle_stats.spawned = _new_particles.size();
+    _particle_stats.evicted = evicted;
+    _particle_stats.dropped = _particles_dropped;
+    _particles_dropped = 0;
+    _new_particles.clear();
+
+    _particles.update(time, FRAMETIME);
+    _particle_stats.alive = _particles.size();
+    _particle_stats.culled = _particles.cull(view);
+    renderer->draw_particles(_particles);
 }
 
 //------------------------------------------------------------------------------
 void world::clear_particles()
 {
+    _new_particles.clear();
     _particles.clear();
+    _particles_dropped = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -53,11 +73,16 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 {
     write_effect(time, type, position, direction, strength);
 
+    if (_headless) {
+        return;
+    }
+
     float   r, d;
+    float   detail = particle_detail();
 
     switch (type) {
         case effect_type::smoke: {
-            int count = static_cast<int>(strength);
+            int count = static_cast<int>(std::ceil(strength * detail));
             render::particle* p;
 
             for (int ii = 0; ii < count; ++ii) {
@@ -84,7 +109,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
         case effect_type::sparks: {
             render::particle* p;
 
-            for (int ii = 0; ii < 4; ++ii) {
+            for (int ii = 0; ii < 4 * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -104,7 +129,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
                 p->flags = render::particle::tail;
             }
 
-            for (int ii = 0; ii < 2; ++ii) {
+            for (int ii = 0; ii < 2 * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -152,7 +177,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // smoke
 
-            for (int ii = 0; ii < 96 * scale; ++ii) {
+            for (int ii = 0; ii < 96 * scale * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -178,7 +203,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // fire
 
-            for (int ii = 0; ii < 64 * scale; ++ii) {
+            for (int ii = 0; ii < 64 * scale * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -203,7 +228,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // debris
 
-            for (int ii = 0; ii < 32 * scale; ++ii) {
+            for (int ii = 0; ii < 32 * scale * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -247,7 +272,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // fire
 
-            for (int ii = 0; ii < 8; ++ii) {
+            for (int ii = 0; ii < 8 * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -290,7 +315,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // debris
 
-            for (int ii = 0; ii < 4; ++ii) {
+            for (int ii = 0; ii < 4 * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -354,7 +379,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // smoke
 
-            for (int ii = 0; ii < 64 * scale; ++ii) {
+            for (int ii = 0; ii < 64 * scale * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -380,7 +405,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // fire
 
-            for (int ii = 0; ii < 64 * scale; ++ii) {
+            for (int ii = 0; ii < 64 * scale * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -405,7 +430,7 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 
             // debris
 
-            for (int ii = 0; ii < 32 * scale; ++ii) {
+            for (int ii = 0; ii < 32 * scale * detail; ++ii) {
                 if ( (p = add_particle(time)) == NULL )
                     return;
 
@@ -438,13 +463,18 @@ void world::add_effect(time_value time, effect_type type, vec2 position, vec2 di
 //------------------------------------------------------------------------------
 void world::add_trail_effect(effect_type type, vec2 position, vec2 old_position, vec2 direction, float strength)
 {
+    if (_headless) {
+        return;
+    }
+
     float   r, d;
+    float   detail = particle_detail();
 
     vec2 lerp = position - old_position;
 
     switch (type) {
         case effect_type::missile_trail: {
-            int count = static_cast<int>(strength);
+            int count = static_cast<int>(std::ceil(strength * detail));
             render::particle* p;
 
             // smoke
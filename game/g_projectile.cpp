@@ -20,9 +20,9 @@ projectile::projectile(tank* owner, float damage, weapon_type type)
     , _damage(damage)
     , _type(type)
     , _impact_time(time_value::max)
+    , _channel(nullptr)
 {
     _rigid_body = physics::rigid_body(&_shape, &_material, 1e-3f);
-    _channel = pSound->allocate_channel();
     _sound_cannon_impact = pSound->load_sound("assets/sound/cannon_impact.wav");
     _sound_blaster_impact = pSound->load_sound("assets/sound/blaster_impact.wav");
     _sound_missile_flight = pSound->load_sound("assets/sound/missile_flight.wav");
@@ -114,7 +114,15 @@ void projectile::update_effects()
 //------------------------------------------------------------------------------
 void projectile::update_sound()
 {
+    // headless worlds may be updated on worker threads
+    if (_world->headless()) {
+        return;
+    }
+
     if (_type == weapon_type::missile) {
+        if (!_channel) {
+            _channel = pSound->allocate_channel();
+        }
         if (_channel) {
             if (!_channel->playing()) {
                 _channel->loop(_sound_missile_flight);
@@ -201,7 +209,7 @@ bool projectile::touch(object *other, physics::collision const* collision)
         }
 
         if (other_tank->_damage >= 1.0f) {
-            g_Game->add_score( owner_tank->_player_index, 1 );
+            _world->host()->add_score( owner_tank->_player_index, 1 );
             other_tank->_dead_time = _world->frametime();
 
             string::literal fmt = "";
@@ -230,7 +238,7 @@ bool projectile::touch(object *other, physics::collision const* collision)
                     break;
             }
 
-            g_Game->write_message(va(fmt, other_tank->player_name().c_str(), owner_tank->player_name().c_str()));
+            _world->host()->write_message(va(fmt, other_tank->player_name().c_str(), owner_tank->player_name().c_str()));
         }
     }
 
@@ -238,11 +246,9 @@ bool projectile::touch(object *other, physics::collision const* collision)
 }
 
 //------------------------------------------------------------------------------
-void projectile::draw(render::system* renderer, time_value time) const
+void projectile::draw(render::system* renderer, time_value time, draw_pass pass) const
 {
-    constexpr time_delta tail_time = time_delta::from_seconds(.02f);
-
-    if (time - tail_time > _impact_time) {
+    if (pass != draw_pass::overlays || time - tail_time > _impact_time) {
         return;
     }
 
@@ -268,6 +274,14 @@ void projectile::draw(render::system* renderer, time_value time) const
     }
 }
 
+//------------------------------------------------------------------------------
+bounds projectile::get_bounds(time_value time) const
+{
+    vec2 p1 = get_position(std::max(_spawn_time, time - tail_time));
+    vec2 p2 = get_position(std::min(_impact_time, time));
+    return bounds(p1, p1).add(p2);
+}
+
 //------------------------------------------------------------------------------
 void projectile::read_snapshot(network::message const& message)
 {
@@ -23,7 +23,8 @@ public:
     projectile(tank* owner, float damage, weapon_type type);
     ~projectile();
 
-    virtual void draw(render::system* renderer, time_value time) const override;
+    virtual void draw(render::system* renderer, time_value time, draw_pass pass) const override;
+    virtual bounds get_bounds(time_value time) const override;
     virtual bool touch(object *other, physics::collision const* collision) override;
     virtual void think() override;
 
@@ -50,6 +51,7 @@ protected:
 
     static constexpr time_delta fuse_time = time_delta::from_seconds(5.f);
     static constexpr time_delta fade_time = time_delta::from_seconds(1.f);
+    static constexpr time_delta tail_time = time_delta::from_seconds(.02f);
 
 protected:
     void update_homing();
@@ -4,6 +4,7 @@
 #include "precompiled.h"
 #pragma hdrstop
 
+#include "g_match.h"
 #include "g_tank.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +15,16 @@ void session::start_server ()
 {
     stop_client( );
 
+    // dedicated servers host one or more independent matches
+    if (_dedicated) {
+        _match_server = std::make_unique<match_server>();
+        if (failed(_match_server->start(_net_server_name, _sv_matches, _sv_threads))) {
+            _match_server.reset();
+        }
+        _menu_active = false;
+        return;
+    }
+
     reset();
 
     for (std::size_t ii = 0; ii < svs.clients.size(); ++ii) {
@@ -41,6 +52,8 @@ void session::start_server ()
     _net_server_name = svs.name;
 
     svs.socket.open(network::socket_type::ipv6, PORT_SERVER);
+    svs.filter.reset();
+    _tick_budget.reset();
     _netchan.setup(&svs.socket, network::address{});
 
     _net_bytes.fill(0);
@@ -56,6 +69,8 @@ void session::start_server_local()
     svs.active = true;
     svs.local = true;
 
+    _tick_budget.reset();
+
     // init local players
     for (std::size_t ii = 0; ii < svs.clients.size(); ++ii) {
         if (ii < 2) {
@@ -78,6 +93,8 @@ void session::start_server_local()
 //------------------------------------------------------------------------------
 void session::stop_server ()
 {
+    _match_server.reset();
+
     if (!svs.active) {
         return;
     }
@@ -100,15 +117,27 @@ void session::stop_server ()
     svs.socket.close();
 
     _world.reset();
+
+    // clear any degradation left on the world
+    _tick_budget.reset();
+    _tick_budget.apply(_world);
 }
 
 //------------------------------------------------------------------------------
 void session::server_connectionless(network::address const& remote, network::message& message)
 {
+    // drop requests from addresses that are sending too quickly before doing
+    // any work to parse the request
+    if (!svs.filter.accept(remote, time_value::current())) {
+        return;
+    }
+
     string::view message_string(message.read_string());
 
     if (message_string.starts_with("info")) {
         info_send(remote);
+    } else if (message_string.starts_with("getchallenge")) {
+        challenge_send(remote);
     } else if (message_string.starts_with("connect")) {
         client_connect(remote, message_string);
     }
@@ -120,7 +149,7 @@ void session::server_packet(network::message& message, std::size_t client)
     while (message.bytes_remaining()) {
         switch (message.read_byte()) {
             case clc_command:
-                client_command(message, client);
+                read_client_command(message, svs.clients[client]);
                 break;
 
             case clc_disconnect:
@@ -140,9 +169,18 @@ void session::server_packet(network::message& message, std::size_t client)
                 read_upgrade(client, message.read_byte());
                 break;
 
-            case svc_info:
-                read_info(message);
+            case clc_ping:
+                read_client_ping(message, svs.clients[client], _clients[client], _worldtime, time_delta::from_milliseconds(_sv_max_unlag));
+                break;
+
+            case svc_info: {
+                network::message_storage netmsg;
+
+                read_client_info(message, svs.clients[client], _world.player(client));
+                write_info(netmsg, client);
+                broadcast(netmsg);
                 break;
+            }
 
             default:
                 return;
@@ -153,6 +191,8 @@ void session::server_packet(network::message& message, std::size_t client)
 //------------------------------------------------------------------------------
 void session::write_frame()
 {
+    PROFILE_ZONE("write_frame");
+
     network::message_storage message;
 
     // check if local user info has been changed
@@ -175,10 +215,43 @@ void session::write_frame()
         }
     }
 
+    broadcast(message);
 
-    _world.write_snapshot(message);
+    network::message_storage snapshot;
+    network::message_storage events;
+    _world.write_snapshot(snapshot, events);
 
-    broadcast(message);
+    std::size_t length = snapshot.bytes_remaining();
+    byte const* data = snapshot.read(length);
+    std::size_t events_length = events.bytes_remaining();
+    byte const* events_data = events.read(events_length);
+
+    // slow clients may skip object state when the server is over budget but
+    // are always sent sounds and effects
+    for (auto& cl : svs.clients) {
+        if (cl.local || !cl.active) {
+            continue;
+        } else if (_tick_budget.send_snapshot(cl.latency, _world.framenum())) {
+            cl.netchan.write(data, length);
+        } else {
+            cl.netchan.write(events_data, events_length);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void session::challenge_send(network::address const& remote)
+{
+    if (!svs.active) {
+        return;
+    }
+
+    // challenge is derived from the remote address so no state is kept
+    // until the client echoes the challenge back in a connect request
+    time_value time = time_value::current();
+    if (svs.filter.respond(time)) {
+        svs.socket.printf(remote, "challenge %i", svs.filter.challenge(remote, time));
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -189,6 +262,24 @@ void session::client_connect(network::address const& remote, string::view messag
         return;
     }
 
+    int version = 0, challenge = -1;
+    time_value time = time_value::current();
+
+    sscanf(message_string, "connect %i %i", &version, &challenge);
+
+    if (version != PROTOCOL_VERSION) {
+        if (svs.filter.respond(time)) {
+            svs.socket.printf(remote, "fail \"Bad protocol version: %i\"", version);
+        }
+        return;
+    }
+
+    // ignore requests that do not echo a recent challenge, the source
+    // address of these requests has not been verified so do not respond
+    if (!svs.filter.check_challenge(remote, challenge, time)) {
+        return;
+    }
+
     // ensure that this client hasn't already connected
     for (auto const& cl : svs.clients) {
         if (cl.active && cl.netchan.address() == remote) {
@@ -203,37 +294,38 @@ void session::client_connect(network::address const& remote, string::view messag
         }
     }
 
-    svs.socket.printf(remote, "fail \"Server is full\"");
+    if (svs.filter.respond(time)) {
+        svs.socket.printf(remote, "fail \"Server is full\"");
+    }
 }
 
 //------------------------------------------------------------------------------
 void session::client_connect(network::address const& remote, string::view message_string, std::size_t client)
 {
     auto& cl = svs.clients[client];
-    int netport, version;
+    int netport, version, challenge;
 
-    sscanf(message_string, "connect %i %s %i", &version, cl.info.name.data(), &netport);
+    sscanf(message_string, "connect %i %i %s %i", &version, &challenge, cl.info.name.data(), &netport);
 
-    if (version != PROTOCOL_VERSION) {
-        svs.socket.printf(remote, "fail \"Bad protocol version: %i\"", version);
-    } else {
-        cl.active = true;
-        cl.local = false;
-        cl.netchan.setup(&svs.socket, remote, narrow_cast<word>(netport));
+    cl.active = true;
+    cl.local = false;
+    cl.netchan.setup(&svs.socket, remote, narrow_cast<word>(netport));
+    cl.usercmds.reset();
+    cl.latency = time_delta::zero;
+    _clients[client].unlag = time_delta::zero;
 
-        svs.socket.printf(cl.netchan.address(), "connect %i %lld", client, _worldtime.to_microseconds());
+    svs.socket.printf(cl.netchan.address(), "connect %i %lld", client, _worldtime.to_microseconds());
 
-        // init their tank
+    // init their tank
 
-        spawn_player(client);
+    spawn_player(client);
 
-        write_message(va("%s connected.", cl.info.name.data()));
+    write_message(va("%s connected.", cl.info.name.data()));
 
-        // broadcast existing client information to new client
-        for (std::size_t ii = 0; ii < svs.clients.size(); ++ii) {
-            if (&cl != &svs.clients[ii]) {
-                write_info(cl.netchan, ii);
-            }
+    // broadcast existing client information to new client
+    for (std::size_t ii = 0; ii < svs.clients.size(); ++ii) {
+        if (&cl != &svs.clients[ii]) {
+            write_info(cl.netchan, ii);
         }
     }
 }
@@ -255,17 +347,20 @@ void session::client_disconnect(std::size_t client)
 }
 
 //------------------------------------------------------------------------------
-void session::client_command(network::message& message, std::size_t client)
+//------------------------------------------------------------------------------
+void session::client_think()
 {
-    game::usercmd cmd{};
-
-    cmd.move = message.read_vector();
-    cmd.look = message.read_vector();
-    cmd.action = static_cast<decltype(cmd.action)>(message.read_byte());
+    // apply exactly one buffered command per frame to each remote player
+    for (std::size_t ii = 0; ii < svs.clients.size(); ++ii) {
+        if (svs.clients[ii].local || !svs.clients[ii].active) {
+            continue;
+        }
 
-    game::tank* player = _world.player(client);
-    if (player) {
-        player->update_usercmd(cmd);
+        game::usercmd cmd;
+        game::tank* player = _world.player(ii);
+        if (player && svs.clients[ii].usercmds.next(cmd)) {
+            player->update_usercmd(cmd);
+        }
     }
 }
 
@@ -286,10 +381,32 @@ void session::info_send(network::address const& remote)
     if ( i == MAX_PLAYERS )
         return;
 
-    svs.socket.printf(remote, "info %s", svs.name);
+    if (svs.filter.respond(time_value::current())) {
+        svs.socket.printf(remote, "info %s", svs.name);
+    }
+}
+
+//------------------------------------------------------------------------------
+void game_client_s::apply_upgrade(int upgrade, float fraction, float penalty, float minimum)
+{
+    --upgrades;
+    if (upgrade == 0) {
+        damage_mod += fraction;
+        refire_mod = std::max(refire_mod - penalty, minimum);
+    } else if (upgrade == 1) {
+        armor_mod += fraction;
+        speed_mod = std::max(speed_mod - penalty, minimum);
+    } else if (upgrade == 2) {
+        refire_mod += fraction;
+        damage_mod = std::max(damage_mod - penalty, minimum);
+    } else if (upgrade == 3) {
+        speed_mod += fraction;
+        armor_mod = std::max(armor_mod - penalty, minimum);
+    }
 }
 
-char const* sz_upgrades[] = {
+//------------------------------------------------------------------------------
+char const* sz_upgrades[num_upgrades] = {
     "damage",
     "armor",
     "gunnery",
@@ -299,45 +416,97 @@ char const* sz_upgrades[] = {
 //------------------------------------------------------------------------------
 void session::read_upgrade(std::size_t client, int upgrade)
 {
-    if (_clients[client].upgrades) {
+    if (read_client_upgrade(this, svs.clients[client], _clients[client], upgrade, _upgrade_frac, _upgrade_penalty, _upgrade_min)) {
         network::message_storage netmsg;
 
-        _clients[client].upgrades--;
-        if (upgrade == 0) {
-            _clients[client].damage_mod += _upgrade_frac;
-            _clients[client].refire_mod -= _upgrade_penalty;
-            if (_clients[client].refire_mod < _upgrade_min) {
-                _clients[client].refire_mod = _upgrade_min;
-            }
-        } else if (upgrade == 1) {
-            _clients[client].armor_mod += _upgrade_frac;
-            _clients[client].speed_mod -= _upgrade_penalty;
-            if (_clients[client].speed_mod < _upgrade_min) {
-                _clients[client].speed_mod = _upgrade_min;
-            }
-        } else if (upgrade == 2) {
-            _clients[client].refire_mod += _upgrade_frac;
-            _clients[client].damage_mod -= _upgrade_penalty;
-            if (_clients[client].damage_mod < _upgrade_min) {
-                _clients[client].damage_mod = _upgrade_min;
-            }
-        } else if (upgrade == 3) {
-            _clients[client].speed_mod += _upgrade_frac;
-            _clients[client].armor_mod -= _upgrade_penalty;
-            if (_clients[client].armor_mod < _upgrade_min) {
-                _clients[client].armor_mod = _upgrade_min;
-            }
-        }
-
-        write_message( va( "^%x%x%x%s^xxx has upgraded their %s!",
-            (int )(svs.clients[client].info.color.r * 15.5f),
-            (int )(svs.clients[client].info.color.g * 15.5f),
-            (int )(svs.clients[client].info.color.b * 15.5f),
-            svs.clients[client].info.name.data(), sz_upgrades[upgrade] ) );
-
         write_info(netmsg, client);
         broadcast(netmsg);
     }
 }
 
+//------------------------------------------------------------------------------
+void read_client_command(network::message& message, client_t& client)
+{
+    int sequence = message.read_long();
+    int count = message.read_byte();
+
+    // ignore commands which do not fit in the rest of the message
+    count = std::min(count, static_cast<int>(message.bits_remaining() / game::usercmd::bits));
+
+    // commands are written from newest to oldest
+    for (int ii = 0; ii < count; ++ii) {
+        game::usercmd cmd = game::usercmd::read(message);
+        client.usercmds.insert(sequence - ii, cmd);
+    }
+    message.read_align();
+}
+
+//------------------------------------------------------------------------------
+void read_client_ping(network::message& message, client_t& client, game_client_t& game_client, time_value time, time_delta max_unlag)
+{
+    time_value request_time = message.read_time();
+    time_delta latency = time_delta::from_microseconds(message.read_long());
+
+    // the response is written immediately so the receive and transmit times
+    // are the same, the delay until the packet is sent at the end of the frame
+    // is included in the client's estimate of the round trip delay
+    client.netchan.write_byte(svc_pong);
+    client.netchan.write_time(request_time);
+    client.netchan.write_time(time);
+    client.netchan.write_time(time);
+
+    client.latency = std::max<time_delta>(latency, time_delta::zero);
+    game_client.unlag = std::min<time_delta>(client.latency, max_unlag);
+}
+
+//------------------------------------------------------------------------------
+void read_client_info(network::message& message, client_t& client, game::tank* player)
+{
+    // clients may only change their own name, color, and weapon
+    message.read_byte(); // skip client index
+    message.read_byte(); // skip active
+
+    strncpy(client.info.name.data(), message.read_string(), client.info.name.size() - 1);
+    client.info.name.back() = '\0';
+
+    client.info.color.r = message.read_float();
+    client.info.color.g = message.read_float();
+    client.info.color.b = message.read_float();
+
+    client.info.weapon = static_cast<weapon_type>(message.read_byte());
+    if (client.info.weapon != weapon_type::cannon
+            && client.info.weapon != weapon_type::missile
+            && client.info.weapon != weapon_type::blaster) {
+        client.info.weapon = weapon_type::cannon;
+    }
+
+    // skip upgrades and modifiers, these are owned by the server
+    for (int ii = 0; ii < 5; ++ii) {
+        message.read_byte();
+    }
+
+    if (player) {
+        player->_color = color4(client.info.color);
+        player->_weapon = client.info.weapon;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool read_client_upgrade(world_host* host, client_t const& client, game_client_t& game_client, int upgrade, float fraction, float penalty, float minimum)
+{
+    if (upgrade < 0 || upgrade >= num_upgrades || !game_client.upgrades) {
+        return false;
+    }
+
+    game_client.apply_upgrade(upgrade, fraction, penalty, minimum);
+
+    host->write_message( va( "^%x%x%x%s^xxx has upgraded their %s!",
+        (int )(client.info.color.r * 15.5f),
+        (int )(client.info.color.g * 15.5f),
+        (int )(client.info.color.b * 15.5f),
+        client.info.name.data(), sz_upgrades[upgrade] ) );
+
+    return true;
+}
+
 } // namespace game
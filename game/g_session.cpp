@@ -6,6 +6,7 @@
 
 #include "cm_keys.h"
 #include "cm_parser.h"
+#include "g_match.h"
 #include "g_tank.h"
 
 #include "resource.h"
@@ -39,6 +40,14 @@ session::session()
     , _cl_color("ui_color", "255 0 0", config::archive, "user info: color")
     , _cl_weapon("ui_weapon", 0, config::archive, "user info: weapon")
     , _timescale("timescale", 1.f, config::server, "")
+    , _cl_time_nudge("cl_timeNudge", 0, config::archive, "additional client view delay in milliseconds")
+    , _cl_particle_stats("cl_particleStats", false, config::archive, "draw particle counts")
+    , _cl_frame_timing("cl_frameTiming", false, config::archive, "draw main and render thread frame times")
+    , _cl_cull_stats("cl_cullStats", false, config::archive, "draw counts of drawn and culled objects and particles")
+    , _cl_profile("cl_profile", false, 0, "draw the time spent in each profile zone during the last frame")
+    , _sv_max_unlag("sv_maxUnlag", 200, config::archive|config::server, "maximum lag compensation for remote players in milliseconds")
+    , _sv_matches("sv_matches", 1, config::archive|config::server, "number of matches hosted by a dedicated server")
+    , _sv_threads("sv_threads", 0, config::archive|config::server, "number of worker threads used by a dedicated server, 0 for automatic")
     , _restart_time(time_value::zero)
     , _worldtime(time_value::zero)
     , _frametime(time_value::zero)
@@ -52,11 +61,18 @@ session::session()
     , _command_quit("quit", &session::command_quit)
     , _command_disconnect("disconnect", this, &session::command_disconnect)
     , _command_connect("connect", this, &session::command_connect)
+    , _command_status("status", this, &session::command_status)
+    , _command_profile_capture("profile_capture", this, &session::command_profile_capture)
 {
     log::set(this);
     g_Game = this;
 }
 
+//------------------------------------------------------------------------------
+session::~session()
+{
+}
+
 //------------------------------------------------------------------------------
 result session::init (string::view cmdline)
 {
@@ -125,15 +141,12 @@ result session::init (string::view cmdline)
     init_client();
 
     _menu.init( );
-    _world.init( );
-
-    if (cmdline.contains("dedicated")) {
-        _dedicated = true;
-        start_server( );
-    }
+    _world.init(this);
 
     // sound indices are shared over the network so sounds
-    // need to be registed in the same order on all clients
+    // need to be registed in the same order on all clients.
+    // matches hosted by a dedicated server look up sounds
+    // from worker threads so sounds must be loaded first
     pSound->load_sound("assets/sound/tank_move.wav");
     pSound->load_sound("assets/sound/tank_idle.wav");
     pSound->load_sound("assets/sound/tank_explode.wav");
@@ -144,6 +157,11 @@ result session::init (string::view cmdline)
     pSound->load_sound("assets/sound/cannon_impact.wav");
     pSound->load_sound("assets/sound/missile_flight.wav");
 
+    if (cmdline.contains("dedicated")) {
+        _dedicated = true;
+        start_server( );
+    }
+
     write_message( "Welcome to Tanks! Press F1 or LSHLDR for help." );
 
     return result::success;
@@ -162,8 +180,19 @@ void session::shutdown()
 //------------------------------------------------------------------------------
 result session::run_frame(time_delta time)
 {
+    PROFILE_ZONE("session::run_frame");
+
+    if (_cl_profile.modified()) {
+        profile::set_enabled(_cl_profile);
+        _cl_profile.reset();
+    }
+
     get_packets( );
 
+    if (_match_server) {
+        _match_server->run_frame();
+    }
+
     _frametime += time;
 
     // step session
@@ -176,14 +205,28 @@ result session::run_frame(time_delta time)
     // step world
 
     if (!_menu_active || svs.active) {
-        // clamp world step size
-        _worldtime += std::min(time, FRAMETIME) * _timescale;
+        if (cls.active && !cls.local && cls.clock.synchronized()) {
+            // track server time using the synchronized clock
+            _worldtime = cls.clock.remote_time(time_value::current()) - view_delay();
+        } else {
+            // clamp world step size
+            _worldtime += std::min(time, FRAMETIME) * _timescale;
+        }
 
         if (_worldtime > time_value((1 + _world.framenum()) * FRAMETIME) && svs.active) {
+            _tick_budget.begin_tick();
+            _tick_budget.apply(_world);
+
+            if (!svs.local) {
+                client_think();
+            }
             _world.run_frame();
             if (!svs.local) {
                 write_frame();
             }
+
+            _tick_budget.end_tick();
+            _tick_budget.report("Server");
         }
     }
 
@@ -195,7 +238,10 @@ result session::run_frame(time_delta time)
 
     // update sound
 
-    pSound->update( );
+    {
+        PROFILE_ZONE("sound::update");
+        pSound->update( );
+    }
 
     if (_restart_time != time_value::zero && (_frametime > _restart_time) && !_menu_active ) {
         restart();
@@ -204,9 +250,17 @@ result session::run_frame(time_delta time)
     return result::success;
 }
 
+//------------------------------------------------------------------------------
+bool session::wait_frame() const
+{
+    return _match_server && _match_server->wait_frame();
+}
+
 //------------------------------------------------------------------------------
 void session::update_screen()
 {
+    PROFILE_ZONE("update_screen");
+
     _renderer->begin_frame();
 
     draw_world();
@@ -235,6 +289,14 @@ void session::update_screen()
 
     draw_netgraph();
 
+    draw_particle_stats();
+
+    draw_frame_timing();
+
+    draw_cull_stats();
+
+    draw_profile();
+
     _renderer->end_frame();
 }
 
@@ -708,6 +770,94 @@ void session::draw_netgraph()
         _renderer->draw_string(smax, vec2(638.0f - _renderer->string_size(smax).x, ymax), color4(1,1,1,1));
         _renderer->draw_string(savg, vec2(638.0f - _renderer->string_size(savg).x, yavg), color4(1,1,1,alpha_avg));
     }
+
+    //
+    // draw clock sync stats
+    //
+
+    if (cls.active && !cls.local && cls.clock.synchronized()) {
+        string::buffer srtt(va("%0.1f ms rtt", cls.clock.round_trip().to_seconds() * 1e3f));
+        string::buffer sjitter(va("%0.1f ms jitter", cls.clock.jitter().to_seconds() * 1e3f));
+        string::buffer soffset(va("%+0.1f ms offset", cls.clock.offset().to_seconds() * 1e3f));
+
+        float y = 480.0f - height - 40.0f;
+        _renderer->draw_string(srtt, vec2(638.0f - _renderer->string_size(srtt).x, y), color4(1,1,1,1));
+        _renderer->draw_string(sjitter, vec2(638.0f - _renderer->string_size(sjitter).x, y + 12.0f), color4(1,1,1,1));
+        _renderer->draw_string(soffset, vec2(638.0f - _renderer->string_size(soffset).x, y + 24.0f), color4(1,1,1,1));
+    }
+}
+
+//------------------------------------------------------------------------------
+void session::draw_particle_stats()
+{
+    if (!_cl_particle_stats) {
+        return;
+    }
+
+    auto const& stats = _world.get_particle_stats();
+    string::buffer salive(va("%zu particles", stats.alive));
+    string::buffer sspawned(va("%zu spawned", stats.spawned));
+    string::buffer sevicted(va("%zu evicted, %zu dropped", stats.evicted, stats.dropped));
+
+    _renderer->draw_string(salive, vec2(638.0f - _renderer->string_size(salive).x, 12.0f), color4(1,1,1,1));
+    _renderer->draw_string(sspawned, vec2(638.0f - _renderer->string_size(sspawned).x, 24.0f), color4(1,1,1,1));
+    _renderer->draw_string(sevicted, vec2(638.0f - _renderer->string_size(sevicted).x, 36.0f), color4(1,1,1,1));
+}
+
+//------------------------------------------------------------------------------
+void session::draw_frame_timing()
+{
+    if (!_cl_frame_timing) {
+        return;
+    }
+
+    // timing is from the previous frame, the current frame is still being recorded
+    auto const& timing = _renderer->get_frame_timing();
+    string::buffer smain(va("%0.2f ms main", timing.main.to_seconds() * 1e3f));
+    string::buffer srender(va("%0.2f ms render", timing.render.to_seconds() * 1e3f));
+    string::buffer soverlap(va("%0.2f ms overlap, %0.2f ms wait", timing.overlap.to_seconds() * 1e3f, timing.wait.to_seconds() * 1e3f));
+
+    _renderer->draw_string(smain, vec2(638.0f - _renderer->string_size(smain).x, 60.0f), color4(1,1,1,1));
+    _renderer->draw_string(srender, vec2(638.0f - _renderer->string_size(srender).x, 72.0f), color4(1,1,1,1));
+    _renderer->draw_string(soverlap, vec2(638.0f - _renderer->string_size(soverlap).x, 84.0f), color4(1,1,1,1));
+}
+
+//------------------------------------------------------------------------------
+void session::draw_cull_stats()
+{
+    if (!_cl_cull_stats) {
+        return;
+    }
+
+    auto const& objects = _world.get_object_stats();
+    auto const& particles = _world.get_particle_stats();
+    string::buffer sobjects(va("%zu objects drawn, %zu culled", objects.drawn, objects.culled));
+    string::buffer sparticles(va("%zu particles drawn, %zu culled", particles.alive - particles.culled, particles.culled));
+
+    _renderer->draw_string(sobjects, vec2(638.0f - _renderer->string_size(sobjects).x, 108.0f), color4(1,1,1,1));
+    _renderer->draw_string(sparticles, vec2(638.0f - _renderer->string_size(sparticles).x, 120.0f), color4(1,1,1,1));
+}
+
+//------------------------------------------------------------------------------
+void session::draw_profile()
+{
+    if (!_cl_profile) {
+        return;
+    }
+
+    // zones are from the previous frame, the current frame is still running
+    float y = 132.0f;
+    for (auto const& zone : profile::summary()) {
+        // zones entered more than once show the number of times they were entered
+        float ms = zone.total.to_seconds() * 1e3f;
+        int indent = static_cast<int>(zone.depth * 2);
+        string::buffer szone(zone.count > 1
+            ? va("%*s%s %0.2f ms (%zu)", indent, "", zone.name, ms, zone.count)
+            : va("%*s%s %0.2f ms", indent, "", zone.name, ms));
+
+        _renderer->draw_monospace(szone, vec2(400.0f, y), color4(1,1,1,1));
+        y += 12.0f;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -722,6 +872,7 @@ void session::reset()
         _clients[i].refire_mod = 1.0f;
         _clients[i].speed_mod = 1.0f;
         _clients[i].upgrades = 0;
+        _clients[i].unlag = time_delta::zero;
     }
 
     _world.reset( );
@@ -978,6 +1129,72 @@ void session::command_connect(parser::text const& args)
     }
 }
 
+//------------------------------------------------------------------------------
+void session::command_status(parser::text const&)
+{
+    if (_match_server) {
+        _match_server->print_status();
+        return;
+    }
+
+    if (!svs.active) {
+        log::message("Server is not running.\n");
+        return;
+    }
+
+    for (std::size_t ii = 0; ii < svs.clients.size(); ++ii) {
+        if (!svs.clients[ii].active) {
+            continue;
+        }
+        log::message("%2zu: %-24s %s %lld ms\n", ii, svs.clients[ii].info.name.data(),
+                     svs.clients[ii].local ? "local " : "remote",
+                     svs.clients[ii].latency.to_milliseconds());
+    }
+
+    auto const& tick_stats = _tick_budget.get_stats();
+    log::message("ticks: %zu run, %zu overruns, %zu degraded, %lld ms max, degradation '%s', %zu events dropped\n",
+                 tick_stats.ticks, tick_stats.overruns, tick_stats.degraded, tick_stats.max_tick.to_milliseconds(),
+                 game::degradation_name(_tick_budget.level()), _world.num_dropped_events());
+
+    auto const& physics_stats = _world.physics_stats();
+    log::message("bodies: %zu awake, %zu sleeping, %zu static\n",
+                 physics_stats.awake, physics_stats.sleeping, physics_stats.static_bodies);
+    log::message("pairs: %zu overlapping, %zu false, %zu culled, %zu warm started, %zu gjk iterations\n",
+                 physics_stats.overlaps, physics_stats.false_overlaps, physics_stats.culled_overlaps,
+                 physics_stats.warm_started, physics_stats.gjk_iterations);
+
+    auto const& stats = svs.filter.stats();
+    log::message("connectionless: %zu requests, %zu replies, %zu address limited, %zu budget limited, %zu bad challenges\n",
+                 stats.requests, stats.responses, stats.address_limited, stats.response_limited, stats.bad_challenges);
+}
+
+//------------------------------------------------------------------------------
+void session::command_profile_capture(parser::text const& args)
+{
+    if (args.tokens().size() > 3) {
+        log::message("usage: profile_capture [frames] [filename]\n");
+        return;
+    }
+
+    if (profile::capturing()) {
+        log::message("A profile capture is already in progress.\n");
+        return;
+    }
+
+    int num_frames = 60;
+    if (args.tokens().size() > 1) {
+        num_frames = atoi(string::buffer(args.tokens()[1]).c_str());
+        if (num_frames <= 0) {
+            log::message("usage: profile_capture [frames] [filename]\n");
+            return;
+        }
+    }
+
+    string::buffer filename(args.tokens().size() > 2 ? args.tokens()[2] : string::view("profile.json"));
+    profile::capture(filename.c_str(), num_frames);
+    log::message("capturing %d frames to '%s'\n", num_frames, filename.c_str());
+}
+
 //------------------------------------------------------------------------------
 void session::print(log::level level, char const* msg)
 {
@@ -6,19 +6,26 @@
 #include "cm_string.h"
 #include "cm_time.h"
 #include "net_channel.h"
+#include "net_clock.h"
+#include "net_filter.h"
 #include "net_socket.h"
 #include "cm_console.h"
+#include "g_budget.h"
 
 namespace render {
 class image;
 class system;
 } // namespace render
 
+namespace game {
+class match_server;
+} // namespace game
+
 constexpr const time_delta RESTART_TIME = time_delta::from_seconds(5.0f);
 
 #define SPAWN_BUFFER    32
 
-#define PROTOCOL_VERSION    4
+#define PROTOCOL_VERSION    7
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace game {
@@ -36,10 +43,27 @@ typedef struct game_client_s
     usercmdgen input;
 
     time_value usercmd_time;
+    int usercmd_sequence;
+
+    //! number of previous commands sent redundantly in each packet
+    static constexpr int usercmd_backup = 4;
+    std::array<usercmd, usercmd_backup> usercmd_history;
 
-    static constexpr time_delta usercmd_rate = time_delta::from_hertz(60.0f);
+    //! commands are generated once per server frame
+    static constexpr time_delta usercmd_rate = FRAMETIME;
+
+    //! time by which player actions are advanced to compensate for latency
+    time_delta unlag;
+
+    //! apply an upgrade and the penalty to its complementary category
+    void apply_upgrade(int upgrade, float fraction, float penalty, float minimum);
 } game_client_t;
 
+//! number of upgrade categories
+constexpr int num_upgrades = 4;
+//! display names of upgrade categories
+extern char const* sz_upgrades[num_upgrades];
+
 //------------------------------------------------------------------------------
 constexpr color3 player_colors[] = {
     { 1.000f, 0.000f, 0.000f },     // 0: red
@@ -75,13 +99,15 @@ typedef enum netops_e
     clc_disconnect, //  disconnected
     clc_say,        //  message text
     clc_upgrade,    //  upgrade command
+    clc_ping,       //  clock sync request
 
     svc_disconnect, //  force disconnect
     svc_message,    //  message from server
     svc_score,      //  score update
     svc_info,       //  client info
     svc_snapshot,   //  game snapshot
-    svc_restart     //  game restart
+    svc_restart,    //  game restart
+    svc_pong        //  clock sync response
 } netops_t;
 
 //------------------------------------------------------------------------------
@@ -121,6 +147,9 @@ typedef struct client_s
 
     network::channel netchan;
     game::userinfo info;
+
+    game::usercmd_queue usercmds; //!< commands received from remote client
+    time_delta latency; //!< reported delay between server time and client view
 } client_t;
 
 //------------------------------------------------------------------------------
@@ -134,8 +163,34 @@ typedef struct server_state_s
     std::array<client_t, MAX_PLAYERS> clients;
 
     network::socket socket;
+    network::request_filter filter; //!< rate limits connectionless requests
 } server_state_t;
 
+//! write client info and score to a message as svc_info and svc_score
+void write_client_info(network::message& message, std::size_t index, client_t const& client, game_client_t const& game_client, int score);
+
+//
+// SERVER SIDE CLIENT MESSAGES
+//
+// Messages from remote clients are handled by the same functions on listen
+// servers and in the matches of dedicated servers.
+//
+
+//! read commands sent by a remote client into its command queue
+void read_client_command(network::message& message, client_t& client);
+
+//! respond to a ping from a remote client and update its latency and the lag
+//! compensation applied to its actions
+void read_client_ping(network::message& message, client_t& client, game_client_t& game_client, time_value time, time_delta max_unlag);
+
+//! read the name, color, and weapon sent by a remote client and apply them to
+//! its player if it has one, upgrades and modifiers are owned by the server
+void read_client_info(network::message& message, client_t& client, game::tank* player);
+
+//! apply an upgrade requested by a client and announce it to the host, returns
+//! false if the upgrade is invalid or the client has no upgrades remaining
+bool read_client_upgrade(world_host* host, client_t const& client, game_client_t& game_client, int upgrade, float fraction, float penalty, float minimum);
+
 //
 // CLIENT SIDE DATA
 //
@@ -167,15 +222,21 @@ typedef struct client_state_s
     time_value      ping_time;
     remote_server_t servers[MAX_SERVERS];
 
+    network::clock_sync clock; //!< synchronization with server clock
+    time_value clock_time; //!< time of most recent clock sync request
+
+    //! rate at which clock sync requests are sent to the server
+    static constexpr time_delta clock_rate = time_delta::from_milliseconds(250);
+
     network::socket socket;
 } client_state_t;
 
 //------------------------------------------------------------------------------
-class session : public log
+class session : public log, public world_host
 {
 public:
     session();
-    ~session() {}
+    ~session();
 
     result init (string::view cmdline);
     void shutdown ();
@@ -187,6 +248,10 @@ public:
 
     result run_frame(time_delta time);
 
+    //! block until there is network activity or the next server frame is
+    //! due, returns false if the session has nothing to wait on
+    bool wait_frame() const;
+
     void char_event(int key);
     void key_event(int key, bool down);
     void cursor_event(vec2 position);
@@ -197,7 +262,10 @@ public:
     void restart();
     void resume();
 
-    void add_score(std::size_t player_index, int score);
+    virtual game_client_t* client(std::size_t index) override { return _clients + index; }
+    virtual string::view client_name(std::size_t index) const override { return string::view(svs.clients[index].info.name.data()); }
+
+    virtual void add_score(std::size_t player_index, int score) override;
 
     bool _menu_active;
     bool _dedicated;
@@ -226,6 +294,18 @@ private:
 
     config::scalar _timescale;
 
+    config::integer _cl_time_nudge;
+    config::integer _sv_max_unlag;
+
+    config::integer _sv_matches;
+    config::integer _sv_threads;
+
+    //! hosts multiple matches when running as a dedicated server
+    std::unique_ptr<game::match_server> _match_server;
+
+    //! degrades the server when world frames take too long
+    game::tick_budget _tick_budget;
+
     console _console;
 
     game_mode _mode;
@@ -250,6 +330,18 @@ private:
 
     void draw_netgraph();
 
+    config::boolean _cl_particle_stats;
+    void draw_particle_stats();
+
+    config::boolean _cl_frame_timing;
+    void draw_frame_timing();
+
+    config::boolean _cl_cull_stats;
+    void draw_cull_stats();
+
+    config::boolean _cl_profile;
+    void draw_profile();
+
     void spawn_player(std::size_t num);
 
     message_t _messages[MAX_MESSAGES];
@@ -262,7 +354,7 @@ private:
     std::array<std::size_t, 256> _net_bytes;
 
 public:
-    void write_message (string::view message, bool broadcast=true);
+    virtual void write_message (string::view message, bool broadcast=true) override;
     void write_message_client(string::view message) { write_message(message, false); }
 
     game_client_t _clients[MAX_PLAYERS];
@@ -291,11 +383,15 @@ public:
     console_command _command_quit;
     console_command _command_disconnect;
     console_command _command_connect;
+    console_command _command_status;
+    console_command _command_profile_capture;
 
 private:
     static void command_quit(parser::text const& args);
     void command_disconnect(parser::text const& args);
     void command_connect(parser::text const& args);
+    void command_status(parser::text const& args);
+    void command_profile_capture(parser::text const& args);
 
     void get_packets ();
     void read_snapshot(network::message& message);
@@ -313,16 +409,22 @@ private:
     void client_packet(network::message& message);
 
     void connect_ack(string::view message_string);
+    void challenge_ack(string::view message_string);
 
+    void challenge_send(network::address const& remote);
     void client_connect(network::address const& remote, string::view message_string);
     void client_connect(network::address const& remote, string::view message_string, std::size_t client);
     void client_disconnect(std::size_t client);
-    void client_command(network::message& message, std::size_t client);
+    void client_think();
 
     void read_upgrade(std::size_t client, int upgrade);
     void write_upgrade(int upgrade);
 
     void client_send ();
+    void read_pong(network::message& message);
+
+    //! client view delay behind the estimated server time
+    time_delta view_delay() const;
 
     void info_send(network::address const& remote);
     void info_get(network::address const& remote, string::view message_string);
@@ -12,7 +12,14 @@
 namespace game {
 
 physics::material tank::_material(0.5f, 1.0f, 5.0f);
-physics::box_shape tank::_shape(vec2(24, 16));
+
+//! convex hull of the treads, chassis, and barrels of `tank_body_model`
+vec2 const tank_hull[] = {
+    {-13.5f, -8.f}, {-10.f, -9.f}, { 10.f, -9.f}, { 12.f, -8.f},
+    { 12.f,   8.f}, { 10.f,  9.f}, {-10.f,  9.f}, {-13.5f, 8.f},
+};
+
+physics::polygon_shape tank::_shape(tank_hull);
 
 //------------------------------------------------------------------------------
 tank::tank()
@@ -36,10 +43,6 @@ tank::tank()
     _model = &tank_body_model;
     _turret_model = &tank_turret_model;
 
-    for (auto& chan : _channels) {
-        chan = pSound->allocate_channel();
-    }
-
     _sound_idle = pSound->load_sound("assets/sound/tank_idle.wav");
     _sound_move = pSound->load_sound("assets/sound/tank_move.wav");
     _sound_turret_move = pSound->load_sound("assets/sound/turret_move.wav");
@@ -60,9 +63,23 @@ tank::~tank()
 }
 
 //------------------------------------------------------------------------------
-void tank::draw(render::system* renderer, time_value time) const
+void tank::draw(render::system* renderer, time_value time, draw_pass pass) const
 {
-    float lerp = (time - _world->framenum() * FRAMETIME) / FRAMETIME;
+    vec2 pos = get_position(time);
+    color4 color = _damage >= 1.0f ? color4(0.3f,0.3f,0.3f,1) : _color;
+
+    // bodies and turrets are drawn in separate passes so that the renderer
+    // can draw the same model for every tank at once
+
+    if (pass == draw_pass::models) {
+        renderer->draw_model(_model, mat3::transform(pos, get_rotation(time)), color);
+        return;
+    } else if (pass == draw_pass::attachments) {
+        renderer->draw_model(_turret_model, mat3::transform(pos, get_turret_rotation(time)), color);
+        return;
+    } else if (_damage >= 1.0f) {
+        return;
+    }
 
     time_delta denominator = _weapon == weapon_type::cannon ? cannon_reload :
                              _weapon == weapon_type::missile ? missile_reload :
@@ -71,16 +88,6 @@ void tank::draw(render::system* renderer, time_value time) const
     float reload = 20.0f * clamp((time - _fire_time) * _client->refire_mod / denominator, 0.0f, 1.0f);
     float health = 20.0f * clamp(1.0f - _damage, 0.0f, 1.0f);
 
-    if ( lerp > 1.0f ) {
-        lerp = 1.0f;
-    } else if ( lerp < 0.0f ) {
-        lerp = 0.0f;
-    }
-
-    vec2 pos = get_position(time);
-    float angle = get_rotation(time);
-    float tangle = get_turret_rotation(time);
-
     color4 color_health;
     color4 color_reload;
 
@@ -94,24 +101,23 @@ void tank::draw(render::system* renderer, time_value time) const
     color_reload.b = ( reload == 20.0f ? 1.0f : 0.0f );
     color_reload.a = 1.0f;
 
-    if (_damage >= 1.0f)
-    {
-        renderer->draw_model(_model, mat3::transform(pos, angle), color4(0.3f,0.3f,0.3f,1));
-        renderer->draw_model(_turret_model, mat3::transform(pos, tangle), color4(0.3f,0.3f,0.3f,1));
-        return;
-    }
-
     // status bars
 
     renderer->draw_box(vec2(20,2), pos + vec2(0,25), color4(0.5,0.5,0.5,1));
     renderer->draw_box(vec2(reload,2), pos + vec2(0,25), color_reload);
     renderer->draw_box(vec2(20,2), pos + vec2(0,22), color4(0.5,0.5,0.5,1));
     renderer->draw_box(vec2(health,2), pos + vec2(0,22), color_health);
+}
 
-    // actual body
+//------------------------------------------------------------------------------
+bounds tank::get_bounds(time_value time) const
+{
+    vec2 pos = get_position(time);
 
-    renderer->draw_model(_model, mat3::transform(pos, angle), _color);
-    renderer->draw_model(_turret_model, mat3::transform(pos, tangle), _color);
+    // body, turret and status bars
+    return _model->calculate_bounds(mat3::transform(pos, get_rotation(time)))
+         | _turret_model->calculate_bounds(mat3::transform(pos, get_turret_rotation(time)))
+         | bounds(pos + vec2(-10, 21), pos + vec2(10, 26));
 }
 
 //------------------------------------------------------------------------------
@@ -163,10 +169,10 @@ void tank::collide(tank* other, physics::collision const* collision)
 
     if (other->_damage >= 1.0f)
     {
-        g_Game->add_score(_player_index, 1);
+        _world->host()->add_score(_player_index, 1);
         other->_dead_time = _world->frametime();
 
-        g_Game->write_message( va("%s got a little too cozy with %s.", other->player_name().c_str(), player_name().c_str() ) );
+        _world->host()->write_message( va("%s got a little too cozy with %s.", other->player_name().c_str(), player_name().c_str() ) );
     }
 }
 
@@ -258,6 +264,11 @@ void tank::launch_projectile()
 
     time_value const time = _world->frametime();
 
+    // server is over budget and limiting projectiles
+    if (!_world->can_spawn_projectile()) {
+        return;
+    }
+
     switch (_weapon) {
         case weapon_type::cannon: {
             if ((_fire_time + cannon_reload / _client->refire_mod) < time) {
@@ -269,7 +280,7 @@ void tank::launch_projectile()
                 vec2 launch_direction = rotate(vec2(1, 0), launch_rotation);
                 vec2 launch_position = get_position() + rotate(effect_origin, _turret_rotation);
 
-                proj->set_position(launch_position, true);
+                proj->set_position(unlag_position(launch_position, launch_direction * cannon_speed), true);
                 proj->set_linear_velocity(launch_direction * cannon_speed);
 
                 _world->add_sound(_sound_cannon_fire, launch_position);
@@ -293,7 +304,7 @@ void tank::launch_projectile()
                 vec2 launch_direction = rotate(vec2(1, 0), _turret_rotation);
                 vec2 launch_position = get_position() + rotate(effect_origin, _turret_rotation);
 
-                proj->set_position(launch_position, true);
+                proj->set_position(unlag_position(launch_position, launch_direction * missile_speed), true);
                 proj->set_linear_velocity(launch_direction * missile_speed);
 
                 _world->add_sound(_sound_cannon_fire, launch_position);
@@ -311,7 +322,7 @@ void tank::launch_projectile()
                 vec2 launch_direction = rotate(vec2(1, 0), launch_rotation);
                 vec2 launch_position = get_position() + rotate(effect_origin, _turret_rotation);
 
-                proj->set_position(launch_position, true);
+                proj->set_position(unlag_position(launch_position, launch_direction * blaster_speed), true);
                 proj->set_linear_velocity(launch_direction * blaster_speed);
 
                 _world->add_sound(_sound_blaster_fire, launch_position);
@@ -330,6 +341,19 @@ void tank::launch_projectile()
     }
 }
 
+//------------------------------------------------------------------------------
+vec2 tank::unlag_position(vec2 position, vec2 velocity) const
+{
+    // remote players issue commands in response to a delayed view of the world
+    // so advance their projectiles by that delay, stopping at any obstruction
+    if (_client->unlag <= time_delta::zero) {
+        return position;
+    }
+
+    vec2 end = position + velocity * _client->unlag.to_seconds();
+    return position + (end - position) * _world->trace(position, end, this);
+}
+
 //------------------------------------------------------------------------------
 void tank::update_effects()
 {
@@ -385,7 +409,7 @@ void tank::read_snapshot(network::message const& message)
     _old_turret_rotation = get_turret_rotation();
 
     _player_index = message.read_byte();
-    _client = g_Game->_clients + _player_index;
+    _client = _world->host()->client(_player_index);
     _world->_players[_player_index] = this;
     _color.r = message.read_float();
     _color.g = message.read_float();
@@ -444,6 +468,18 @@ void tank::update_usercmd(game::usercmd usercmd)
 //------------------------------------------------------------------------------
 void tank::update_sound()
 {
+    // headless worlds may be updated on worker threads
+    if (_world->headless()) {
+        return;
+    }
+
+    // channels are allocated on first use
+    for (auto& chan : _channels) {
+        if (!chan) {
+            chan = pSound->allocate_channel();
+        }
+    }
+
     // engine noise
     if (_channels[0]) {
         if (_damage < 1.0f) {
@@ -498,7 +534,7 @@ string::view tank::player_name() const
               int(_color.r * 15.5f),
               int(_color.g * 15.5f),
               int(_color.b * 15.5f),
-              g_Game->svs.clients[_player_index].info.name.data());
+              _world->host()->client_name(_player_index).c_str());
 }
 
 } // namespace game
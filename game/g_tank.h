@@ -20,7 +20,8 @@ public:
     tank();
     ~tank();
 
-    virtual void draw(render::system* renderer, time_value time) const override;
+    virtual void draw(render::system* renderer, time_value time, draw_pass pass) const override;
+    virtual bounds get_bounds(time_value time) const override;
     virtual bool touch(object *other, physics::collision const* collision) override;
     virtual void think() override;
 
@@ -68,11 +69,14 @@ protected:
 
     void launch_projectile();
 
+    //! Returns the launch position advanced by the owning player's latency
+    vec2 unlag_position(vec2 position, vec2 velocity) const;
+
     void update_effects();
 
 protected:
     static physics::material _material;
-    static physics::box_shape _shape;
+    static physics::polygon_shape _shape;
 
     constexpr static float cannon_speed = 1920.0f;
     constexpr static float missile_speed = 288.0f;
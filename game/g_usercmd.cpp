@@ -88,4 +88,122 @@ usercmd usercmdgen::generate() const
     return cmd;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+constexpr int axis_max = (1 << (usercmd::axis_bits - 1)) - 1;
+
+//------------------------------------------------------------------------------
+int quantize_axis(float value)
+{
+    return static_cast<int>(std::round(clamp(value, -1.f, 1.f) * axis_max));
+}
+
+//------------------------------------------------------------------------------
+float dequantize_axis(int value)
+{
+    return clamp(value, -axis_max, axis_max) * (1.f / axis_max);
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+void usercmd::write(network::message& message) const
+{
+    message.write_bits(quantize_axis(move.x), -axis_bits);
+    message.write_bits(quantize_axis(move.y), -axis_bits);
+    message.write_bits(quantize_axis(look.x), -axis_bits);
+    message.write_bits(quantize_axis(look.y), -axis_bits);
+    message.write_bits(static_cast<int>(action), action_bits);
+}
+
+//------------------------------------------------------------------------------
+usercmd usercmd::read(network::message const& message)
+{
+    usercmd cmd{};
+
+    cmd.move.x = dequantize_axis(message.read_bits(-axis_bits));
+    cmd.move.y = dequantize_axis(message.read_bits(-axis_bits));
+    cmd.look.x = dequantize_axis(message.read_bits(-axis_bits));
+    cmd.look.y = dequantize_axis(message.read_bits(-axis_bits));
+    cmd.action = static_cast<decltype(cmd.action)>(message.read_bits(action_bits));
+
+    return cmd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+void usercmd_queue::reset()
+{
+    for (auto& entry : _buffer) {
+        entry.sequence = -1;
+    }
+
+    _sequence = 0;
+    _newest = -1;
+    _synchronized = false;
+    _last = {};
+    _num_dropped = 0;
+    _num_repeated = 0;
+}
+
+//------------------------------------------------------------------------------
+bool usercmd_queue::insert(int sequence, usercmd const& cmd)
+{
+    if (sequence < 0 || sequence > max_sequence) {
+        return false;
+    }
+
+    if (!_synchronized) {
+        _sequence = sequence;
+        _newest = sequence - 1;
+        _synchronized = true;
+    }
+
+    // already removed or already buffered
+    if (sequence < _sequence || _buffer[sequence % capacity].sequence == sequence) {
+        return false;
+    }
+
+    // too far ahead of the queue, discard everything older than capacity
+    if (sequence - _sequence >= capacity) {
+        _num_dropped += sequence - capacity + 1 - _sequence;
+        _sequence = sequence - capacity + 1;
+    }
+
+    _buffer[sequence % capacity] = {sequence, cmd};
+    _newest = std::max(_newest, sequence);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool usercmd_queue::next(usercmd& cmd)
+{
+    if (!_synchronized) {
+        return false;
+    }
+
+    // skip ahead if the client has gotten too far ahead of the server
+    if (_newest - _sequence >= max_latency) {
+        _num_dropped += _newest - _sequence - max_latency + 1;
+        _sequence = _newest - max_latency + 1;
+    }
+
+    // skip over commands that were lost despite redundancy
+    while (_sequence <= _newest && _buffer[_sequence % capacity].sequence != _sequence) {
+        ++_num_dropped;
+        ++_sequence;
+    }
+
+    if (_sequence <= _newest) {
+        _last = _buffer[_sequence % capacity].cmd;
+        ++_sequence;
+    } else {
+        ++_num_repeated;
+    }
+
+    cmd = _last;
+    return true;
+}
+
 } // namespace game
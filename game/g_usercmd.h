@@ -5,9 +5,15 @@
 
 #include "cm_vector.h"
 
+#include <array>
+#include <climits>
 #include <cstdint>
 #include <map>
 
+namespace network {
+class message;
+} // namespace network
+
 ////////////////////////////////////////////////////////////////////////////////
 namespace game {
 
@@ -38,6 +44,74 @@ struct usercmd
     vec2 move; //!< right/left, forward/back
     vec2 look; //!< turret right/left, _
     action action;
+
+    //! number of bits used to quantize each axis of `move` and `look`
+    static constexpr int axis_bits = 6;
+    //! number of bits used to encode `action`
+    static constexpr int action_bits = 1;
+    //! number of bits used to encode a command
+    static constexpr int bits = 4 * axis_bits + action_bits;
+
+    //! write quantized command to the message
+    void write(network::message& message) const;
+    //! read quantized command from the message
+    static usercmd read(network::message const& message);
+};
+
+//------------------------------------------------------------------------------
+//! Sequenced queue of user commands received from a remote client. Commands
+//! are sent redundantly so duplicates are discarded on insertion, and commands
+//! are removed in sequence at a rate of one per server frame.
+class usercmd_queue
+{
+public:
+    //! maximum number of commands that can be buffered
+    static constexpr int capacity = 32;
+    //! maximum number of commands to buffer before skipping ahead
+    static constexpr int max_latency = 4;
+    //! largest sequence number accepted, sequence numbers come from remote
+    //! clients and are limited so that arithmetic on them cannot overflow
+    static constexpr int max_sequence = INT_MAX - capacity;
+
+    usercmd_queue() { reset(); }
+
+    //! discard all buffered commands and resynchronize on next insertion
+    void reset();
+
+    //! insert a command, returns false if command was already received or
+    //! if the sequence number is outside of [0, max_sequence]
+    bool insert(int sequence, usercmd const& cmd);
+
+    //! remove the next command in sequence, or repeat the most recent command
+    //! if the next command has not been received. returns false if no command
+    //! has ever been received.
+    bool next(usercmd& cmd);
+
+    //! number of buffered commands
+    int size() const { return _newest - _sequence + 1; }
+
+    //! number of commands that were never received
+    int num_dropped() const { return _num_dropped; }
+
+    //! number of frames that repeated a previous command
+    int num_repeated() const { return _num_repeated; }
+
+protected:
+    struct entry {
+        int sequence;
+        usercmd cmd;
+    };
+
+    std::array<entry, capacity> _buffer;
+
+    int _sequence; //!< sequence number of the next command to remove
+    int _newest; //!< sequence number of the newest received command
+    bool _synchronized; //!< true if any command has been received
+
+    usercmd _last; //!< most recently removed command
+
+    int _num_dropped;
+    int _num_repeated;
 };
 
 //------------------------------------------------------------------------------
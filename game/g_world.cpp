@@ -16,20 +16,35 @@ namespace game {
 
 //------------------------------------------------------------------------------
 world::world()
-    : _spawn_id(0)
+    : _host(nullptr)
+    , _headless(false)
+    , _spawn_id(0)
+    , _num_projectiles(0)
+    , _projectile_limit(0)
+    , _drop_cosmetic_effects(false)
+    , _drop_sounds(false)
+    , _num_dropped_events(0)
     , _players{}
     , _border_material{0,0}
     , _border_shapes{{vec2(0,0)}, {vec2(0,0)}}
     , _arena_width("g_arenaWidth", 640, config::archive|config::server|config::reset, "arena width")
     , _arena_height("g_arenaHeight", 480, config::archive|config::server|config::reset, "arena height")
+    , _lightweight_projectiles("g_lightweightProjectiles", true, config::archive|config::server, "move projectiles with segment queries instead of rigid bodies")
+    , _particle_budget("cl_particleBudget", 8192, config::archive, "maximum number of particles")
+    , _particle_stats{}
+    , _object_stats{}
+    , _particles_dropped(0)
     , _physics(
         std::bind(&world::physics_filter_callback, this, std::placeholders::_1, std::placeholders::_2),
         std::bind(&world::physics_collide_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3))
 {}
 
 //------------------------------------------------------------------------------
-void world::init()
+void world::init(world_host* host, bool headless)
 {
+    _host = host;
+    _headless = headless;
+
     reset();
 }
 
@@ -99,16 +114,39 @@ void world::remove(game::object* object)
 //------------------------------------------------------------------------------
 void world::draw(render::system* renderer, time_value time) const
 {
+    PROFILE_ZONE("world::draw");
+
+    render::view const& view = renderer->view();
+    bounds view_bounds = bounds::from_center(view.origin, view.size);
+
+    // objects entirely outside of the view are not submitted to the renderer
+    _object_stats = {};
+    _visible_objects.clear();
     for (auto& obj : _objects) {
-        obj->draw(renderer, time);
+        if (obj->get_bounds(time).intersects(view_bounds)) {
+            _visible_objects.push_back(obj.get());
+            ++_object_stats.drawn;
+        } else {
+            ++_object_stats.culled;
+        }
+    }
+
+    // each pass is drawn for all objects before the next so that draws of the
+    // same model are consecutive and can be instanced by the renderer
+    for (auto pass : {draw_pass::models, draw_pass::attachments, draw_pass::overlays}) {
+        for (auto obj : _visible_objects) {
+            obj->draw(renderer, time, pass);
+        }
     }
 
-    draw_particles(renderer, time);
+    draw_particles(renderer, time, view_bounds);
 }
 
 //------------------------------------------------------------------------------
 void world::run_frame()
 {
+    PROFILE_ZONE("world::run_frame");
+
     _message.reset();
 
     ++_framenum;
@@ -128,6 +166,7 @@ void world::run_frame()
         obj->_old_position = obj->get_position();
         obj->_old_rotation = obj->get_rotation();
     }
+    move_projectiles(FRAMETIME.to_seconds());
     _physics.step(FRAMETIME.to_seconds());
 
     for (auto& obj : _pending) {
@@ -239,7 +278,7 @@ void world::read_effect(network::message const& message)
 }
 
 //------------------------------------------------------------------------------
-void world::write_snapshot(network::message& message) const
+void world::write_snapshot(network::message& message, network::message& events) const
 {
     message.write_byte(svc_snapshot);
 
@@ -261,12 +300,23 @@ void world::write_snapshot(network::message& message) const
     message.write(_message);
     message.write_byte(narrow_cast<uint8_t>(message_type::none));
 
+    // write sounds and effects without a frame
+    _message.rewind();
+    events.write_byte(svc_snapshot);
+    events.write(_message);
+    events.write_byte(narrow_cast<uint8_t>(message_type::none));
+
     _message.rewind();
 }
 
 //------------------------------------------------------------------------------
 void world::write_sound(sound::asset sound_asset, vec2 position, float volume)
 {
+    if (_drop_sounds) {
+        ++_num_dropped_events;
+        return;
+    }
+
     _message.write_byte(narrow_cast<uint8_t>(message_type::sound));
     _message.write_long(narrow_cast<int>(sound_asset));
     _message.write_vector(position);
@@ -276,6 +326,20 @@ void world::write_sound(sound::asset sound_asset, vec2 position, float volume)
 //------------------------------------------------------------------------------
 void world::write_effect(time_value time, effect_type type, vec2 position, vec2 direction, float strength)
 {
+    if (_drop_cosmetic_effects) {
+        switch (type) {
+            case effect_type::smoke:
+            case effect_type::sparks:
+            case effect_type::blaster:
+            case effect_type::missile_trail:
+                ++_num_dropped_events;
+                return;
+
+            default:
+                break;
+        }
+    }
+
     _message.write_byte(narrow_cast<uint8_t>(message_type::effect));
     _message.write_float(time.to_seconds());
     _message.write_byte(narrow_cast<uint8_t>(type));
@@ -349,27 +413,109 @@ game::object* world::find_object(std::size_t spawn_id) const
     return nullptr;
 }
 
+//------------------------------------------------------------------------------
+float world::trace(vec2 start, vec2 end, game::object const* ignore) const
+{
+    float fraction = 1.0f;
+
+    for (auto const& pair : _physics_objects) {
+        game::object const* obj = pair.second;
+        game::object const* owner = obj->_owner ? obj->_owner : obj;
+
+        if (obj->_type == object_type::projectile || (ignore && owner == ignore)) {
+            continue;
+        }
+
+        fraction = std::min(fraction, physics::trace(pair.first, start, end).get_fraction());
+    }
+
+    return fraction;
+}
+
 //------------------------------------------------------------------------------
 void world::add_sound(sound::asset sound_asset, vec2 position, float volume)
 {
     write_sound(sound_asset, position, volume);
-    pSound->play(sound_asset, vec3(position), volume, 1.0f);
+    if (!_headless) {
+        pSound->play(sound_asset, vec3(position), volume, 1.0f);
+    }
 }
 
 //------------------------------------------------------------------------------
 void world::add_body(game::object* owner, physics::rigid_body* body)
 {
-    _physics.add_body(body);
+    if (owner->_type == object_type::projectile) {
+        ++_num_projectiles;
+    }
+    if (owner->_type == object_type::projectile && _lightweight_projectiles) {
+        _projectiles.push_back(owner);
+    } else {
+        _physics.add_body(body);
+    }
     _physics_objects[body] = owner;
 }
 
 //------------------------------------------------------------------------------
 void world::remove_body(physics::rigid_body* body)
 {
-    _physics.remove_body(body);
+    auto owner = _physics_objects.find(body);
+    if (owner != _physics_objects.end() && owner->second->_type == object_type::projectile) {
+        --_num_projectiles;
+    }
+
+    auto it = std::find_if(_projectiles.begin(), _projectiles.end(), [body](game::object* obj) {
+        return &obj->_rigid_body == body;
+    });
+
+    if (it != _projectiles.end()) {
+        _projectiles.erase(it);
+    } else {
+        _physics.remove_body(body);
+    }
     _physics_objects.erase(body);
 }
 
+//------------------------------------------------------------------------------
+void world::set_dropped_events(bool cosmetic_effects, bool sounds)
+{
+    _drop_cosmetic_effects = cosmetic_effects;
+    _drop_sounds = sounds;
+}
+
+//------------------------------------------------------------------------------
+void world::move_projectiles(float delta_time)
+{
+    _projectile_segments.resize(_projectiles.size());
+    for (std::size_t ii = 0; ii < _projectiles.size(); ++ii) {
+        vec2 start = _projectiles[ii]->get_position();
+        vec2 end = start + _projectiles[ii]->get_linear_velocity() * delta_time;
+        _projectile_segments[ii] = {start, end};
+    }
+
+    _physics.trace_segments(_projectile_segments, _projectile_hits,
+        [this](std::size_t index, physics::rigid_body const* body) {
+            return physics_filter_callback(&_projectiles[index]->_rigid_body, body);
+        });
+
+    // projectiles may be removed by touch but are not destroyed until the
+    // next frame so the list of projectiles does not change while iterating
+    for (std::size_t ii = 0; ii < _projectiles.size(); ++ii) {
+        game::object* obj = _projectiles[ii];
+        physics::world::segment_hit const& hit = _projectile_hits[ii];
+
+        if (hit.body) {
+            physics::collision c = physics::collision(hit.contact);
+            c.impulse = _physics.collision_impulse(&obj->_rigid_body, hit.body, c);
+
+            if (physics_collide_callback(&obj->_rigid_body, hit.body, c)) {
+                _physics_objects[hit.body]->apply_impulse(c.impulse, c.point);
+            }
+        }
+
+        obj->_rigid_body.set_position(_projectile_segments[ii].end);
+    }
+}
+
 //------------------------------------------------------------------------------
 bool world::physics_filter_callback(physics::rigid_body const* body_a, physics::rigid_body const* body_b)
 {
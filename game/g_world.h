@@ -17,6 +17,7 @@
 #include "r_particle.h"
 
 #include <array>
+#include <deque>
 #include <memory>
 #include <set>
 #include <type_traits>
@@ -48,6 +49,21 @@ enum class effect_type
     explosion,
 };
 
+//------------------------------------------------------------------------------
+//! Interface to the session or match which hosts a world. Objects use this to
+//! access player state and to report game events.
+class world_host
+{
+public:
+    virtual ~world_host() {}
+
+    virtual game_client_t* client(std::size_t index) = 0;
+    virtual string::view client_name(std::size_t index) const = 0;
+
+    virtual void add_score(std::size_t player_index, int score) = 0;
+    virtual void write_message(string::view message, bool broadcast = true) = 0;
+};
+
 //------------------------------------------------------------------------------
 class world
 {
@@ -55,17 +71,40 @@ public:
     world ();
     ~world () {}
 
-    void init();
+    //! initialize world, headless worlds are only simulated and do not
+    //! generate particles or play sounds locally
+    void init(world_host* host, bool headless = false);
     void shutdown();
     void reset();
 
     void clear_particles();
 
+    //! Particle counts for the most recently drawn frame
+    struct particle_stats {
+        std::size_t alive; //!< particles simulated, including culled particles
+        std::size_t culled; //!< particles outside of the view which were not drawn
+        std::size_t spawned; //!< particles added since the previous frame
+        std::size_t evicted; //!< visible particles removed to stay within budget
+        std::size_t dropped; //!< particles not spawned because the budget was full
+    };
+
+    particle_stats const& get_particle_stats() const { return _particle_stats; }
+
+    //! Object counts for the most recently drawn frame
+    struct object_stats {
+        std::size_t drawn; //!< objects which intersect the view
+        std::size_t culled; //!< objects outside of the view which were not drawn
+    };
+
+    object_stats const& get_object_stats() const { return _object_stats; }
+
     void run_frame ();
     void draw(render::system* renderer, time_value time) const;
 
     void read_snapshot(network::message& message);
-    void write_snapshot(network::message& message) const;
+    //! write the full snapshot to `message` and only the sounds and effects to
+    //! `events`, for clients which skip the object state of this frame
+    void write_snapshot(network::message& message, network::message& events) const;
 
     std::vector<std::unique_ptr<object>> const& objects() { return _objects; }
 
@@ -74,6 +113,10 @@ public:
 
     game::object* find_object(std::size_t spawn_id) const;
 
+    //! Returns the fraction of the segment from `start` to `end` that is not
+    //! obstructed by any object except projectiles and objects owned by `ignore`
+    float trace(vec2 start, vec2 end, game::object const* ignore = nullptr) const;
+
     random& get_random() { return _random; }
 
     void remove(object* object);
@@ -88,14 +131,34 @@ public:
     void add_body(game::object* owner, physics::rigid_body* body);
     void remove_body(physics::rigid_body* body);
 
+    //! stop writing cosmetic effects and/or sounds to snapshots, events are
+    //! still played locally by non-headless worlds
+    void set_dropped_events(bool cosmetic_effects, bool sounds);
+    //! limit the number of projectiles that can be launched, zero for no limit
+    void set_projectile_limit(std::size_t limit) { _projectile_limit = limit; }
+    //! returns true if the projectile limit allows another projectile
+    bool can_spawn_projectile() const { return !_projectile_limit || _num_projectiles < _projectile_limit; }
+    //! number of events which were not written to snapshots
+    std::size_t num_dropped_events() const { return _num_dropped_events; }
+
     vec2 mins() const { return _mins; }
     vec2 maxs() const { return _maxs; }
     int framenum() const { return _framenum; }
+    physics::world::stats const& physics_stats() const { return _physics.get_stats(); }
     time_value frametime() const { return time_value(_framenum * FRAMETIME); }
 
     game::tank* player( std::size_t index ) { return _players[ index ]; }
 
+    world_host* host() const { return _host; }
+    bool headless() const { return _headless; }
+
 private:
+    //! Session or match which hosts this world
+    world_host* _host;
+
+    //! World is simulated without presentation
+    bool _headless;
+
     //! Active objects in the world
     std::vector<std::unique_ptr<object>> _objects;
 
@@ -105,12 +168,30 @@ private:
     //! Objects pending removal
     std::set<object*> _removed;
 
+    //! Objects inside the view for the current draw
+    mutable std::vector<object const*> _visible_objects;
+
     //! Previous object spawn id
     std::size_t _spawn_id;
 
     physics::world _physics;
     std::map<physics::rigid_body const*, game::object*> _physics_objects;
 
+    //! Projectiles which are moved by segment queries instead of being
+    //! simulated as rigid bodies in `_physics`
+    std::vector<game::object*> _projectiles;
+    std::vector<physics::world::segment> _projectile_segments;
+    std::vector<physics::world::segment_hit> _projectile_hits;
+
+    void move_projectiles(float delta_time);
+
+    std::size_t _num_projectiles; //!< all projectiles, including rigid bodies
+    std::size_t _projectile_limit;
+
+    bool _drop_cosmetic_effects;
+    bool _drop_sounds;
+    std::size_t _num_dropped_events;
+
     //! Random number generator
     random _random;
 
@@ -121,6 +202,8 @@ private:
 
     config::integer _arena_width;
     config::integer _arena_height;
+    config::boolean _lightweight_projectiles;
+    config::integer _particle_budget;
 
     friend game::tank;
 
@@ -130,12 +213,22 @@ private:
     // particle system
     //
 
-    mutable std::vector<render::particle> _particles;
+    //! particles added since the last draw, a deque so that pointers
+    //! returned by `add_particle` remain valid while more are added
+    mutable std::deque<render::particle> _new_particles;
+    mutable render::particle_store _particles;
+    mutable particle_stats _particle_stats;
+    mutable object_stats _object_stats;
+    mutable std::size_t _particles_dropped; //!< particles dropped since the last draw
 
+    //! Returns a new particle or NULL if the particle budget is full
     render::particle* add_particle(time_value time);
-    void free_particle (render::particle* particle) const;
 
-    void draw_particles(render::system* renderer, time_value time) const;
+    //! Fraction of their full particle count that effects should spawn, which
+    //! decreases as the particle budget fills
+    float particle_detail() const;
+
+    void draw_particles(render::system* renderer, time_value time, bounds const& view) const;
 
     vec2        _mins;
     vec2        _maxs;
@@ -0,0 +1,61 @@
+// net_clock.cpp
+//
+
+#include "net_clock.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace network {
+
+//------------------------------------------------------------------------------
+void clock_sync::reset()
+{
+    _samples = {};
+    _sample_count = 0;
+
+    _offset = time_delta::zero;
+    _round_trip = time_delta::zero;
+    _jitter = time_delta::zero;
+}
+
+//------------------------------------------------------------------------------
+void clock_sync::add_sample(time_value t0, time_value t1, time_value t2, time_value t3)
+{
+    // round trip delay excluding time spent processing on the remote host
+    time_delta delay = std::max<time_delta>((t3 - t0) - (t2 - t1), time_delta::zero);
+    // assumes that the forward and return paths have the same delay
+    time_delta offset = ((t1 - t0) + (t2 - t3)) / 2.0;
+
+    _samples[_sample_count % num_samples] = {offset, delay};
+
+    if (!_sample_count++) {
+        _offset = offset;
+        _round_trip = delay;
+        _jitter = time_delta::zero;
+        return;
+    }
+
+    // smoothed round trip delay and mean deviation, as in TCP
+    time_delta error = delay - _round_trip;
+    _round_trip += error / 8.0;
+    _jitter += (time_delta::from_microseconds(std::abs(error.to_microseconds())) - _jitter) / 4.0;
+
+    // select the sample with the smallest delay
+    int count = std::min(_sample_count, num_samples);
+    sample const* best = &_samples[0];
+    for (int ii = 1; ii < count; ++ii) {
+        if (_samples[ii].delay < best->delay) {
+            best = &_samples[ii];
+        }
+    }
+
+    time_delta correction = best->offset - _offset;
+    if (std::abs(correction.to_microseconds()) > step_threshold.to_microseconds()) {
+        _offset = best->offset;
+    } else {
+        _offset += correction / 8.0;
+    }
+}
+
+} // namespace network
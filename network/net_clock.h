@@ -0,0 +1,71 @@
+// net_clock.h
+//
+
+#pragma once
+
+#include "cm_time.h"
+
+#include <array>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace network {
+
+//------------------------------------------------------------------------------
+//! Estimates the offset between the local clock and a remote clock from
+//! timestamped request/response exchanges in the style of NTP. The offset is
+//! taken from the recent sample with the smallest round trip delay since it
+//! has the smallest error bound, and is slewed towards each new estimate so
+//! that the synchronized clock does not jump with every jitter spike.
+class clock_sync
+{
+public:
+    //! number of recent samples used by the clock filter
+    static constexpr int num_samples = 8;
+    //! offset error beyond which the clock is stepped instead of slewed
+    static constexpr time_delta step_threshold = time_delta::from_milliseconds(250);
+
+    clock_sync() { reset(); }
+
+    //! discard all samples
+    void reset();
+
+    //! add a sample from a completed exchange
+    //!   t0: local time the request was sent
+    //!   t1: remote time the request was received
+    //!   t2: remote time the response was sent
+    //!   t3: local time the response was received
+    void add_sample(time_value t0, time_value t1, time_value t2, time_value t3);
+
+    //! true if at least one sample has been received
+    bool synchronized() const { return _sample_count > 0; }
+
+    //! estimated remote time minus local time
+    time_delta offset() const { return _offset; }
+
+    //! smoothed round trip delay
+    time_delta round_trip() const { return _round_trip; }
+
+    //! mean deviation of the round trip delay
+    time_delta jitter() const { return _jitter; }
+
+    //! total number of samples received
+    int sample_count() const { return _sample_count; }
+
+    //! convert a local time to the estimated remote time
+    time_value remote_time(time_value local_time) const { return local_time + _offset; }
+
+protected:
+    struct sample {
+        time_delta offset;
+        time_delta delay;
+    };
+
+    std::array<sample, num_samples> _samples;
+    int _sample_count;
+
+    time_delta _offset;
+    time_delta _round_trip;
+    time_delta _jitter;
+};
+
+} // namespace network
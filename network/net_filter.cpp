@@ -0,0 +1,150 @@
+// net_filter.cpp
+//
+
+#include "net_filter.h"
+
+#include <algorithm>
+#include <random>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace network {
+
+namespace {
+
+//------------------------------------------------------------------------------
+uint64_t mix(uint64_t x)
+{
+    // splitmix64 finalizer
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+//------------------------------------------------------------------------------
+uint64_t hash_address(network::address const& address, bool include_port)
+{
+    uint64_t hash = mix(static_cast<uint64_t>(address.type));
+
+    switch (address.type) {
+        case network::address_type::ipv4:
+            for (std::size_t ii = 0; ii < address.ip4.size(); ++ii) {
+                hash = mix(hash ^ address.ip4[ii]);
+            }
+            break;
+
+        case network::address_type::ipv6:
+            for (std::size_t ii = 0; ii < address.ip6.size(); ++ii) {
+                hash = mix(hash ^ address.ip6[ii]);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (include_port) {
+        hash = mix(hash ^ address.port);
+    }
+    return hash;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+bool token_bucket::consume(time_value time)
+{
+    if (time > _time) {
+        _tokens = std::min(_burst, _tokens + _rate * (time - _time).to_seconds());
+        _time = time;
+    }
+
+    if (_tokens < 1.0f) {
+        return false;
+    }
+
+    _tokens -= 1.0f;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+request_filter::request_filter()
+{
+    reset();
+}
+
+//------------------------------------------------------------------------------
+void request_filter::reset()
+{
+    std::random_device device;
+    _secret = (static_cast<uint64_t>(device()) << 32) | device();
+
+    for (auto& bucket : _buckets) {
+        bucket = token_bucket(address_rate, address_burst);
+    }
+
+    _responses = token_bucket(response_rate, response_burst);
+    _stats = {};
+}
+
+//------------------------------------------------------------------------------
+bool request_filter::accept(network::address const& remote, time_value time)
+{
+    ++_stats.requests;
+
+    // spoofed requests can use any port so limit by host address only, the
+    // secret keeps remote hosts from choosing addresses in the same bucket.
+    // colliding addresses share a bucket rather than taking it over with a
+    // full burst, otherwise alternating addresses would never be limited
+    uint64_t key = mix(_secret ^ hash_address(remote, false));
+    token_bucket& bucket = _buckets[key % _buckets.size()];
+
+    if (!bucket.consume(time)) {
+        ++_stats.address_limited;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool request_filter::respond(time_value time)
+{
+    if (!_responses.consume(time)) {
+        ++_stats.response_limited;
+        return false;
+    }
+
+    ++_stats.responses;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+int request_filter::challenge(network::address const& remote, time_value time) const
+{
+    return epoch_challenge(remote, time.to_microseconds() / challenge_time.to_microseconds());
+}
+
+//------------------------------------------------------------------------------
+int request_filter::epoch_challenge(network::address const& remote, int64_t epoch) const
+{
+    uint64_t hash = mix(_secret ^ hash_address(remote, true));
+    hash = mix(hash ^ static_cast<uint64_t>(epoch));
+    // challenges are transmitted as text so keep them non-negative
+    return static_cast<int>(hash & 0x7fffffff);
+}
+
+//------------------------------------------------------------------------------
+bool request_filter::check_challenge(network::address const& remote, int value, time_value time)
+{
+    int64_t epoch = time.to_microseconds() / challenge_time.to_microseconds();
+
+    // accept challenges from the current and previous epoch so that a
+    // challenge is valid for at least `challenge_time`
+    if (value == epoch_challenge(remote, epoch) || value == epoch_challenge(remote, epoch - 1)) {
+        return true;
+    }
+
+    ++_stats.bad_challenges;
+    return false;
+}
+
+} // namespace network
@@ -0,0 +1,105 @@
+// net_filter.h
+//
+
+#pragma once
+
+#include "cm_time.h"
+#include "net_address.h"
+
+#include <array>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace network {
+
+//------------------------------------------------------------------------------
+//! Token bucket rate limiter. Tokens are added continuously at a fixed rate up
+//! to a maximum burst size, and each request consumes a single token.
+class token_bucket
+{
+public:
+    token_bucket()
+        : token_bucket(0.0f, 0.0f)
+    {}
+
+    token_bucket(float rate, float burst)
+        : _rate(rate)
+        , _burst(burst)
+        , _tokens(burst)
+        , _time(time_value::zero)
+    {}
+
+    //! consume a token if one is available at the given time
+    bool consume(time_value time);
+
+protected:
+    float _rate; //!< tokens added per second
+    float _burst; //!< maximum number of tokens
+    float _tokens; //!< number of tokens currently available
+    time_value _time; //!< time that tokens were last added
+};
+
+//------------------------------------------------------------------------------
+//! Filters unsequenced requests before they are parsed. Each source address
+//! is limited by its own token bucket and all replies are limited by a global
+//! token bucket so that spoofed floods can neither consume server time nor be
+//! reflected at a third party. Connection requests must echo a challenge that
+//! is derived from the source address and a server secret so that no state is
+//! kept for a remote host until it has proven that it can receive replies.
+class request_filter
+{
+public:
+    //! requests per second allowed from a single address
+    static constexpr float address_rate = 4.0f;
+    //! burst size allowed from a single address
+    static constexpr float address_burst = 8.0f;
+    //! replies per second allowed to all addresses
+    static constexpr float response_rate = 256.0f;
+    //! burst size allowed to all addresses
+    static constexpr float response_burst = 512.0f;
+    //! number of address buckets, addresses which hash to the same bucket
+    //! share its tokens
+    static constexpr std::size_t num_buckets = 1024;
+    //! duration for which a challenge is valid
+    static constexpr time_delta challenge_time = time_delta::from_seconds(5.0f);
+
+    struct counters {
+        std::size_t requests; //!< number of requests received
+        std::size_t address_limited; //!< requests dropped by per-address limit
+        std::size_t response_limited; //!< replies dropped by the global budget
+        std::size_t bad_challenges; //!< connect requests with an invalid challenge
+        std::size_t responses; //!< number of replies allowed
+    };
+
+public:
+    request_filter();
+
+    //! generate a new server secret and reset all buckets and counters
+    void reset();
+
+    //! returns true if a request from the remote address should be processed
+    bool accept(network::address const& remote, time_value time);
+
+    //! returns true if the global response budget allows a reply to be sent
+    bool respond(time_value time);
+
+    //! returns the challenge value for the remote address at the given time
+    int challenge(network::address const& remote, time_value time) const;
+
+    //! returns true if the challenge was issued to the remote address recently
+    bool check_challenge(network::address const& remote, int value, time_value time);
+
+    counters const& stats() const { return _stats; }
+
+protected:
+    std::array<token_bucket, num_buckets> _buckets;
+    token_bucket _responses;
+
+    uint64_t _secret;
+
+    counters _stats;
+
+protected:
+    int epoch_challenge(network::address const& remote, int64_t epoch) const;
+};
+
+} // namespace network
@@ -234,6 +234,15 @@ void message::write_vector(vec2 v)
     write_float(v.y);
 }
 
+//------------------------------------------------------------------------------
+void message::write_time(time_value t)
+{
+    int64_t microseconds = t.to_microseconds();
+
+    write_bits(static_cast<int>(microseconds & 0xffffffff), 32);
+    write_bits(static_cast<int>(microseconds >> 32), 32);
+}
+
 //------------------------------------------------------------------------------
 void message::write_string(char const* sz)
 {
@@ -314,6 +323,19 @@ vec2 message::read_vector() const
     return vec2(outx, outy);
 }
 
+//------------------------------------------------------------------------------
+time_value message::read_time() const
+{
+    if (_bytes_read + 8 > _bytes_written) {
+        return time_value::zero;
+    }
+
+    uint32_t lo = static_cast<uint32_t>(read_bits(32));
+    uint32_t hi = static_cast<uint32_t>(read_bits(32));
+
+    return time_value::from_microseconds(static_cast<int64_t>((static_cast<uint64_t>(hi) << 32) | lo));
+}
+
 //------------------------------------------------------------------------------
 char const* message::read_string() const
 {
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "cm_shared.h"
+#include "cm_time.h"
 
 #include <climits>
 #include <array>
@@ -82,6 +83,8 @@ public:
     void write_float(float f);
     //! write a two-dimensional vector
     void write_vector(vec2 v);
+    //! write a 64-bit time value
+    void write_time(time_value t);
     //! write a null-terminated string
     void write_string(char const* sz);
 
@@ -101,6 +104,8 @@ public:
     float read_float() const;
     //! read a two-dimensional vector
     vec2 read_vector() const;
+    //! read a 64-bit time value
+    time_value read_time() const;
     //! read a null-terminated string
     char const* read_string() const;
 
@@ -141,6 +141,27 @@ void socket::close()
     }
 }
 
+//------------------------------------------------------------------------------
+bool socket::wait(time_delta timeout) const
+{
+    if (!_socket) {
+        return false;
+    }
+
+    int64_t usec = timeout > time_delta::zero ? timeout.to_microseconds() : 0;
+
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(_socket, &readfds);
+
+    timeval tv;
+    tv.tv_sec = static_cast<long>(usec / 1000000);
+    tv.tv_usec = static_cast<long>(usec % 1000000);
+
+    // first parameter is ignored by winsock
+    return ::select(0, &readfds, nullptr, nullptr, &tv) > 0;
+}
+
 //------------------------------------------------------------------------------
 bool socket::read(network::address& remote, network::message& message)
 {
@@ -5,6 +5,7 @@
 
 #include "cm_shared.h"
 #include "cm_string.h"
+#include "cm_time.h"
 
 struct sockaddr_storage;
 
@@ -36,6 +37,10 @@ public:
     bool open(socket_type type, word port = socket_port::any);
     void close();
 
+    //! block until data is available to read or the timeout expires,
+    //! returns true if data is available
+    bool wait(time_delta timeout) const;
+
     //! read data info message and set remote address
     bool read(network::address& remote, network::message& message);
     //! write data to the remote address
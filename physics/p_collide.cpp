@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cfloat>
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace physics {
@@ -15,50 +16,129 @@ namespace physics {
 //------------------------------------------------------------------------------
 collide::motion_data::motion_data(motion const& motion)
     : physics::motion(motion)
+    , support_index(0)
 {
     local_to_world = mat3::transform(_position, _rotation);
     world_to_local = mat3::inverse_transform(_position, _rotation);
 }
 
 //------------------------------------------------------------------------------
-collide::collide(motion const& motion_a, motion const& motion_b)
-    : _motion{motion_a, motion_b}
+collide::collide(motion const& motion_a, motion const& motion_b, cache* cache)
+    : _num_iterations(0)
+    , _num_penetration_iterations(0)
+    , _motion{motion_a, motion_b}
 {
-    vec3 position = vec3_zero;
-    vec3 direction = vec3(_motion[1].get_position() - _motion[0].get_position());
-
-    float distance = minimum_distance(position, direction);
+    shape const* shape_a = motion_a.get_shape();
+    shape const* shape_b = motion_b.get_shape();
+    float radius_a = shape_a->get_type() == shape_type::circle ? static_cast<circle_shape const*>(shape_a)->get_radius() : 0.f;
+    float radius_b = shape_b->get_type() == shape_type::circle ? static_cast<circle_shape const*>(shape_b)->get_radius() : 0.f;
+
+    if (shape_a->get_type() == shape_type::circle && shape_b->get_type() == shape_type::circle) {
+        collide_circles(radius_a, radius_b);
+    } else if (!(radius_a > 0.f && collide_circle_core(0, radius_a, cache))
+            && !(radius_b > 0.f && collide_circle_core(1, radius_b, cache))) {
+        vec3 position = vec3_zero;
+        vec3 direction = vec3(_motion[1].get_position() - _motion[0].get_position());
+
+        _contact.distance = minimum_distance(position, direction, cache);
+        _contact.point = position.to_vec2();
+        _contact.normal = direction.to_vec2();
+    }
 
     // Calculate the relative velocity of the bodies at the contact point
-    vec3 relative_velocity = vec3(_motion[1].get_linear_velocity(position.to_vec2()))
-                           - vec3(_motion[0].get_linear_velocity(position.to_vec2()));
+    vec2 relative_velocity = _motion[1].get_linear_velocity(_contact.point)
+                           - _motion[0].get_linear_velocity(_contact.point);
 
-    if (distance < 0.0f && relative_velocity.dot(direction) < 0.f) {
+    if (_contact.distance < 0.0f && relative_velocity.dot(_contact.normal) < 0.f) {
         _has_contact = true;
     } else {
         _has_contact = false;
     }
+}
+
+//------------------------------------------------------------------------------
+void collide::collide_circles(float radius_a, float radius_b)
+{
+    vec2 delta = _motion[1].get_position() - _motion[0].get_position();
+    float length = delta.length();
+
+    _contact.normal = length > 0.f ? delta / length : vec2(1, 0);
+    _contact.distance = length - radius_a - radius_b;
+    _contact.point = _motion[0].get_position() + _contact.normal * radius_a;
+}
+
+//------------------------------------------------------------------------------
+bool collide::collide_circle_core(std::size_t circle_index, float radius, cache* cache)
+{
+    static circle_shape const point_shape(0.f);
+
+    // replace the circle with its center and run GJK against the other shape,
+    // the contact is then the nearest point offset by the circle radius
+    motion_data circle_motion = _motion[circle_index];
+    _motion[circle_index] = motion_data(physics::motion(
+        &point_shape,
+        circle_motion.get_position(),
+        circle_motion.get_rotation(),
+        circle_motion.get_linear_velocity(),
+        circle_motion.get_angular_velocity()));
+
+    vec3 position = vec3_zero;
+    vec3 direction = vec3(_motion[1].get_position() - _motion[0].get_position());
+    float distance = minimum_distance(position, direction, cache);
+
+    _motion[circle_index] = circle_motion;
+
+    // the center is inside the other shape or too close to it to determine
+    // the contact normal, fall back to the full query
+    if (!(distance > epsilon)) {
+        _num_penetration_iterations = 0;
+        return false;
+    }
 
-    _contact.distance = distance;
-    _contact.point = position.to_vec2();
+    _contact.distance = distance - radius;
     _contact.normal = direction.to_vec2();
+    // the contact point is on shape A, which is either the circle center or
+    // the nearest point on the other shape
+    _contact.point = circle_index == 0 ? position.to_vec2() + _contact.normal * radius
+                                       : position.to_vec2();
+    return true;
 }
 
 //------------------------------------------------------------------------------
-float collide::minimum_distance(vec3& point, vec3& direction) const
+float collide::minimum_distance(vec3& point, vec3& direction, cache* cache)
 {
     support_vertex simplex[2], candidate;
 
+    // start from the separating direction of the previous query if there is
+    // one, otherwise from the direction between the shape origins
+    if (cache && cache->valid) {
+        direction = vec3(cache->direction);
+        _motion[0].support_index = cache->support[0];
+        _motion[1].support_index = cache->support[1];
+    }
+
     simplex[0] = supporting_vertex(direction);
     simplex[1] = supporting_vertex(-simplex[0].d);
     direction = -nearest_difference(simplex[0], simplex[1]);
     float distance = direction.length_sqr();
 
+    // save the final search direction for the next query
+    auto update_cache = [this, cache, &direction]() {
+        if (cache) {
+            cache->direction = direction.to_vec2();
+            cache->support[0] = _motion[0].support_index;
+            cache->support[1] = _motion[1].support_index;
+            cache->valid = true;
+        }
+    };
+
     for (int num_iterations = 0; ; ++num_iterations) {
         candidate = supporting_vertex(direction);
+        _num_iterations = num_iterations + 1;
 
         // Check if simplex formed with candidate contains origin
         if (triangle_contains_origin(simplex[0].d, simplex[1].d, candidate.d)) {
+            update_cache();
             return -penetration_distance(simplex[0], simplex[1], candidate, point, direction);
         }
 
@@ -78,6 +158,7 @@ float collide::minimum_distance(vec3& point, vec3& direction) const
 
         // Check progress
         if (std::min(distance - d, d) < epsilon || num_iterations >= max_iterations) {
+            update_cache();
             point = nearest_point(simplex[0], simplex[1]);
             return direction.normalize_length();
         } else {
@@ -87,7 +168,7 @@ float collide::minimum_distance(vec3& point, vec3& direction) const
 }
 
 //------------------------------------------------------------------------------
-collide::support_vertex collide::supporting_vertex(vec3 direction) const
+collide::support_vertex collide::supporting_vertex(vec3 direction)
 {
     vec3 a = motion_supporting_vertex(_motion[0],  direction);
     vec3 b = motion_supporting_vertex(_motion[1], -direction);
@@ -95,10 +176,10 @@ collide::support_vertex collide::supporting_vertex(vec3 direction) const
 }
 
 //------------------------------------------------------------------------------
-vec3 collide::motion_supporting_vertex(motion_data const& motion, vec3 direction) const
+vec3 collide::motion_supporting_vertex(motion_data& motion, vec3 direction) const
 {
     vec2 local_direction = (direction * motion.world_to_local).to_vec2();
-    vec2 local_vertex = motion.get_shape()->supporting_vertex(local_direction);
+    vec2 local_vertex = motion.get_shape()->hinted_supporting_vertex(local_direction, motion.support_index);
     return vec3(local_vertex, 1) * motion.local_to_world;
 }
 
@@ -164,7 +245,7 @@ bool collide::triangle_contains_origin(vec3 a, vec3 b, vec3 c) const
 }
 
 //------------------------------------------------------------------------------
-float collide::penetration_distance(support_vertex a, support_vertex b, support_vertex c, vec3& point, vec3& direction) const
+float collide::penetration_distance(support_vertex a, support_vertex b, support_vertex c, vec3& point, vec3& direction)
 {
     std::array<support_vertex, max_vertices> vertices;
     std::size_t num_vertices = 0;
@@ -183,6 +264,7 @@ float collide::penetration_distance(support_vertex a, support_vertex b, support_
 
         // Get the vertex in direction of the edge normal (away from the origin)
         candidate = supporting_vertex(direction);
+        ++_num_penetration_iterations;
 
         // Check for termination
         float edge_distance = vertices[edge_index].d.dot(direction);
@@ -23,7 +23,21 @@ struct contact
 class collide
 {
 public:
-    collide(motion const& motion_a, motion const& motion_b);
+    //! Final search direction from a previous query between the same pair of
+    //! shapes. The direction is used as the initial search direction of the
+    //! next query, which is usually close to the separating axis if the shapes
+    //! have not moved far. Polygon shapes also start their search for
+    //! supporting vertices from the vertices found by the previous query.
+    struct cache
+    {
+        vec2 direction;
+        std::size_t support[2];
+        bool valid;
+    };
+
+    //! if `cache` is not null it is used to warm start the query and is
+    //! updated with the final search direction when the query is complete
+    collide(motion const& motion_a, motion const& motion_b, cache* cache = nullptr);
 
     bool has_contact() const {
         return _has_contact;
@@ -33,16 +47,30 @@ public:
         return _contact;
     }
 
+    //! number of supporting vertices evaluated by GJK
+    int get_num_iterations() const {
+        return _num_iterations;
+    }
+
+    //! number of supporting vertices evaluated by EPA, zero if not penetrating
+    int get_num_penetration_iterations() const {
+        return _num_penetration_iterations;
+    }
+
 protected:
     bool _has_contact;
 
     contact _contact;
 
+    int _num_iterations;
+    int _num_penetration_iterations;
+
     struct motion_data : motion
     {
         motion_data(motion const&);
         mat3 local_to_world;
         mat3 world_to_local;
+        std::size_t support_index; //!< index of the previous supporting vertex
     };
 
     constexpr static int max_iterations = 64;
@@ -56,15 +84,27 @@ protected:
         vec3 d; //!< "Minkowski difference"; a - b
     };
 
+    //
+    //  Circles
+    //
+
+    //! analytic contact between two circles
+    void collide_circles(float radius_a, float radius_b);
+
+    //! contact between the center of the circle `_motion[circle_index]` and
+    //! the other shape offset by the circle radius, returns false if the
+    //! center is inside the other shape and the full query is required
+    bool collide_circle_core(std::size_t circle_index, float radius, cache* cache);
+
     //
     //  GJK
     //
 
-    float minimum_distance(vec3& point, vec3& direction) const;
+    float minimum_distance(vec3& point, vec3& direction, cache* cache);
 
-    support_vertex supporting_vertex(vec3 direction) const;
+    support_vertex supporting_vertex(vec3 direction);
 
-    vec3 motion_supporting_vertex(motion_data const& motion, vec3 direction) const;
+    vec3 motion_supporting_vertex(motion_data& motion, vec3 direction) const;
 
     vec3 nearest_difference(support_vertex a, support_vertex b) const;
 
@@ -76,7 +116,7 @@ protected:
     //  EPA
     //
 
-    float penetration_distance(support_vertex a, support_vertex b, support_vertex c, vec3& point, vec3& direction) const;
+    float penetration_distance(support_vertex a, support_vertex b, support_vertex c, vec3& point, vec3& direction);
 
     std::size_t nearest_edge_index(vec3 normal, support_vertex const* vertices, std::size_t num_vertices, vec3& direction) const;
 
@@ -0,0 +1,165 @@
+// p_shape.cpp
+//
+
+#include "p_shape.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace physics {
+
+//------------------------------------------------------------------------------
+bounds shape::calculate_swept_bounds(vec2 position, float rotation, float delta_rotation) const
+{
+    bounds b = calculate_bounds(position, rotation);
+    if (delta_rotation == 0.f) {
+        return b;
+    }
+
+    // every point on the shape moves along an arc between its positions at
+    // the start and end of the rotation, and the arc bulges out from the
+    // chord between those positions by at most its sagitta
+    float angle = std::abs(delta_rotation);
+    float radius = calculate_radius();
+    b |= calculate_bounds(position, rotation + delta_rotation);
+    if (angle < math::pi<float>) {
+        b = b.expand(radius * (1.f - std::cos(0.5f * angle)));
+    }
+
+    // the shape can not leave its bounding circle regardless of rotation
+    return b & bounds(position - vec2(radius), position + vec2(radius));
+}
+
+//------------------------------------------------------------------------------
+polygon_shape::polygon_shape(vec2 const* points, std::size_t num_points)
+{
+    assert(num_points >= 3);
+
+    std::vector<vec2> sorted(points, points + num_points);
+    std::sort(sorted.begin(), sorted.end(), [](vec2 a, vec2 b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+
+    // monotone chain, builds the lower hull and then the upper hull and
+    // discards collinear points so that no two adjacent edges are parallel
+    _vertices.resize(2 * sorted.size());
+    std::size_t num_vertices = 0;
+
+    for (std::size_t ii = 0; ii < sorted.size(); ++ii) {
+        while (num_vertices >= 2 && (_vertices[num_vertices - 1] - _vertices[num_vertices - 2]).cross(sorted[ii] - _vertices[num_vertices - 2]) <= 0.f) {
+            --num_vertices;
+        }
+        _vertices[num_vertices++] = sorted[ii];
+    }
+
+    for (std::size_t ii = sorted.size() - 1, lower = num_vertices + 1; ii > 0; --ii) {
+        while (num_vertices >= lower && (_vertices[num_vertices - 1] - _vertices[num_vertices - 2]).cross(sorted[ii - 1] - _vertices[num_vertices - 2]) <= 0.f) {
+            --num_vertices;
+        }
+        _vertices[num_vertices++] = sorted[ii - 1];
+    }
+
+    // the last vertex is the same as the first
+    _vertices.resize(num_vertices - 1);
+    assert(_vertices.size() >= 3);
+
+    _normals.resize(_vertices.size());
+    _radius = 0.f;
+    for (std::size_t ii = 0; ii < _vertices.size(); ++ii) {
+        vec2 edge = _vertices[(ii + 1) % _vertices.size()] - _vertices[ii];
+        _normals[ii] = edge.cross(1.f).normalize();
+        _radius = std::max(_radius, _vertices[ii].length());
+    }
+}
+
+//------------------------------------------------------------------------------
+bool polygon_shape::contains_point(vec2 point) const
+{
+    for (std::size_t ii = 0; ii < _vertices.size(); ++ii) {
+        if (_normals[ii].dot(point - _vertices[ii]) > 0.f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+vec2 polygon_shape::supporting_vertex(vec2 direction) const
+{
+    std::size_t hint = 0;
+    return hinted_supporting_vertex(direction, hint);
+}
+
+//------------------------------------------------------------------------------
+vec2 polygon_shape::hinted_supporting_vertex(vec2 direction, std::size_t& hint) const
+{
+    std::size_t const num_vertices = _vertices.size();
+    std::size_t index = hint < num_vertices ? hint : 0;
+    float distance = _vertices[index].dot(direction);
+
+    // distance along the direction increases monotonically from the hint to
+    // the supporting vertex in one winding order, so climb in whichever order
+    // improves on the hint until the distance stops increasing
+    for (std::size_t step : {std::size_t(1), num_vertices - 1}) {
+        std::size_t start = index;
+        for (std::size_t ii = 1; ii < num_vertices; ++ii) {
+            std::size_t next = (index + step) % num_vertices;
+            float next_distance = _vertices[next].dot(direction);
+            if (next_distance <= distance) {
+                break;
+            }
+            index = next;
+            distance = next_distance;
+        }
+        if (index != start) {
+            break;
+        }
+    }
+
+    hint = index;
+    return _vertices[index];
+}
+
+//------------------------------------------------------------------------------
+void polygon_shape::calculate_mass_properties(float inverse_mass, vec2& center_of_mass, float& inverse_inertia) const
+{
+    float area = 0.f;
+    vec2 centroid = vec2_zero;
+    float inertia = 0.f; // second moment of area about the origin
+
+    // sum over triangles formed by each edge and the origin
+    for (std::size_t ii = 0; ii < _vertices.size(); ++ii) {
+        vec2 p0 = _vertices[ii];
+        vec2 p1 = _vertices[(ii + 1) % _vertices.size()];
+        float c = p0.cross(p1);
+
+        area += c;
+        centroid += (p0 + p1) * c;
+        inertia += (p0.dot(p0) + p0.dot(p1) + p1.dot(p1)) * c;
+    }
+
+    center_of_mass = centroid / (3.f * area);
+
+    // bodies rotate about their origin rather than their center of mass so
+    // the moment of inertia is also taken about the origin
+    if (inverse_mass > 0.f) {
+        inverse_inertia = inverse_mass * 6.f * area / inertia;
+    } else {
+        inverse_inertia = 0.f;
+    }
+}
+
+//------------------------------------------------------------------------------
+bounds polygon_shape::calculate_bounds(vec2 position, float rotation) const
+{
+    mat2 rotate = mat2::rotate(rotation);
+    bounds b(_vertices[0] * rotate, _vertices[0] * rotate);
+    for (std::size_t ii = 1; ii < _vertices.size(); ++ii) {
+        b.add(_vertices[ii] * rotate);
+    }
+    return b + position;
+}
+
+} // namespace physics
@@ -8,22 +8,49 @@
 #include "cm_matrix.h"
 #include "cm_shared.h"
 
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////
 namespace physics {
 
+//------------------------------------------------------------------------------
+enum class shape_type
+{
+    box,
+    circle,
+    polygon,
+};
+
 //------------------------------------------------------------------------------
 class shape
 {
 public:
     virtual ~shape() {}
 
+    virtual shape_type get_type() const = 0;
+
     virtual bool contains_point(vec2 point) const = 0;
 
     virtual vec2 supporting_vertex(vec2 direction) const = 0;
 
+    //! same as `supporting_vertex` but the search starts from the vertex at
+    //! index `hint`, which is updated with the index of the result. Shapes
+    //! without discrete vertices ignore the hint.
+    virtual vec2 hinted_supporting_vertex(vec2 direction, std::size_t& /*hint*/) const {
+        return supporting_vertex(direction);
+    }
+
     virtual void calculate_mass_properties(float inverse_mass, vec2& center_of_mass, float& inverse_inertia) const = 0;
 
     virtual bounds calculate_bounds(vec2 position, float rotation) const = 0;
+
+    //! bounds containing the shape as it rotates from `rotation` to
+    //! `rotation + delta_rotation` about `position`
+    virtual bounds calculate_swept_bounds(vec2 position, float rotation, float delta_rotation) const;
+
+    //! radius of the smallest circle centered on the shape origin which
+    //! contains the shape
+    virtual float calculate_radius() const = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -35,6 +62,10 @@ public:
     {
     }
 
+    virtual shape_type get_type() const override {
+        return shape_type::box;
+    }
+
     virtual bool contains_point(vec2 point) const override {
         return !(point.x < -_half_size.x || point.x > _half_size.x ||
                     point.y < -_half_size.y || point.y > _half_size.y);
@@ -54,8 +85,16 @@ public:
         }
     }
 
-    virtual bounds calculate_bounds(vec2 position, float /*rotation*/) const override {
-        return bounds(position - _half_size * math::sqrt2<float>, position + _half_size * math::sqrt2<float>);
+    virtual bounds calculate_bounds(vec2 position, float rotation) const override {
+        float cosa = std::abs(std::cos(rotation));
+        float sina = std::abs(std::sin(rotation));
+        vec2 extents(cosa * _half_size.x + sina * _half_size.y,
+                     sina * _half_size.x + cosa * _half_size.y);
+        return bounds(position - extents, position + extents);
+    }
+
+    virtual float calculate_radius() const override {
+        return _half_size.length();
     }
 
 protected:
@@ -71,6 +110,14 @@ public:
     {
     }
 
+    virtual shape_type get_type() const override {
+        return shape_type::circle;
+    }
+
+    float get_radius() const {
+        return _radius;
+    }
+
     virtual bool contains_point(vec2 point) const override {
         return point.dot(point) < _radius * _radius;
     }
@@ -92,8 +139,57 @@ public:
         return bounds(position - vec2(_radius), position + vec2(_radius));
     }
 
+    virtual bounds calculate_swept_bounds(vec2 position, float /*rotation*/, float /*delta_rotation*/) const override {
+        return bounds(position - vec2(_radius), position + vec2(_radius));
+    }
+
+    virtual float calculate_radius() const override {
+        return _radius;
+    }
+
 protected:
     float _radius;
 };
 
+//------------------------------------------------------------------------------
+//! Convex polygon defined by the convex hull of a set of points. Vertices are
+//! stored in counter-clockwise order with the outward normal of the edge that
+//! starts at each vertex.
+class polygon_shape : public shape
+{
+public:
+    template<std::size_t Size>
+    polygon_shape(vec2 const (&points)[Size])
+        : polygon_shape(points, Size)
+    {}
+
+    polygon_shape(vec2 const* points, std::size_t num_points);
+
+    virtual shape_type get_type() const override {
+        return shape_type::polygon;
+    }
+
+    virtual bool contains_point(vec2 point) const override;
+
+    virtual vec2 supporting_vertex(vec2 direction) const override;
+
+    virtual vec2 hinted_supporting_vertex(vec2 direction, std::size_t& hint) const override;
+
+    virtual void calculate_mass_properties(float inverse_mass, vec2& center_of_mass, float& inverse_inertia) const override;
+
+    virtual bounds calculate_bounds(vec2 position, float rotation) const override;
+
+    virtual float calculate_radius() const override {
+        return _radius;
+    }
+
+    std::vector<vec2> const& vertices() const { return _vertices; }
+    std::vector<vec2> const& normals() const { return _normals; }
+
+protected:
+    std::vector<vec2> _vertices; //!< hull vertices in counter-clockwise order
+    std::vector<vec2> _normals; //!< outward normal of the edge from each vertex to the next
+    float _radius; //!< distance from the origin to the furthest vertex
+};
+
 } // namespace physics
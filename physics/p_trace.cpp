@@ -6,11 +6,15 @@
 #include "p_rigidbody.h"
 #include "p_shape.h"
 
+#include <algorithm>
+
 ////////////////////////////////////////////////////////////////////////////////
 namespace physics {
 
 //------------------------------------------------------------------------------
 trace::trace(rigid_body const* body, vec2 start, vec2 end)
+    : _num_iterations(0)
+    , _num_penetration_iterations(0)
 {
     physics::motion body_motion = body->get_motion();
     physics::circle_shape shape(0);
@@ -21,7 +25,10 @@ trace::trace(rigid_body const* body, vec2 start, vec2 end)
 
     for (int num_iterations = 0; num_iterations < max_iterations && fraction < 1.0f; ++num_iterations) {
         point_motion.set_position(start + direction * fraction);
-        _contact = physics::collide(point_motion, body_motion).get_contact();
+        physics::collide c(point_motion, body_motion);
+        _contact = c.get_contact();
+        _num_iterations += c.get_num_iterations();
+        _num_penetration_iterations += c.get_num_penetration_iterations();
 
         if (_contact.normal.dot(direction) <= 0.0f) {
             _fraction = 1.0f;
@@ -39,7 +46,9 @@ trace::trace(rigid_body const* body, vec2 start, vec2 end)
 }
 
 //------------------------------------------------------------------------------
-trace::trace(rigid_body const* body_a, rigid_body const* body_b, float delta_time)
+trace::trace(rigid_body const* body_a, rigid_body const* body_b, float delta_time, collide::cache* cache)
+    : _num_iterations(0)
+    , _num_penetration_iterations(0)
 {
     physics::motion motion_a = body_a->get_motion();
     physics::motion motion_b = body_b->get_motion();
@@ -54,16 +63,6 @@ trace::trace(rigid_body const* body_a, rigid_body const* body_b, float delta_tim
     float dr_a = body_a->get_angular_velocity() * delta_time;
     float dr_b = body_b->get_angular_velocity() * delta_time;
 
-    // todo: include rotation
-    bounds bounds_a = bounds::from_translation(body_a->get_bounds(), dp_a);
-    bounds bounds_b = bounds::from_translation(body_b->get_bounds(), dp_b);
-
-    // bodies do not overlap during this time step
-    if (!bounds_a.intersects(bounds_b)) {
-        _fraction = 1.0f;
-        return;
-    }
-
     vec2 direction = dp_b - dp_a;
     float fraction = 0.f;
 
@@ -72,13 +71,30 @@ trace::trace(rigid_body const* body_a, rigid_body const* body_b, float delta_tim
         return;
     }
 
+    // bodies do not overlap during this time step if the bounding circles
+    // of their shapes are still apart at their closest approach, which also
+    // rejects pairs whose swept bounds overlap only across a diagonal
+    {
+        vec2 delta = p0_b - p0_a;
+        float t = std::max(0.f, std::min(1.f, -delta.dot(direction) / direction.length_sqr()));
+        float radius = body_a->get_shape()->calculate_radius()
+                     + body_b->get_shape()->calculate_radius();
+        if ((delta + direction * t).length_sqr() > radius * radius) {
+            _fraction = 1.0f;
+            return;
+        }
+    }
+
     for (int num_iterations = 0; num_iterations < max_iterations && fraction < 1.0f; ++num_iterations) {
         motion_a.set_position(p0_a + dp_a * fraction);
         motion_a.set_rotation(r0_a + dr_a * fraction);
         motion_b.set_position(p0_b + dp_b * fraction);
         motion_b.set_rotation(r0_b + dr_b * fraction);
 
-        _contact = physics::collide(motion_a, motion_b).get_contact();
+        physics::collide c(motion_a, motion_b, cache);
+        _contact = c.get_contact();
+        _num_iterations += c.get_num_iterations();
+        _num_penetration_iterations += c.get_num_penetration_iterations();
 
         direction = motion_b.get_linear_velocity(_contact.point) * delta_time
                   - motion_a.get_linear_velocity(_contact.point) * delta_time;
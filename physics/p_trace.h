@@ -16,7 +16,8 @@ class trace
 {
 public:
     trace(rigid_body const* body, vec2 start, vec2 end);
-    trace(rigid_body const* body_a, rigid_body const* body_b, float delta_time);
+    //! if `cache` is not null it is used to warm start each collision query
+    trace(rigid_body const* body_a, rigid_body const* body_b, float delta_time, collide::cache* cache = nullptr);
 
     float get_fraction() const { return _fraction; }
 
@@ -24,9 +25,18 @@ public:
         return _contact;
     }
 
+    //! total number of GJK iterations for all collision queries
+    int get_num_iterations() const { return _num_iterations; }
+
+    //! total number of EPA iterations for all collision queries
+    int get_num_penetration_iterations() const { return _num_penetration_iterations; }
+
 protected:
     float _fraction;
 
+    int _num_iterations;
+    int _num_penetration_iterations;
+
     contact _contact;
 
     constexpr static int max_iterations = 64;
@@ -2,13 +2,17 @@
 //
 
 #include "p_world.h"
+#include "cm_job.h"
+#include "cm_profile.h"
 #include "p_collide.h"
 #include "p_material.h"
 #include "p_rigidbody.h"
+#include "p_shape.h"
 #include "p_trace.h"
 
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <queue>
 
@@ -17,28 +21,51 @@ namespace physics {
 
 //------------------------------------------------------------------------------
 world::world(filter_callback_type filter_callback, collision_callback_type collision_callback)
-    : _filter_callback(filter_callback)
+    : _stats{}
+    , _step_count(0)
+    , _warm_start(true)
+    , _filter_callback(filter_callback)
     , _collision_callback(collision_callback)
 {
+    _static_bounds.max_width = 0.f;
+    _static_bounds_dirty = false;
 }
 
 //------------------------------------------------------------------------------
 void world::add_body(physics::rigid_body* body)
 {
     assert(std::find(_bodies.begin(), _bodies.end(), body) == _bodies.end());
-    _bodies.push_back(body);
+    assert(std::find(_static_bodies.begin(), _static_bodies.end(), body) == _static_bodies.end());
+
+    if (body->get_inverse_mass() == 0.f) {
+        _static_bodies.push_back(body);
+        _static_bounds_dirty = true;
+    } else {
+        _bodies.push_back(body);
+        _sleep.push_back({0.f, false});
+    }
 }
 
 //------------------------------------------------------------------------------
 void world::remove_body(physics::rigid_body* body)
 {
-    assert(std::find(_bodies.begin(), _bodies.end(), body) != _bodies.end());
-    _bodies.erase(std::find(_bodies.begin(), _bodies.end(), body));
+    auto it = std::find(_bodies.begin(), _bodies.end(), body);
+    if (it != _bodies.end()) {
+        _sleep.erase(_sleep.begin() + std::distance(_bodies.begin(), it));
+        _bodies.erase(it);
+        return;
+    }
+
+    assert(std::find(_static_bodies.begin(), _static_bodies.end(), body) != _static_bodies.end());
+    _static_bodies.erase(std::find(_static_bodies.begin(), _static_bodies.end(), body));
+    _static_bounds_dirty = true;
 }
 
 //------------------------------------------------------------------------------
 void world::step(float delta_time)
 {
+    PROFILE_ZONE("physics::world::step");
+
     struct candidate {
         std::size_t body_b;
         float fraction;
@@ -49,57 +76,243 @@ void world::step(float delta_time)
         }
     };
 
+    ++_step_count;
+
+    update_static_bounds();
+    wake_moved_bodies();
+
     // calculate all overlapping body pairs, including permutations
     std::vector<overlap> overlaps = generate_overlaps(delta_time);
 
-    for (std::size_t idx = 0; idx < overlaps.size();) {
-        std::size_t ii = overlaps[idx].first;
+    update_pair_cache(overlaps);
 
-        std::priority_queue<candidate> candidates;
-        // check all bodies overlapping with body index `ii`
-        for (; idx < overlaps.size() && overlaps[idx].first == ii; ++idx) {
-            std::size_t jj = overlaps[idx].second;
+    // calculate time of impact for all pairs before any impulses are applied
+    // so that the results do not depend on the order in which pairs are run
+    generate_impacts(overlaps, delta_time);
 
-            // check collision
-            physics::trace tr(_bodies[ii], _bodies[jj], delta_time);
-            if (tr.get_fraction() == 1.f) {
-                continue;
-            }
+    // collision response
+    {
+        PROFILE_ZONE("collision_response");
 
-            candidates.push({jj, tr.get_fraction(), tr.get_contact()});
-        }
+        for (std::size_t idx = 0; idx < overlaps.size();) {
+            std::size_t ii = overlaps[idx].first;
 
-        // use the earliest collision candidate
-        while (candidates.size()) {
-            candidate candidate = candidates.top();
-            std::size_t jj = candidate.body_b;
-            candidates.pop();
+            std::priority_queue<candidate> candidates;
+            // check all bodies overlapping with body index `ii`
+            for (; idx < overlaps.size() && overlaps[idx].first == ii; ++idx) {
+                std::size_t jj = overlaps[idx].second;
 
-            if (candidates.size()) {
-                assert(candidates.top().fraction >= candidate.fraction);
+                // check collision
+                impact const& tr = _impacts[idx];
+                if (tr.fraction == 1.f) {
+                    continue;
+                }
+
+                candidates.push({jj, tr.fraction, tr.contact});
             }
 
-            physics::collision c = physics::collision(candidate.contact);
-            c.impulse = collision_impulse(_bodies[ii], _bodies[jj], c);
+            // use the earliest collision candidate
+            while (candidates.size()) {
+                candidate candidate = candidates.top();
+                std::size_t jj = candidate.body_b;
+                candidates.pop();
 
-            // check collision callback
-            if (_collision_callback && !_collision_callback(_bodies[ii], _bodies[jj], c)) {
-                continue;
-            }
+                if (candidates.size()) {
+                    assert(candidates.top().fraction >= candidate.fraction);
+                }
+
+                physics::collision c = physics::collision(candidate.contact);
+                c.impulse = collision_impulse(body(ii), body(jj), c);
+
+                // check collision callback
+                if (_collision_callback && !_collision_callback(body(ii), body(jj), c)) {
+                    continue;
+                }
+
+                // collision response
+                body(ii)->apply_impulse(-c.impulse, c.point);
+                body(jj)->apply_impulse( c.impulse, c.point);
 
-            // collision response
-            _bodies[ii]->apply_impulse(-c.impulse, c.point);
-            _bodies[jj]->apply_impulse( c.impulse, c.point);
+                // wake sleeping bodies on contact so that they are moved this step
+                wake_body(ii);
+                wake_body(jj);
 
-            break;
+                break;
+            }
         }
     }
 
     // move
 
+    integrate_bodies(delta_time);
+    update_sleep(delta_time);
+
+    _stats.static_bodies = _static_bodies.size();
+    _stats.overlaps = overlaps.size();
+}
+
+//------------------------------------------------------------------------------
+void world::wake_body(std::size_t index)
+{
+    if (index < _sleep.size()) {
+        _sleep[index] = {0.f, false};
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::wake_moved_bodies()
+{
+    PROFILE_ZONE("wake_moved_bodies");
+
+    // sleeping bodies have zero velocity so any velocity must have come
+    // from an impulse applied outside of the step, e.g. by a game object
+    for (std::size_t ii = 0; ii < _bodies.size(); ++ii) {
+        if (_sleep[ii].asleep && (_bodies[ii]->get_linear_velocity() != vec2_zero
+                               || _bodies[ii]->get_angular_velocity() != 0.f)) {
+            wake_body(ii);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::update_sleep(float delta_time)
+{
+    PROFILE_ZONE("update_sleep");
+
+    constexpr float linear_sqr = sleep_linear_velocity * sleep_linear_velocity;
+
+    _stats.awake = 0;
+    _stats.sleeping = 0;
+
     for (std::size_t ii = 0; ii < _bodies.size(); ++ii) {
-        _bodies[ii]->set_position(_bodies[ii]->get_position() + _bodies[ii]->get_linear_velocity() * delta_time);
-        _bodies[ii]->set_rotation(_bodies[ii]->get_rotation() + _bodies[ii]->get_angular_velocity() * delta_time);
+        if (_sleep[ii].asleep) {
+            ++_stats.sleeping;
+            continue;
+        }
+
+        ++_stats.awake;
+
+        if (_bodies[ii]->get_linear_velocity().length_sqr() >= linear_sqr
+                || std::abs(_bodies[ii]->get_angular_velocity()) >= sleep_angular_velocity) {
+            _sleep[ii].time = 0.f;
+            continue;
+        }
+
+        _sleep[ii].time += delta_time;
+        if (_sleep[ii].time >= sleep_delay) {
+            // clear residual velocity so that sleeping bodies stay at rest
+            _sleep[ii].asleep = true;
+            _bodies[ii]->set_linear_velocity(vec2_zero);
+            _bodies[ii]->set_angular_velocity(0.f);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::update_static_bounds()
+{
+    PROFILE_ZONE("update_static_bounds");
+
+    if (_static_bounds_dirty) {
+        _static_bounds.build(_static_bodies);
+        _static_bounds_dirty = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::sorted_bounds::build(std::vector<physics::rigid_body*> const& bodies)
+{
+    std::size_t count = bodies.size();
+    std::vector<bounds> unsorted(count);
+    for (std::size_t ii = 0; ii < count; ++ii) {
+        unsorted[ii] = bodies[ii]->get_bounds();
+    }
+
+    index.resize(count);
+    std::iota(index.begin(), index.end(), 0);
+    std::sort(index.begin(), index.end(),
+        [&unsorted](std::size_t lhs, std::size_t rhs) {
+            return unsorted[lhs][0].x < unsorted[rhs][0].x;
+        });
+
+    body_bounds.resize(count);
+    max_width = 0.f;
+    for (std::size_t ii = 0; ii < count; ++ii) {
+        bounds const& b = unsorted[index[ii]];
+        body_bounds[ii] = b;
+        max_width = std::max(max_width, b[1].x - b[0].x);
+    }
+}
+
+//------------------------------------------------------------------------------
+template<typename function_type>
+void world::sorted_bounds::query(bounds const& b, function_type const& function) const
+{
+    // bounds are sorted by their minimum on the x-axis so skip all bounds
+    // which must end before the query bounds start
+    float start = b[0].x - max_width;
+    auto it = std::lower_bound(body_bounds.begin(), body_bounds.end(), start,
+        [](bounds const& lhs, float x) {
+            return lhs[0].x < x;
+        });
+
+    for (; it != body_bounds.end() && (*it)[0].x <= b[1].x; ++it) {
+        if ((*it)[1].x < b[0].x || (*it)[1].y < b[0].y || b[1].y < (*it)[0].y) {
+            continue;
+        }
+        function(index[it - body_bounds.begin()]);
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::trace_segments(std::vector<segment> const& segments,
+                           std::vector<segment_hit>& hits,
+                           segment_filter_type const& filter)
+{
+    update_static_bounds();
+
+    // dynamic bodies move every step so their bounds are sorted per query
+    sorted_bounds dynamic_bounds;
+    dynamic_bounds.build(_bodies);
+
+    hits.resize(segments.size());
+
+    for (std::size_t ii = 0; ii < segments.size(); ++ii) {
+        segment const& s = segments[ii];
+        segment_hit& hit = hits[ii];
+        hit = {1.f, nullptr, {}};
+
+        bounds b(vec2(std::min(s.start.x, s.end.x), std::min(s.start.y, s.end.y)),
+                 vec2(std::max(s.start.x, s.end.x), std::max(s.start.y, s.end.y)));
+
+        auto trace_body = [&](physics::rigid_body const* body) {
+            if (filter && !filter(ii, body)) {
+                return;
+            }
+
+            physics::trace tr(body, s.start, s.end);
+            if (tr.get_fraction() < hit.fraction) {
+                hit = {tr.get_fraction(), body, tr.get_contact()};
+            }
+        };
+
+        dynamic_bounds.query(b, [&](std::size_t index) { trace_body(_bodies[index]); });
+        _static_bounds.query(b, [&](std::size_t index) { trace_body(_static_bodies[index]); });
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::integrate_bodies(float delta_time)
+{
+    PROFILE_ZONE("integrate_bodies");
+
+    for (std::size_t ii = 0; ii < _bodies.size(); ++ii) {
+        if (_sleep[ii].asleep) {
+            continue;
+        }
+        physics::rigid_body* body = _bodies[ii];
+        body->set_position(body->get_position() + body->get_linear_velocity() * delta_time);
+        body->set_rotation(body->get_rotation() + body->get_angular_velocity() * delta_time);
     }
 }
 
@@ -178,7 +391,7 @@ vec2 world::collision_impulse(
     float dpy = inv_det * (-gy * dvx + gx * dvy);
 
     // Clamp friction impulse by friction coefficient
-    if (abs(dpy) > mu * abs(dpx)) {
+    if (std::abs(dpy) > mu * std::abs(dpx)) {
         // Find clamped vy using the original vector equation with dpy := mu * dpx
         float dvy0 = (gy + mu * hy) / (gx + mu * hx) * dvx;
 
@@ -190,20 +403,102 @@ vec2 world::collision_impulse(
     return (direction * dpx - tangent * dpy).to_vec2();
 }
 
+//------------------------------------------------------------------------------
+void world::update_pair_cache(std::vector<overlap> const& overlaps)
+{
+    PROFILE_ZONE("update_pair_cache");
+
+    _pair_cache_entries.resize(overlaps.size());
+    _stats.warm_started = 0;
+
+    // entries are created here on the calling thread so that each narrowphase
+    // job only writes to the entry for its own pair
+    for (std::size_t idx = 0; idx < overlaps.size(); ++idx) {
+        pair_cache& entry = _pair_cache[{body(overlaps[idx].first), body(overlaps[idx].second)}];
+        if (_warm_start && entry.collide.valid) {
+            ++_stats.warm_started;
+        }
+        entry.step = _step_count;
+        _pair_cache_entries[idx] = _warm_start ? &entry.collide : nullptr;
+    }
+
+    for (auto it = _pair_cache.begin(); it != _pair_cache.end();) {
+        if (it->second.step != _step_count) {
+            it = _pair_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void world::generate_impacts(std::vector<overlap> const& overlaps, float delta_time)
+{
+    PROFILE_ZONE("generate_impacts");
+
+    _impacts.resize(overlaps.size());
+
+    // each pair only reads the state of its bodies and writes its own result
+    auto trace_pairs = [this, &overlaps, delta_time](std::size_t first, std::size_t last) {
+        PROFILE_ZONE("trace_pairs");
+        for (std::size_t idx = first; idx < last; ++idx) {
+            physics::trace tr(body(overlaps[idx].first), body(overlaps[idx].second), delta_time, _pair_cache_entries[idx]);
+            _impacts[idx] = {tr.get_fraction(), tr.get_contact(), tr.get_num_iterations(), tr.get_num_penetration_iterations()};
+        }
+    };
+
+    job::system* jobs = job::system::singleton();
+    if (jobs && overlaps.size() >= parallel_pairs) {
+        jobs->parallel_for(0, overlaps.size(), parallel_grain_size, trace_pairs);
+    } else {
+        trace_pairs(0, overlaps.size());
+    }
+
+    _stats.gjk_iterations = 0;
+    _stats.epa_iterations = 0;
+    _stats.false_overlaps = 0;
+    _stats.culled_overlaps = 0;
+    for (auto const& impact : _impacts) {
+        _stats.gjk_iterations += impact.num_iterations;
+        _stats.epa_iterations += impact.num_penetration_iterations;
+        if (impact.fraction == 1.f) {
+            ++_stats.false_overlaps;
+            if (!impact.num_iterations) {
+                ++_stats.culled_overlaps;
+            }
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 std::vector<world::overlap> world::generate_overlaps(float delta_time) const
 {
-    std::vector<bounds> swept_bounds(_bodies.size());
-    for (std::size_t ii = 0, sz = _bodies.size(); ii < sz; ++ii) {
-        // todo: include rotation
-        swept_bounds[ii] = bounds::from_translation(_bodies[ii]->get_bounds(),
-                                                    _bodies[ii]->get_linear_velocity() * delta_time);
+    PROFILE_ZONE("generate_overlaps");
+
+    std::size_t num_dynamic = _bodies.size();
+
+    std::vector<bounds> swept_bounds(num_dynamic);
+    for (std::size_t ii = 0; ii < num_dynamic; ++ii) {
+        physics::rigid_body const* b = _bodies[ii];
+        swept_bounds[ii] = bounds::from_translation(
+            b->get_shape()->calculate_swept_bounds(b->get_position(), b->get_rotation(), b->get_angular_velocity() * delta_time),
+            b->get_linear_velocity() * delta_time);
     }
 
     std::vector<overlap> axis_overlaps[2];
-    std::vector<size_t> sorted(_bodies.size());
+    std::vector<size_t> sorted(num_dynamic);
     std::iota(sorted.begin(), sorted.end(), 0);
 
+    // check collision filter, note: filter is not necessarily symmetric
+    auto add_overlap = [this](std::vector<overlap>& overlaps, std::size_t ii, std::size_t jj) {
+        if (!_filter_callback || _filter_callback(body(ii), body(jj))) {
+            overlaps.push_back({ii, jj});
+        }
+        if (!_filter_callback || _filter_callback(body(jj), body(ii))) {
+            overlaps.push_back({jj, ii});
+        }
+    };
+
     for (int axis = 0; axis < 2; ++axis) {
         // sort bounds on the current axis
         std::sort(sorted.begin(), sorted.end(),
@@ -212,20 +507,19 @@ std::vector<world::overlap> world::generate_overlaps(float delta_time) const
             });
 
         // generate overlaps on the current axis
-        for (std::size_t ii = 0, sz = _bodies.size(); ii < sz; ++ii) {
+        for (std::size_t ii = 0; ii < num_dynamic; ++ii) {
             bounds b = swept_bounds[sorted[ii]];
-            for (std::size_t jj = ii + 1; jj < sz; ++jj) {
+            for (std::size_t jj = ii + 1; jj < num_dynamic; ++jj) {
                 if (b[1][axis] < swept_bounds[sorted[jj]][0][axis]) {
                     break;
                 }
 
-                // check collision filter, note: filter is not necessarily symmetric
-                if (!_filter_callback || _filter_callback(_bodies[sorted[ii]], _bodies[sorted[jj]])) {
-                    axis_overlaps[axis].push_back({sorted[ii], sorted[jj]});
-                }
-                if (!_filter_callback || _filter_callback(_bodies[sorted[jj]], _bodies[sorted[ii]])) {
-                    axis_overlaps[axis].push_back({sorted[jj], sorted[ii]});
+                // sleeping bodies do not move so they can not hit each other
+                if (_sleep[sorted[ii]].asleep && _sleep[sorted[jj]].asleep) {
+                    continue;
                 }
+
+                add_overlap(axis_overlaps[axis], sorted[ii], sorted[jj]);
             }
         }
 
@@ -238,6 +532,20 @@ std::vector<world::overlap> world::generate_overlaps(float delta_time) const
     std::set_intersection(axis_overlaps[0].begin(), axis_overlaps[0].end(),
                           axis_overlaps[1].begin(), axis_overlaps[1].end(),
                           std::back_inserter(overlaps));
+
+    // generate overlaps between awake bodies and static bodies
+    for (std::size_t ii = 0; ii < num_dynamic; ++ii) {
+        if (_sleep[ii].asleep) {
+            continue;
+        }
+
+        _static_bounds.query(swept_bounds[ii], [&](std::size_t index) {
+            add_overlap(overlaps, ii, num_dynamic + index);
+        });
+    }
+
+    // static overlaps are not in order since they were appended
+    std::sort(overlaps.begin(), overlaps.end());
     return overlaps;
 }
 
@@ -6,6 +6,7 @@
 #include "cm_vector.h"
 #include "p_collide.h"
 #include <functional>
+#include <map>
 #include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -38,22 +39,167 @@ public:
 
     void step(float delta_time);
 
+    //! impulse which should be applied to `body_b` to resolve its contact with `body_a`
+    vec2 collision_impulse(physics::rigid_body const* body_a,
+                           physics::rigid_body const* body_b,
+                           physics::contact const& contact) const;
+
+    //! body counts from the most recent step
+    struct stats {
+        std::size_t awake; //!< dynamic bodies which were simulated
+        std::size_t sleeping; //!< dynamic bodies which were at rest
+        std::size_t static_bodies; //!< bodies with zero mass
+        std::size_t overlaps; //!< overlapping pairs, including permutations
+        std::size_t warm_started; //!< overlapping pairs which were warm started from the pair cache
+        std::size_t gjk_iterations; //!< total GJK iterations for all overlapping pairs
+        std::size_t epa_iterations; //!< total EPA iterations for all overlapping pairs
+        std::size_t false_overlaps; //!< overlapping pairs which did not collide
+        std::size_t culled_overlaps; //!< false overlaps rejected by trace without running GJK
+    };
+
+    stats const& get_stats() const { return _stats; }
+
+    //! enable or disable warm starting the narrowphase from the pair cache
+    void set_warm_start(bool warm_start) { _warm_start = warm_start; }
+
+    //! line segment for batched queries
+    struct segment {
+        vec2 start;
+        vec2 end;
+    };
+
+    //! first body hit by a segment
+    struct segment_hit {
+        float fraction; //!< fraction of the segment before the hit, 1 if nothing was hit
+        physics::rigid_body const* body; //!< body which was hit, null if nothing was hit
+        physics::contact contact;
+    };
+
+    using segment_filter_type = std::function<bool(std::size_t segment_index, physics::rigid_body const* body)>;
+
+    //! Find the first body hit by each segment against the current state of
+    //! all bodies. Segments are culled against the sorted bounds of dynamic and
+    //! static bodies before any exact tests, and bodies for which `filter`
+    //! returns false are ignored. `hits` is resized to the number of segments.
+    void trace_segments(std::vector<segment> const& segments,
+                        std::vector<segment_hit>& hits,
+                        segment_filter_type const& filter = nullptr);
+
+    //! minimum number of overlapping pairs for which the narrowphase is run
+    //! on the job system instead of on the calling thread
+    static constexpr std::size_t parallel_pairs = 64;
+    //! number of overlapping pairs processed by each narrowphase job
+    static constexpr std::size_t parallel_grain_size = 16;
+
+    //! dynamic bodies fall asleep after their linear and angular speed have
+    //! stayed below these thresholds for `sleep_delay` seconds
+    static constexpr float sleep_linear_velocity = 1.0f;
+    static constexpr float sleep_angular_velocity = 0.0175f; //!< about one degree per second
+    static constexpr float sleep_delay = 0.5f;
+
 protected:
+    //! Bodies with non-zero mass. Bodies are indexed with dynamic bodies
+    //! first followed by static bodies, i.e. static body `n` has index
+    //! `_bodies.size() + n` in overlaps and impacts.
     std::vector<physics::rigid_body*> _bodies;
 
+    //! Bodies with zero mass. Static bodies are assumed not to move while they
+    //! are in the world, they are never tested against other static bodies and
+    //! their bounds are cached in `_static_bounds`.
+    std::vector<physics::rigid_body*> _static_bodies;
+
+    //! Bounds of a list of bodies sorted by their minimum on the x-axis
+    struct sorted_bounds {
+        std::vector<std::size_t> index; //!< index into the list of bodies
+        std::vector<bounds> body_bounds;
+        float max_width; //!< largest extent of any body on the x-axis
+
+        //! sort the current bounds of `bodies`
+        void build(std::vector<physics::rigid_body*> const& bodies);
+
+        //! call `function(index)` for each body whose bounds overlap `b`
+        template<typename function_type>
+        void query(bounds const& b, function_type const& function) const;
+    };
+
+    sorted_bounds _static_bounds;
+    bool _static_bounds_dirty; //!< static bounds must be rebuilt before use
+
+    //! Sleep state of dynamic bodies, indexed the same as `_bodies`
+    struct sleep_state {
+        float time; //!< time the body has been below the sleep thresholds
+        bool asleep;
+    };
+
+    std::vector<sleep_state> _sleep;
+
+    stats _stats;
+
+    //! time of impact and contact for a single overlapping pair
+    struct impact {
+        float fraction;
+        physics::contact contact;
+        int num_iterations;
+        int num_penetration_iterations;
+    };
+
+    //! narrowphase results for each overlapping pair, reused between steps
+    std::vector<impact> _impacts;
+
+    //! Narrowphase state which persists between steps for an ordered pair of
+    //! bodies. Entries are evicted when the pair stops overlapping.
+    struct pair_cache {
+        physics::collide::cache collide;
+        std::size_t step; //!< most recent step in which the pair overlapped
+    };
+
+    using body_pair = std::pair<physics::rigid_body const*, physics::rigid_body const*>;
+
+    std::map<body_pair, pair_cache> _pair_cache;
+
+    //! pair cache entry for each overlapping pair, null if warm starting is disabled
+    std::vector<physics::collide::cache*> _pair_cache_entries;
+
+    std::size_t _step_count;
+    bool _warm_start;
+
     filter_callback_type _filter_callback;
     collision_callback_type _collision_callback;
 
 protected:
-    vec2 collision_impulse(physics::rigid_body const* body_a,
-                           physics::rigid_body const* body_b,
-                           physics::contact const& contact) const;
-
     using overlap = std::pair<std::size_t, std::size_t>;
 
+    //! returns the dynamic or static body with the given index
+    physics::rigid_body* body(std::size_t index) const {
+        return index < _bodies.size() ? _bodies[index] : _static_bodies[index - _bodies.size()];
+    }
+
+    //! reset the sleep timer of a dynamic body, has no effect on static bodies
+    void wake_body(std::size_t index);
+
+    //! Wake sleeping bodies whose velocity was changed outside of the step.
+    void wake_moved_bodies();
+
+    //! Put dynamic bodies to sleep which have been at rest for `sleep_delay`.
+    void update_sleep(float delta_time);
+
+    //! Sort static bodies by their bounds if any were added or removed.
+    void update_static_bounds();
+
+    //! Integrate positions and rotations of awake bodies over `delta_time`.
+    void integrate_bodies(float delta_time);
+
     //! Return a lexicographically sorted list of all pairs of bodies which
     //! overlap during the next `delta_time` step, including permutations.
+    //! Pairs where neither body is awake are not included.
     std::vector<overlap> generate_overlaps(float delta_time) const;
+
+    //! Find or create pair cache entries for all overlapping pairs and evict
+    //! entries for pairs which are no longer overlapping.
+    void update_pair_cache(std::vector<overlap> const& overlaps);
+
+    //! Calculate the time of impact for each overlapping pair into `_impacts`.
+    void generate_impacts(std::vector<overlap> const& overlaps, float delta_time);
 };
 
 } // namespace physics
@@ -9,8 +9,12 @@
 //  data type headers
 #include "r_particle.h"
 #include "r_model.h"
+#include "r_command.h"
+#include "r_backend.h"
 //  common headers
 #include "cm_config.h"
+#include "cm_job.h"
+#include "cm_profile.h"
 #include "cm_sound.h"
 //  game headers
 #include "g_world.h"
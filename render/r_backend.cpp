@@ -0,0 +1,96 @@
+// r_backend.cpp
+//
+
+#include "cm_shared.h"
+#include "r_backend.h"
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+//------------------------------------------------------------------------------
+bool can_batch(command const& first, command const& next)
+{
+    if (first.type != next.type) {
+        return false;
+    } else if (first.type == command_type::draw_box) {
+        return true;
+    } else {
+        return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+void model_batcher::gather(command_list::const_iterator first, command_list::const_iterator end)
+{
+    _batches.clear();
+    _instances.clear();
+
+    for (command_list::const_iterator cmd = first; cmd != end && cmd->type == command_type::draw_model; ++cmd) {
+        auto const& m = cmd->as<draw_model_command>();
+
+        // start a new batch whenever the model changes so that draw order is
+        // the same as if each model had been drawn individually
+        if (!_batches.size() || _batches.back().model != m.model) {
+            _batches.push_back({m.model, _instances.size(), 0});
+        }
+        ++_batches.back().num_instances;
+
+        _instances.emplace_back();
+        model_instance& instance = _instances.back();
+        instance.x_axis = vec2(m.transform[0][0], m.transform[0][1]);
+        instance.y_axis = vec2(m.transform[1][0], m.transform[1][1]);
+        instance.translation = vec2(m.transform[2][0], m.transform[2][1]);
+        instance.color = m.color;
+    }
+}
+
+//------------------------------------------------------------------------------
+null_backend::null_backend()
+    : _stats{}
+{}
+
+//------------------------------------------------------------------------------
+void null_backend::execute(command_list const& commands)
+{
+    _stats = {};
+    _stats.bytes = commands.bytes();
+    _recorded.clear();
+
+    command const* batch = nullptr;
+    bool models_gathered = false;
+
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        command const& cmd = *it;
+
+        if (cmd.type != command_type::draw_model) {
+            models_gathered = false;
+        } else {
+            // consecutive model draws are drawn together at the first of them
+            if (!models_gathered) {
+                _models.gather(it, commands.end());
+                _stats.instances += _models.instances().size();
+                _stats.model_batches += _models.batches().size();
+                _stats.batches += _models.batches().size();
+                models_gathered = true;
+                batch = nullptr;
+            }
+        }
+
+        if (cmd.type != command_type::draw_model && (!batch || !can_batch(*batch, cmd))) {
+            batch = &cmd;
+            ++_stats.batches;
+        }
+
+        ++_stats.commands;
+        ++_stats.counts[std::size_t(cmd.type)];
+        _recorded.push_back(cmd.type);
+
+        if (cmd.type == command_type::draw_particles) {
+            _stats.vertices += cmd.as<draw_particles_command>().num_vertices;
+        } else if (cmd.type == command_type::draw_string) {
+            _stats.characters += cmd.as<draw_string_command>().length;
+        }
+    }
+}
+
+} // namespace render
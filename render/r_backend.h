@@ -0,0 +1,103 @@
+// r_backend.h
+//
+
+#pragma once
+
+#include "r_command.h"
+
+#include <array>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+//------------------------------------------------------------------------------
+//! Interface for consumers of recorded command lists.
+class backend
+{
+public:
+    virtual ~backend() {}
+
+    //! execute all commands in `commands` in order
+    virtual void execute(command_list const& commands) = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Returns true if `next` can be drawn in the same batch as `first`, i.e. if
+//! they are both boxes. Models are batched by `model_batcher` instead.
+bool can_batch(command const& first, command const& next);
+
+//------------------------------------------------------------------------------
+//! Per-instance data for instanced model draws, the rows of the instance
+//! transform and the color that the model's vertex colors are scaled by.
+struct model_instance
+{
+    vec2 x_axis;
+    vec2 y_axis;
+    vec2 translation;
+    color4 color;
+};
+
+//------------------------------------------------------------------------------
+//! Gathers consecutive model draws of a command list into batches which can
+//! each be drawn with a single instanced call. There is no depth test so draws
+//! are never reordered, a batch is a run of draws of the same model which are
+//! not separated by any other command.
+class model_batcher
+{
+public:
+    struct batch {
+        render::model const* model;
+        std::size_t first_instance; //!< index of the first instance in `instances`
+        std::size_t num_instances;
+    };
+
+    //! gather model draws from `first` up to the next command which is not a
+    //! model draw
+    void gather(command_list::const_iterator first, command_list::const_iterator end);
+
+    //! batches in the order they were drawn
+    std::vector<batch> const& batches() const { return _batches; }
+    std::vector<model_instance> const& instances() const { return _instances; }
+
+protected:
+    std::vector<batch> _batches;
+    std::vector<model_instance> _instances;
+};
+
+//------------------------------------------------------------------------------
+//! Backend that does not draw anything and only records what it was given,
+//! for testing and for measuring recording overhead.
+class null_backend : public backend
+{
+public:
+    struct stats {
+        std::size_t commands; //!< number of commands executed
+        std::size_t batches; //!< number of batches the commands could be drawn in
+        std::size_t bytes; //!< size of the command list
+        std::size_t vertices; //!< number of particle vertices
+        std::size_t instances; //!< number of model instances
+        std::size_t model_batches; //!< number of instanced model draws
+        std::size_t characters; //!< number of characters in strings
+        std::array<std::size_t, std::size_t(command_type::num_types)> counts; //!< commands of each type
+    };
+
+    null_backend();
+
+    virtual void execute(command_list const& commands) override;
+
+    //! statistics for the most recently executed command list
+    stats const& get_stats() const { return _stats; }
+
+    //! types of the commands in the most recently executed command list
+    std::vector<command_type> const& recorded() const { return _recorded; }
+
+    //! model batches gathered from the last view with model draws
+    model_batcher const& models() const { return _models; }
+
+protected:
+    stats _stats;
+    std::vector<command_type> _recorded;
+    model_batcher _models;
+};
+
+} // namespace render
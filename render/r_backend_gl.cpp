@@ -0,0 +1,529 @@
+// r_backend_gl.cpp
+//
+
+#include "precompiled.h"
+#pragma hdrstop
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+//------------------------------------------------------------------------------
+gl_backend::gl_backend()
+    : _framebuffer_size(0, 0)
+    , _draw_tris("r_tris", 0, 0, "draw triangle edges")
+    , _instancing(false)
+    , _model_program(0)
+    , _instance_buffer(0)
+{}
+
+//------------------------------------------------------------------------------
+void gl_backend::init()
+{
+    glBlendColor = (PFNGLBLENDCOLOR )wglGetProcAddress("glBlendColor");
+    glGenBuffers = (PFNGLGENBUFFERS )wglGetProcAddress("glGenBuffers");
+    glDeleteBuffers = (PFNGLDELETEBUFFERS )wglGetProcAddress("glDeleteBuffers");
+    glBindBuffer = (PFNGLBINDBUFFER )wglGetProcAddress("glBindBuffer");
+    glBufferData = (PFNGLBUFFERDATA )wglGetProcAddress("glBufferData");
+    glBufferSubData = (PFNGLBUFFERSUBDATA )wglGetProcAddress("glBufferSubData");
+    glCreateShader = (PFNGLCREATESHADER )wglGetProcAddress("glCreateShader");
+    glDeleteShader = (PFNGLDELETESHADER )wglGetProcAddress("glDeleteShader");
+    glShaderSource = (PFNGLSHADERSOURCE )wglGetProcAddress("glShaderSource");
+    glCompileShader = (PFNGLCOMPILESHADER )wglGetProcAddress("glCompileShader");
+    glGetShaderiv = (PFNGLGETSHADERIV )wglGetProcAddress("glGetShaderiv");
+    glCreateProgram = (PFNGLCREATEPROGRAM )wglGetProcAddress("glCreateProgram");
+    glDeleteProgram = (PFNGLDELETEPROGRAM )wglGetProcAddress("glDeleteProgram");
+    glAttachShader = (PFNGLATTACHSHADER )wglGetProcAddress("glAttachShader");
+    glBindAttribLocation = (PFNGLBINDATTRIBLOCATION )wglGetProcAddress("glBindAttribLocation");
+    glLinkProgram = (PFNGLLINKPROGRAM )wglGetProcAddress("glLinkProgram");
+    glGetProgramiv = (PFNGLGETPROGRAMIV )wglGetProcAddress("glGetProgramiv");
+    glUseProgram = (PFNGLUSEPROGRAM )wglGetProcAddress("glUseProgram");
+    glEnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAY )wglGetProcAddress("glEnableVertexAttribArray");
+    glDisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAY )wglGetProcAddress("glDisableVertexAttribArray");
+    glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTER )wglGetProcAddress("glVertexAttribPointer");
+    glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISOR )wglGetProcAddress("glVertexAttribDivisor");
+    glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCED )wglGetProcAddress("glDrawElementsInstanced");
+
+    // instancing is core in 3.3 and available as an extension before that
+    if (!glVertexAttribDivisor) {
+        glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISOR )wglGetProcAddress("glVertexAttribDivisorARB");
+    }
+    if (!glDrawElementsInstanced) {
+        glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCED )wglGetProcAddress("glDrawElementsInstancedARB");
+    }
+
+    if (glCreateShader && glVertexAttribDivisor && glDrawElementsInstanced) {
+        _model_program = create_model_program();
+    }
+
+    if (_model_program) {
+        glGenBuffers(1, &_instance_buffer);
+        _instancing = true;
+    } else {
+        log::warning("instanced drawing is not supported, models are drawn individually\n");
+    }
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::shutdown()
+{
+    for (auto const& it : _model_buffers) {
+        glDeleteBuffers(1, &it.second.vertex_buffer);
+        glDeleteBuffers(1, &it.second.index_buffer);
+    }
+    _model_buffers.clear();
+
+    if (_instance_buffer) {
+        glDeleteBuffers(1, &_instance_buffer);
+        _instance_buffer = 0;
+    }
+
+    if (_model_program) {
+        glDeleteProgram(_model_program);
+        _model_program = 0;
+    }
+
+    _instancing = false;
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::resize(vec2i framebuffer_size)
+{
+    _framebuffer_size = framebuffer_size;
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::execute(command_list const& commands)
+{
+    command const* batch = nullptr;
+    bool models_gathered = false;
+
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        command const& cmd = *it;
+
+        // consecutive model draws are drawn together at the first of them with
+        // one instanced call for each run of the same model, the remaining
+        // draws in the run are skipped
+        if (cmd.type != command_type::draw_model) {
+            models_gathered = false;
+        } else {
+            if (!models_gathered) {
+                if (batch) {
+                    end_batch(*batch);
+                    batch = nullptr;
+                }
+                _model_batcher.gather(it, commands.end());
+                draw_models();
+                models_gathered = true;
+            }
+            continue;
+        }
+
+        // consecutive boxes share state and are drawn as a single batch
+        if (batch && !can_batch(*batch, cmd)) {
+            end_batch(*batch);
+            batch = nullptr;
+        }
+        if (!batch) {
+            begin_batch(cmd);
+            batch = &cmd;
+        }
+
+        switch (cmd.type) {
+            case command_type::set_view:
+                set_view(cmd.as<set_view_command>().view);
+                break;
+
+            case command_type::draw_string:
+                draw_string(cmd.as<draw_string_command>());
+                break;
+
+            case command_type::draw_line:
+                draw_line(cmd.as<draw_line_command>());
+                break;
+
+            case command_type::draw_box:
+                draw_box(cmd.as<draw_box_command>());
+                break;
+
+            case command_type::draw_image:
+                draw_image(cmd.as<draw_image_command>());
+                break;
+
+            case command_type::draw_particles:
+                draw_particles(cmd.as<draw_particles_command>());
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (batch) {
+        end_batch(*batch);
+    }
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::begin_batch(command const& cmd)
+{
+    if (cmd.type == command_type::draw_box) {
+        glBegin(GL_QUADS);
+    }
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::end_batch(command const& cmd)
+{
+    if (cmd.type == command_type::draw_box) {
+        glEnd();
+    }
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::set_view(render::view const& view)
+{
+    glDisable(GL_TEXTURE_2D);
+
+    glClearColor(0, 0, 0, 0.1f);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0f);
+
+    glEnable(GL_POINT_SMOOTH );
+    glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
+    glPointSize(2.0f);
+
+    glEnable(GL_LINE_SMOOTH);
+    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    if (!view.viewport.empty()) {
+        glViewport(
+            view.viewport.mins().x,
+            view.viewport.mins().y,
+            view.viewport.size().x,
+            view.viewport.size().y
+        );
+    } else {
+        glViewport(0, 0, _framebuffer_size.x, _framebuffer_size.y);
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+
+    vec2 view_min = view.origin - view.size * 0.5f;
+    vec2 view_max = view.origin + view.size * 0.5f;
+
+    glOrtho(view_min.x, view_max.x, view_max.y, view_min.y, -99999, 99999);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_string(draw_string_command const& cmd)
+{
+    cmd.font->draw(string::view(cmd.text(), cmd.text() + cmd.length), cmd.position, cmd.color, cmd.scale);
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_line(draw_line_command const& cmd)
+{
+    glBegin(GL_LINES);
+        glColor4fv(cmd.start_color);
+        glVertex2fv(cmd.start);
+        glColor4fv(cmd.end_color);
+        glVertex2fv(cmd.end);
+    glEnd();
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_box(draw_box_command const& cmd)
+{
+    float   xl, xh, yl, yh;
+
+    glColor4fv(cmd.color);
+
+    xl = cmd.position.x - cmd.size.x / 2;
+    xh = cmd.position.x + cmd.size.x / 2;
+    yl = cmd.position.y - cmd.size.y / 2;
+    yh = cmd.position.y + cmd.size.y / 2;
+
+    // glBegin is called by begin_batch
+    glVertex2f(xl, yl);
+    glVertex2f(xh, yl);
+    glVertex2f(xh, yh);
+    glVertex2f(xl, yh);
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_image(draw_image_command const& cmd)
+{
+    vec2 org = cmd.position;
+    vec2 sz = cmd.size;
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, cmd.image->texnum());
+
+    glColor4fv(cmd.color);
+
+    glBegin(GL_TRIANGLE_STRIP);
+        glTexCoord2f(0.0f, 0.0f);
+        glVertex2f(org.x, org.y);
+
+        glTexCoord2f(1.0f, 0.0f);
+        glVertex2f(org.x + sz.x, org.y);
+
+        glTexCoord2f(0.0f, 1.0f );
+        glVertex2f(org.x, org.y + sz.y);
+
+        glTexCoord2f(1.0f, 1.0f );
+        glVertex2f(org.x + sz.x, org.y + sz.y);
+    glEnd();
+
+    glDisable(GL_TEXTURE_2D);
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_particles(draw_particles_command const& cmd)
+{
+    particle_vertex const* vertices = cmd.vertices();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    glVertexPointer(2, GL_FLOAT, sizeof(render::particle_vertex), &vertices[0].position);
+    glColorPointer(4, GL_FLOAT, sizeof(render::particle_vertex), &vertices[0].color);
+    glDrawElements(GL_TRIANGLES, (GLsizei)cmd.num_indices, GL_UNSIGNED_INT, cmd.indices());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_models()
+{
+    // model colors are scaled by the instance color and replace the
+    // destination, models are always opaque
+    glDisable(GL_ALPHA_TEST);
+
+    if (_instancing) {
+        auto const& instances = _model_batcher.instances();
+
+        glUseProgram(_model_program);
+        glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(model_instance), instances.data(), GL_STREAM_DRAW);
+
+        for (GLuint ii = 0; ii < 6; ++ii) {
+            glEnableVertexAttribArray(ii);
+            glVertexAttribDivisor(ii, ii < 2 ? 0 : 1);
+        }
+    } else {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+    }
+
+    for (auto const& batch : _model_batcher.batches()) {
+        model_buffers const& buffers = upload_model(batch.model);
+        if (_instancing) {
+            draw_instanced(buffers, batch.first_instance, batch.num_instances);
+        } else {
+            draw_individually(buffers, batch.first_instance, batch.num_instances);
+        }
+    }
+
+    if (_instancing) {
+        for (GLuint ii = 0; ii < 6; ++ii) {
+            glVertexAttribDivisor(ii, 0);
+            glDisableVertexAttribArray(ii);
+        }
+        glUseProgram(0);
+    } else {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glEnable(GL_ALPHA_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_instanced(model_buffers const& buffers, std::size_t first_instance, std::size_t num_instances)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void const*)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void const*)buffers.color_offset);
+
+    // instances of each model are contiguous in the instance buffer
+    std::size_t base = first_instance * sizeof(model_instance);
+    glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(model_instance), (void const*)(base + offsetof(model_instance, x_axis)));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(model_instance), (void const*)(base + offsetof(model_instance, y_axis)));
+    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(model_instance), (void const*)(base + offsetof(model_instance, translation)));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(model_instance), (void const*)(base + offsetof(model_instance, color)));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.index_buffer);
+
+    glBlendFunc(GL_ONE, GL_ZERO);
+    glDrawElementsInstanced(GL_TRIANGLES, buffers.num_indices, GL_UNSIGNED_SHORT, nullptr, (GLsizei)num_instances);
+
+    if (_draw_tris) {
+        glBlendFunc(GL_ONE_MINUS_DST_COLOR, GL_ZERO);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+        glDrawElementsInstanced(GL_TRIANGLES, buffers.num_indices, GL_UNSIGNED_SHORT, nullptr, (GLsizei)num_instances);
+
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+}
+
+//------------------------------------------------------------------------------
+void gl_backend::draw_individually(model_buffers const& buffers, std::size_t first_instance, std::size_t num_instances)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer);
+    glVertexPointer(2, GL_FLOAT, 0, (void const*)0);
+    glColorPointer(3, GL_FLOAT, 0, (void const*)buffers.color_offset);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.index_buffer);
+
+    glMatrixMode(GL_MODELVIEW);
+
+    for (std::size_t ii = 0; ii < num_instances; ++ii) {
+        model_instance const& instance = _model_batcher.instances()[first_instance + ii];
+        color4 color = instance.color;
+
+        glPushMatrix();
+
+        // Convert instance rows to mat4
+        mat4 m(instance.x_axis.x,       instance.x_axis.y,      0, 0,
+               instance.y_axis.x,       instance.y_axis.y,      0, 0,
+               0,                       0,                      1, 0,
+               instance.translation.x,  instance.translation.y, 0, 1);
+
+        glMultMatrixf((float const*)&m);
+
+        glBlendFunc(GL_CONSTANT_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+        glBlendColor(color.r, color.g, color.b, color.a);
+
+        glDrawElements(GL_TRIANGLES, buffers.num_indices, GL_UNSIGNED_SHORT, nullptr);
+
+        if (_draw_tris) {
+            glBlendFunc(GL_ONE_MINUS_DST_COLOR, GL_ZERO);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+            glDrawElements(GL_TRIANGLES, buffers.num_indices, GL_UNSIGNED_SHORT, nullptr);
+
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        }
+
+        glPopMatrix();
+    }
+}
+
+//------------------------------------------------------------------------------
+gl_backend::model_buffers const& gl_backend::upload_model(render::model const* model)
+{
+    auto it = _model_buffers.find(model);
+    if (it != _model_buffers.end()) {
+        return it->second;
+    }
+
+    model_buffers buffers{};
+    buffers.num_indices = (GLsizei)model->_indices.size();
+    buffers.color_offset = model->_vertices.size() * sizeof(vec2);
+
+    std::size_t vertex_size = buffers.color_offset + model->_colors.size() * sizeof(color3);
+
+    glGenBuffers(1, &buffers.vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertex_size, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, buffers.color_offset, model->_vertices.data());
+    glBufferSubData(GL_ARRAY_BUFFER, buffers.color_offset, vertex_size - buffers.color_offset, model->_colors.data());
+
+    glGenBuffers(1, &buffers.index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model->_indices.size() * sizeof(uint16_t), model->_indices.data(), GL_STATIC_DRAW);
+
+    return _model_buffers[model] = buffers;
+}
+
+//------------------------------------------------------------------------------
+GLuint gl_backend::create_model_program()
+{
+    // instance transforms are stored as rows, see mat3::operator*(vec2, mat3)
+    char const* vertex_source =
+        "#version 120\n"
+        "attribute vec2 position;\n"
+        "attribute vec3 color;\n"
+        "attribute vec2 x_axis;\n"
+        "attribute vec2 y_axis;\n"
+        "attribute vec2 translation;\n"
+        "attribute vec4 instance_color;\n"
+        "varying vec4 model_color;\n"
+        "void main() {\n"
+        "    vec2 p = position.x * x_axis + position.y * y_axis + translation;\n"
+        "    gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 0.0, 1.0);\n"
+        "    model_color = vec4(color * instance_color.rgb, instance_color.a);\n"
+        "}\n";
+
+    char const* fragment_source =
+        "#version 120\n"
+        "varying vec4 model_color;\n"
+        "void main() {\n"
+        "    gl_FragColor = model_color;\n"
+        "}\n";
+
+    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex_shader, 1, &vertex_source, NULL);
+    glCompileShader(vertex_shader);
+
+    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment_shader, 1, &fragment_source, NULL);
+    glCompileShader(fragment_shader);
+
+    GLint vertex_status = 0, fragment_status = 0;
+    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &vertex_status);
+    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &fragment_status);
+
+    GLuint program = 0;
+    if (vertex_status && fragment_status) {
+        program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+
+        // attribute locations must match the arrays set by draw_instanced
+        glBindAttribLocation(program, 0, "position");
+        glBindAttribLocation(program, 1, "color");
+        glBindAttribLocation(program, 2, "x_axis");
+        glBindAttribLocation(program, 3, "y_axis");
+        glBindAttribLocation(program, 4, "translation");
+        glBindAttribLocation(program, 5, "instance_color");
+        glLinkProgram(program);
+
+        GLint link_status = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+        if (!link_status) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    // shaders are deleted when the program is deleted
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    return program;
+}
+
+} // namespace render
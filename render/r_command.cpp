@@ -0,0 +1,135 @@
+// r_command.cpp
+//
+
+#include "cm_shared.h"
+#include "r_command.h"
+#include "r_particle.h"
+
+#include <cstring>
+#include <new>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+//------------------------------------------------------------------------------
+uint32_t const* draw_particles_command::indices() const
+{
+    return reinterpret_cast<uint32_t const*>(vertices() + num_vertices);
+}
+
+//------------------------------------------------------------------------------
+command_list::command_list()
+    : _used(0)
+    , _size(0)
+{}
+
+//------------------------------------------------------------------------------
+void command_list::clear()
+{
+    // keep the arena so that the next frame can reuse it
+    _used = 0;
+    _size = 0;
+}
+
+//------------------------------------------------------------------------------
+command_list::const_iterator command_list::begin() const
+{
+    return const_iterator(reinterpret_cast<command const*>(_arena.data()));
+}
+
+//------------------------------------------------------------------------------
+command_list::const_iterator command_list::end() const
+{
+    return const_iterator(reinterpret_cast<command const*>(reinterpret_cast<uint8_t const*>(_arena.data()) + _used));
+}
+
+//------------------------------------------------------------------------------
+template<typename T> T* command_list::allocate(std::size_t payload)
+{
+    static_assert(alignof(T) <= alignment, "command alignment exceeds arena alignment");
+
+    std::size_t size = (sizeof(T) + payload + alignment - 1) / alignment * alignment;
+    std::size_t num_blocks = (_used + size) / alignment;
+    if (_arena.size() < num_blocks) {
+        _arena.resize(std::max(num_blocks, _arena.size() * 2));
+    }
+
+    T* cmd = new (reinterpret_cast<uint8_t*>(_arena.data()) + _used) T;
+    static_cast<command*>(cmd)->type = T::type_value;
+    static_cast<command*>(cmd)->bytes = static_cast<uint32_t>(size);
+
+    _used += size;
+    ++_size;
+    return cmd;
+}
+
+//------------------------------------------------------------------------------
+void command_list::set_view(render::view const& view)
+{
+    allocate<set_view_command>()->view = view;
+}
+
+//------------------------------------------------------------------------------
+void command_list::draw_string(render::font const* font, string::view string, vec2 position, color4 color, vec2 scale)
+{
+    std::size_t length = string.end() - string.begin();
+    draw_string_command* cmd = allocate<draw_string_command>(length);
+    cmd->font = font;
+    cmd->position = position;
+    cmd->color = color;
+    cmd->scale = scale;
+    cmd->length = static_cast<uint32_t>(length);
+    memcpy(cmd + 1, string.begin(), length);
+}
+
+//------------------------------------------------------------------------------
+void command_list::draw_line(vec2 start, vec2 end, color4 start_color, color4 end_color)
+{
+    draw_line_command* cmd = allocate<draw_line_command>();
+    cmd->start = start;
+    cmd->end = end;
+    cmd->start_color = start_color;
+    cmd->end_color = end_color;
+}
+
+//------------------------------------------------------------------------------
+void command_list::draw_box(vec2 size, vec2 position, color4 color)
+{
+    draw_box_command* cmd = allocate<draw_box_command>();
+    cmd->size = size;
+    cmd->position = position;
+    cmd->color = color;
+}
+
+//------------------------------------------------------------------------------
+void command_list::draw_image(render::image const* image, vec2 position, vec2 size, color4 color)
+{
+    draw_image_command* cmd = allocate<draw_image_command>();
+    cmd->image = image;
+    cmd->position = position;
+    cmd->size = size;
+    cmd->color = color;
+}
+
+//------------------------------------------------------------------------------
+void command_list::draw_particles(particle_vertex const* vertices, std::size_t num_vertices, uint32_t const* indices, std::size_t num_indices)
+{
+    std::size_t vertex_bytes = num_vertices * sizeof(particle_vertex);
+    std::size_t index_bytes = num_indices * sizeof(uint32_t);
+    draw_particles_command* cmd = allocate<draw_particles_command>(vertex_bytes + index_bytes);
+    cmd->num_vertices = static_cast<uint32_t>(num_vertices);
+    cmd->num_indices = static_cast<uint32_t>(num_indices);
+    memcpy(cmd + 1, vertices, vertex_bytes);
+    memcpy(reinterpret_cast<uint8_t*>(cmd + 1) + vertex_bytes, indices, index_bytes);
+}
+
+//------------------------------------------------------------------------------
+void command_list::draw_model(render::model const* model, mat3 const& transform, color4 color)
+{
+    draw_model_command* cmd = allocate<draw_model_command>();
+    cmd->model = model;
+    cmd->transform = transform;
+    cmd->color = color;
+}
+
+} // namespace render
@@ -0,0 +1,190 @@
+// r_command.h
+//
+
+#pragma once
+
+#include "cm_vector.h"
+#include "cm_matrix.h"
+#include "cm_color.h"
+#include "cm_string.h"
+
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+class font;
+class image;
+class model;
+struct particle_vertex;
+
+//------------------------------------------------------------------------------
+struct view
+{
+    vec2 origin; //!< center
+    vec2 size;
+    rect viewport;
+};
+
+//------------------------------------------------------------------------------
+enum class command_type : uint32_t
+{
+    set_view,
+    draw_string,
+    draw_line,
+    draw_box,
+    draw_image,
+    draw_particles,
+    draw_model,
+    num_types,
+};
+
+//------------------------------------------------------------------------------
+//! Header common to all commands, each command is followed in the list by the
+//! next command `bytes` bytes after the start of the header.
+struct command
+{
+    command_type type;
+    uint32_t bytes;
+
+    template<typename T> T const& as() const {
+        return *static_cast<T const*>(this);
+    }
+};
+
+//------------------------------------------------------------------------------
+struct set_view_command : command
+{
+    static constexpr command_type type_value = command_type::set_view;
+    render::view view;
+};
+
+//------------------------------------------------------------------------------
+struct draw_string_command : command
+{
+    static constexpr command_type type_value = command_type::draw_string;
+    render::font const* font;
+    vec2 position;
+    color4 color;
+    vec2 scale;
+    uint32_t length;
+
+    //! characters immediately follow the command
+    char const* text() const { return reinterpret_cast<char const*>(this + 1); }
+};
+
+//------------------------------------------------------------------------------
+struct draw_line_command : command
+{
+    static constexpr command_type type_value = command_type::draw_line;
+    vec2 start;
+    vec2 end;
+    color4 start_color;
+    color4 end_color;
+};
+
+//------------------------------------------------------------------------------
+struct draw_box_command : command
+{
+    static constexpr command_type type_value = command_type::draw_box;
+    vec2 size;
+    vec2 position; //!< center
+    color4 color;
+};
+
+//------------------------------------------------------------------------------
+struct draw_image_command : command
+{
+    static constexpr command_type type_value = command_type::draw_image;
+    render::image const* image;
+    vec2 position; //!< top-left corner
+    vec2 size;
+    color4 color;
+};
+
+//------------------------------------------------------------------------------
+//! Draws a triangle list, vertices and then indices immediately follow the
+//! command.
+struct draw_particles_command : command
+{
+    static constexpr command_type type_value = command_type::draw_particles;
+    uint32_t num_vertices;
+    uint32_t num_indices;
+
+    particle_vertex const* vertices() const { return reinterpret_cast<particle_vertex const*>(this + 1); }
+    uint32_t const* indices() const;
+};
+
+//------------------------------------------------------------------------------
+struct draw_model_command : command
+{
+    static constexpr command_type type_value = command_type::draw_model;
+    render::model const* model;
+    mat3 transform;
+    color4 color;
+};
+
+//------------------------------------------------------------------------------
+//! Draw commands recorded into a linear arena. The arena is reused by each
+//! frame so that recording does not allocate once it has grown large enough
+//! for a typical frame. Commands are only valid until the list is cleared.
+class command_list
+{
+public:
+    command_list();
+
+    void clear();
+
+    //! number of commands in the list
+    std::size_t size() const { return _size; }
+
+    //! number of bytes used by the commands in the list
+    std::size_t bytes() const { return _used; }
+
+    void set_view(render::view const& view);
+    void draw_string(render::font const* font, string::view string, vec2 position, color4 color, vec2 scale);
+    void draw_line(vec2 start, vec2 end, color4 start_color, color4 end_color);
+    void draw_box(vec2 size, vec2 position, color4 color);
+    void draw_image(render::image const* image, vec2 position, vec2 size, color4 color);
+    void draw_particles(particle_vertex const* vertices, std::size_t num_vertices, uint32_t const* indices, std::size_t num_indices);
+    void draw_model(render::model const* model, mat3 const& transform, color4 color);
+
+    //------------------------------------------------------------------------------
+    class const_iterator
+    {
+    public:
+        command const& operator*() const { return *_command; }
+        command const* operator->() const { return _command; }
+        const_iterator& operator++() {
+            _command = reinterpret_cast<command const*>(reinterpret_cast<uint8_t const*>(_command) + _command->bytes);
+            return *this;
+        }
+        bool operator==(const_iterator const& other) const { return _command == other._command; }
+        bool operator!=(const_iterator const& other) const { return _command != other._command; }
+
+    protected:
+        friend command_list;
+        const_iterator(command const* c) : _command(c) {}
+        command const* _command;
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+protected:
+    //! commands are aligned to this many bytes within the arena
+    static constexpr std::size_t alignment = 16;
+
+    struct alignas(alignment) block { uint8_t bytes[alignment]; };
+
+    std::vector<block> _arena;
+    std::size_t _used; //!< bytes used by recorded commands
+    std::size_t _size; //!< number of recorded commands
+
+protected:
+    //! allocate a command of type `T` followed by `payload` bytes
+    template<typename T> T* allocate(std::size_t payload = 0);
+};
+
+} // namespace render
@@ -18,6 +18,8 @@ render::font const* system::load_font(string::view name, int size)
             return f.get();
         }
     }
+
+    context_scope scope(this);
     _fonts.push_back(std::make_unique<render::font>(name, size));
     return _fonts.back().get();
 }
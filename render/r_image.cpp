@@ -14,39 +14,11 @@ namespace render {
 //------------------------------------------------------------------------------
 render::image const* system::load_image(string::view name)
 {
+    context_scope scope(this);
     _images.push_back(std::make_unique<render::image>(name));
     return _images.back().get();
 }
 
-//------------------------------------------------------------------------------
-void system::draw_image(render::image const* img, vec2 org, vec2 sz, color4 color)
-{
-    if (img == nullptr) {
-        return;
-    }
-
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, img->texnum());
-
-    glColor4fv(color);
-
-    glBegin(GL_TRIANGLE_STRIP);
-        glTexCoord2f(0.0f, 0.0f);
-        glVertex2f(org.x, org.y);
-
-        glTexCoord2f(1.0f, 0.0f);
-        glVertex2f(org.x + sz.x, org.y);
-
-        glTexCoord2f(0.0f, 1.0f );
-        glVertex2f(org.x, org.y + sz.y);
-
-        glTexCoord2f(1.0f, 1.0f );
-        glVertex2f(org.x + sz.x, org.y + sz.y);
-    glEnd();
-
-    glDisable(GL_TEXTURE_2D);
-}
-
 //------------------------------------------------------------------------------
 image::image(string::view name)
     : _texnum(0)
@@ -17,7 +17,16 @@ system::system(render::window* window)
     , _rbo{0, 0}
     , _window(window)
     , _view{}
-    , _draw_tris("r_tris", 0, 0, "draw triangle edges")
+    , _record_index(0)
+    , _render_thread_enabled("r_thread", true, config::archive, "execute draw commands on a separate thread")
+    , _render_pending(false)
+    , _render_shutdown(false)
+    , _main_context(true)
+    , _present_size(0, 0)
+    , _submit_time(time_value::zero)
+    , _render_time(time_delta::zero)
+    , _frame_timing{}
+    , _backend(&_gl_backend)
 {}
 
 //------------------------------------------------------------------------------
@@ -33,7 +42,8 @@ result system::init()
     glGenFramebuffers = (PFNGLGENFRAMEBUFFERS )wglGetProcAddress("glGenFramebuffers");
     glFramebufferRenderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFER )wglGetProcAddress("glFramebufferRenderbuffer");
     glBlitFramebuffer = (PFNGLBLITFRAMEBUFFER )wglGetProcAddress("glBlitFramebuffer");
-    glBlendColor = (PFNGLBLENDCOLOR )wglGetProcAddress("glBlendColor");
+
+    _gl_backend.init();
 
     _view.size = vec2(_window->size());
     _view.origin = _view.size * 0.5f;
@@ -41,11 +51,10 @@ result system::init()
 
     resize(_window->size());
 
-    float k = 2.f * math::pi<float> / countof(_costbl);
-    for (int ii = 0; ii < countof(_costbl); ++ii) {
-        _sintbl[ii] = std::sin(k * ii);
-        _costbl[ii] = std::cos(k * ii);
+    if (_render_thread_enabled) {
+        start_render_thread();
     }
+    _render_thread_enabled.reset();
 
     return result::success;
 }
@@ -53,6 +62,9 @@ result system::init()
 //------------------------------------------------------------------------------
 void system::shutdown()
 {
+    stop_render_thread();
+
+    _gl_backend.shutdown();
     destroy_framebuffer();
     _fonts.clear();
 }
@@ -60,12 +72,75 @@ void system::shutdown()
 //------------------------------------------------------------------------------
 void system::begin_frame()
 {
-    glClear(GL_COLOR_BUFFER_BIT);
+    _commands[_record_index].clear();
+    _commands[_record_index].set_view(_view);
 }
 
 //------------------------------------------------------------------------------
 void system::end_frame()
 {
+    if (_render_thread_enabled.modified()) {
+        if (_render_thread_enabled) {
+            start_render_thread();
+        } else {
+            stop_render_thread();
+        }
+        _render_thread_enabled.reset();
+    }
+
+    time_value now = time_value::current();
+
+    if (!_render_thread.joinable()) {
+        execute_frame(_commands[_record_index], _window->size());
+
+        time_value submit_time = time_value::current();
+        _frame_timing.main = submit_time - _submit_time;
+        _frame_timing.wait = submit_time - now;
+        _frame_timing.render = _frame_timing.wait;
+        _frame_timing.overlap = time_delta::zero;
+        _submit_time = submit_time;
+    } else {
+        // wait for the previous frame and hand off the frame that was just
+        // recorded, the render thread executes it while the main thread
+        // continues on to the next frame
+        wait_for_frame();
+
+        time_value submit_time = time_value::current();
+        _frame_timing.main = submit_time - _submit_time;
+        _frame_timing.wait = submit_time - now;
+        _frame_timing.render = _render_time;
+        _frame_timing.overlap = std::max<time_delta>(time_delta::zero, _render_time - _frame_timing.wait);
+        _submit_time = submit_time;
+
+        {
+            std::unique_lock<std::mutex> lock(_render_mutex);
+            _record_index ^= 1;
+            _present_size = _window->size();
+            _render_pending = true;
+        }
+        _render_condition.notify_all();
+    }
+
+    if (_framebuffer_width.modified()
+            || _framebuffer_height.modified()
+            || _framebuffer_samples.modified()
+            || _framebuffer_scale.modified()) {
+        resize(_window->size());
+    }
+}
+
+//------------------------------------------------------------------------------
+void system::execute_frame(render::command_list const& commands, vec2i window_size)
+{
+    PROFILE_ZONE("render::execute_frame");
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    _backend->execute(commands);
+
     glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
@@ -73,29 +148,120 @@ void system::end_frame()
 
     glBlitFramebuffer(
         0, 0, _framebuffer_size.x, _framebuffer_size.y,
-        0, 0, _window->size().x, _window->size().y,
+        0, 0, window_size.x, window_size.y,
         GL_COLOR_BUFFER_BIT, GL_LINEAR
     );
 
     _window->end_frame();
+}
 
-    if (_framebuffer_width.modified()
-            || _framebuffer_height.modified()
-            || _framebuffer_samples.modified()
-            || _framebuffer_scale.modified()) {
-        resize(_window->size());
+//------------------------------------------------------------------------------
+void system::wait_for_frame()
+{
+    std::unique_lock<std::mutex> lock(_render_mutex);
+    _render_condition.wait(lock, [this]() {
+        return !_render_pending;
+    });
+}
+
+//------------------------------------------------------------------------------
+void system::start_render_thread()
+{
+    if (_render_thread.joinable()) {
+        return;
     }
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+    // the context can only be current on one thread at a time
+    wglMakeCurrent(NULL, NULL);
+    _main_context = false;
 
-    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    _render_shutdown = false;
+    _render_thread = std::thread(&system::render_thread, this);
+}
+
+//------------------------------------------------------------------------------
+void system::stop_render_thread()
+{
+    if (!_render_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_render_mutex);
+        _render_condition.wait(lock, [this]() {
+            return !_render_pending;
+        });
+        _render_shutdown = true;
+    }
+    _render_condition.notify_all();
+    _render_thread.join();
+
+    wglMakeCurrent(_window->hdc(), _window->hrc());
+    _main_context = true;
+}
+
+//------------------------------------------------------------------------------
+void system::render_thread()
+{
+    profile::set_thread_name("render");
+
+    std::unique_lock<std::mutex> lock(_render_mutex);
+
+    for (;;) {
+        _render_condition.wait(lock, [this]() {
+            return _render_pending || _render_shutdown;
+        });
+
+        if (_render_shutdown) {
+            break;
+        }
+
+        // the main thread does not touch the submitted list or the GL context
+        // until the frame is finished
+        render::command_list const& commands = _commands[_record_index ^ 1];
+        vec2i window_size = _present_size;
+        lock.unlock();
+
+        time_value start = time_value::current();
+        wglMakeCurrent(_window->hdc(), _window->hrc());
+        execute_frame(commands, window_size);
+        wglMakeCurrent(NULL, NULL);
+        time_delta render_time = time_value::current() - start;
+
+        lock.lock();
+        _render_time = render_time;
+        _render_pending = false;
+        _render_condition.notify_all();
+    }
+}
+
+//------------------------------------------------------------------------------
+system::context_scope::context_scope(render::system* system)
+    : _system(system)
+    , _acquired(false)
+{
+    if (!_system->_main_context) {
+        _system->wait_for_frame();
+        wglMakeCurrent(_system->_window->hdc(), _system->_window->hrc());
+        _system->_main_context = true;
+        _acquired = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+system::context_scope::~context_scope()
+{
+    if (_acquired) {
+        wglMakeCurrent(NULL, NULL);
+        _system->_main_context = false;
+    }
 }
 
 //------------------------------------------------------------------------------
 void system::set_view(render::view const& view)
 {
     _view = view;
-    set_default_state();
+    _commands[_record_index].set_view(view);
 }
 
 //------------------------------------------------------------------------------
@@ -105,6 +271,8 @@ void system::resize(vec2i size)
         return;
     }
 
+    context_scope scope(this);
+
     vec2i actual_size;
     actual_size.x = _framebuffer_width ? _framebuffer_width : static_cast<int>(size.x * _framebuffer_scale);
     actual_size.y = _framebuffer_height ? _framebuffer_height : static_cast<int>(size.y * _framebuffer_scale);
@@ -123,7 +291,7 @@ void system::resize(vec2i size)
     _framebuffer_scale.reset();
 
     create_default_font();
-    set_default_state();
+    _gl_backend.resize(_framebuffer_size);
 }
 
 //------------------------------------------------------------------------------
@@ -140,56 +308,6 @@ void system::create_default_font()
     }
 }
 
-//------------------------------------------------------------------------------
-void system::set_default_state()
-{
-    glDisable(GL_TEXTURE_2D);
-
-    glClearColor(0, 0, 0, 0.1f);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glEnable(GL_ALPHA_TEST);
-    glAlphaFunc(GL_GREATER, 0.0f);
-
-    glEnable(GL_POINT_SMOOTH );
-    glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
-    glPointSize(2.0f);
-
-    glEnable(GL_LINE_SMOOTH);
-    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    if (!_view.viewport.empty()) {
-        glViewport(
-            _view.viewport.mins().x,
-            _view.viewport.mins().y,
-            _view.viewport.size().x,
-            _view.viewport.size().y
-        );
-    } else {
-        glViewport(0, 0, _framebuffer_size.x, _framebuffer_size.y);
-    }
-
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-
-    vec2 view_min = _view.origin - _view.size * 0.5f;
-    vec2 view_max = _view.origin + _view.size * 0.5f;
-
-    glOrtho(view_min.x, view_max.x, view_max.y, view_min.y, -99999, 99999);
-
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-}
-
 //------------------------------------------------------------------------------
 void system::create_framebuffer(vec2i size, int samples)
 {
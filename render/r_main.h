@@ -7,6 +7,12 @@
 #include "cm_string.h"
 #include "cm_time.h"
 
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 #ifndef _WINDOWS_
 typedef struct HFONT__* HFONT;
 typedef struct HBITMAP__* HBITMAP;
@@ -18,6 +24,8 @@ typedef int GLint;
 typedef int GLsizei;
 typedef unsigned int GLuint;
 typedef float GLfloat;
+typedef char GLchar;
+typedef std::ptrdiff_t GLsizeiptr;
 
 #define GL_FRAMEBUFFER                  0x8D40
 #define GL_READ_FRAMEBUFFER             0x8CA8
@@ -33,6 +41,15 @@ typedef float GLfloat;
 #define GL_CONSTANT_ALPHA               0x8003
 #define GL_ONE_MINUS_CONSTANT_ALPHA     0x8004
 
+#define GL_ARRAY_BUFFER                 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER         0x8893
+#define GL_STREAM_DRAW                  0x88E0
+#define GL_STATIC_DRAW                  0x88E4
+#define GL_FRAGMENT_SHADER              0x8B30
+#define GL_VERTEX_SHADER                0x8B31
+#define GL_COMPILE_STATUS               0x8B81
+#define GL_LINK_STATUS                  0x8B82
+
 ////////////////////////////////////////////////////////////////////////////////
 namespace render {
 
@@ -90,11 +107,113 @@ protected:
 };
 
 //------------------------------------------------------------------------------
-struct view
+//! Executes command lists with OpenGL.
+class gl_backend : public backend
 {
-    vec2 origin; //!< center
-    vec2 size;
-    rect viewport;
+public:
+    gl_backend();
+
+    void init();
+    void shutdown();
+
+    //! set the size of the framebuffer that commands are drawn into
+    void resize(vec2i framebuffer_size);
+
+    virtual void execute(command_list const& commands) override;
+
+protected:
+    vec2i _framebuffer_size;
+
+    config::boolean _draw_tris;
+
+    //! vertex and index buffers of a model, uploaded the first time the model
+    //! is drawn and never modified
+    struct model_buffers
+    {
+        GLuint vertex_buffer; //!< positions followed by colors
+        GLuint index_buffer;
+        GLsizei num_indices;
+        std::size_t color_offset; //!< offset of colors in `vertex_buffer`
+    };
+
+    std::unordered_map<render::model const*, model_buffers> _model_buffers;
+
+    model_batcher _model_batcher;
+
+    //! true if models are drawn with instanced calls, otherwise each instance
+    //! is drawn individually from the same static buffers
+    bool _instancing;
+    GLuint _model_program;
+    GLuint _instance_buffer;
+
+protected:
+    void set_view(render::view const& view);
+    void draw_string(draw_string_command const& cmd);
+    void draw_line(draw_line_command const& cmd);
+    void draw_box(draw_box_command const& cmd);
+    void draw_image(draw_image_command const& cmd);
+    void draw_particles(draw_particles_command const& cmd);
+
+    //! draw all models gathered by `_model_batcher`
+    void draw_models();
+    void draw_instanced(model_buffers const& buffers, std::size_t first_instance, std::size_t num_instances);
+    void draw_individually(model_buffers const& buffers, std::size_t first_instance, std::size_t num_instances);
+
+    model_buffers const& upload_model(render::model const* model);
+    GLuint create_model_program();
+
+    //! set up state shared by all commands in a batch starting with `cmd`
+    void begin_batch(command const& cmd);
+    void end_batch(command const& cmd);
+
+    // additional opengl bindings
+    typedef void (APIENTRY* PFNGLBLENDCOLOR)(GLfloat red, GLfloat greed, GLfloat blue, GLfloat alpha);
+    typedef void (APIENTRY* PFNGLGENBUFFERS)(GLsizei n, GLuint* buffers);
+    typedef void (APIENTRY* PFNGLDELETEBUFFERS)(GLsizei n, GLuint const* buffers);
+    typedef void (APIENTRY* PFNGLBINDBUFFER)(GLenum target, GLuint buffer);
+    typedef void (APIENTRY* PFNGLBUFFERDATA)(GLenum target, GLsizeiptr size, void const* data, GLenum usage);
+    typedef void (APIENTRY* PFNGLBUFFERSUBDATA)(GLenum target, GLsizeiptr offset, GLsizeiptr size, void const* data);
+    typedef GLuint (APIENTRY* PFNGLCREATESHADER)(GLenum type);
+    typedef void (APIENTRY* PFNGLDELETESHADER)(GLuint shader);
+    typedef void (APIENTRY* PFNGLSHADERSOURCE)(GLuint shader, GLsizei count, GLchar const* const* string, GLint const* length);
+    typedef void (APIENTRY* PFNGLCOMPILESHADER)(GLuint shader);
+    typedef void (APIENTRY* PFNGLGETSHADERIV)(GLuint shader, GLenum pname, GLint* params);
+    typedef GLuint (APIENTRY* PFNGLCREATEPROGRAM)();
+    typedef void (APIENTRY* PFNGLDELETEPROGRAM)(GLuint program);
+    typedef void (APIENTRY* PFNGLATTACHSHADER)(GLuint program, GLuint shader);
+    typedef void (APIENTRY* PFNGLBINDATTRIBLOCATION)(GLuint program, GLuint index, GLchar const* name);
+    typedef void (APIENTRY* PFNGLLINKPROGRAM)(GLuint program);
+    typedef void (APIENTRY* PFNGLGETPROGRAMIV)(GLuint program, GLenum pname, GLint* params);
+    typedef void (APIENTRY* PFNGLUSEPROGRAM)(GLuint program);
+    typedef void (APIENTRY* PFNGLENABLEVERTEXATTRIBARRAY)(GLuint index);
+    typedef void (APIENTRY* PFNGLDISABLEVERTEXATTRIBARRAY)(GLuint index);
+    typedef void (APIENTRY* PFNGLVERTEXATTRIBPOINTER)(GLuint index, GLint size, GLenum type, unsigned char normalized, GLsizei stride, void const* pointer);
+    typedef void (APIENTRY* PFNGLVERTEXATTRIBDIVISOR)(GLuint index, GLuint divisor);
+    typedef void (APIENTRY* PFNGLDRAWELEMENTSINSTANCED)(GLenum mode, GLsizei count, GLenum type, void const* indices, GLsizei instancecount);
+
+    PFNGLBLENDCOLOR glBlendColor = NULL;
+    PFNGLGENBUFFERS glGenBuffers = NULL;
+    PFNGLDELETEBUFFERS glDeleteBuffers = NULL;
+    PFNGLBINDBUFFER glBindBuffer = NULL;
+    PFNGLBUFFERDATA glBufferData = NULL;
+    PFNGLBUFFERSUBDATA glBufferSubData = NULL;
+    PFNGLCREATESHADER glCreateShader = NULL;
+    PFNGLDELETESHADER glDeleteShader = NULL;
+    PFNGLSHADERSOURCE glShaderSource = NULL;
+    PFNGLCOMPILESHADER glCompileShader = NULL;
+    PFNGLGETSHADERIV glGetShaderiv = NULL;
+    PFNGLCREATEPROGRAM glCreateProgram = NULL;
+    PFNGLDELETEPROGRAM glDeleteProgram = NULL;
+    PFNGLATTACHSHADER glAttachShader = NULL;
+    PFNGLBINDATTRIBLOCATION glBindAttribLocation = NULL;
+    PFNGLLINKPROGRAM glLinkProgram = NULL;
+    PFNGLGETPROGRAMIV glGetProgramiv = NULL;
+    PFNGLUSEPROGRAM glUseProgram = NULL;
+    PFNGLENABLEVERTEXATTRIBARRAY glEnableVertexAttribArray = NULL;
+    PFNGLDISABLEVERTEXATTRIBARRAY glDisableVertexAttribArray = NULL;
+    PFNGLVERTEXATTRIBPOINTER glVertexAttribPointer = NULL;
+    PFNGLVERTEXATTRIBDIVISOR glVertexAttribDivisor = NULL;
+    PFNGLDRAWELEMENTSINSTANCED glDrawElementsInstanced = NULL;
 };
 
 //------------------------------------------------------------------------------
@@ -120,9 +239,10 @@ public:
 
     //  Image Interface (r_image.cpp)
     render::image const* load_image(string::view name);
-    void draw_image(render::image const* img, vec2 org, vec2 sz, color4 color = color4(1,1,1,1));
 
-    // Drawing Functions (r_draw.cpp)
+    // Drawing Functions (r_draw.cpp), recorded and executed at the end of the frame
+
+    void draw_image(render::image const* img, vec2 org, vec2 sz, color4 color = color4(1,1,1,1));
 
     void draw_string(string::view string, vec2 position, color4 color);
     vec2 string_size(string::view string) const;
@@ -132,11 +252,25 @@ public:
 
     void draw_line(vec2 start, vec2 end, color4 start_color, color4 end_color);
     void draw_box(vec2 size, vec2 position, color4 color);
-    void draw_particles(time_value time, render::particle const* particles, std::size_t num_particles);
+    void draw_particles(render::particle_store const& particles);
     void draw_model(render::model const* model, mat3 transform, color4 color);
 
     void set_view(render::view const& view);
 
+    //! Timing of the most recently completed frame
+    struct frame_timing {
+        time_delta main; //!< time between submitting consecutive frames on the main thread
+        time_delta wait; //!< time the main thread waited for the render thread
+        time_delta render; //!< time executing the frame's commands and presenting it
+        time_delta overlap; //!< time the render thread ran concurrently with the main thread
+    };
+
+    frame_timing const& get_frame_timing() const { return _frame_timing; }
+
+    //! wait until the render thread has finished the most recently submitted
+    //! frame, does nothing if the render thread is not running
+    void wait_for_frame();
+
 private:
 
     // More font stuff (r_font.cpp)
@@ -162,16 +296,62 @@ private:
     render::window* _window;
 
     void create_default_font();
-    void set_default_state();
     void create_framebuffer(vec2i size, int samples);
     void destroy_framebuffer();
 
     render::view _view;
 
-    config::boolean _draw_tris;
+    render::particle_tessellator _particle_tessellator;
+
+    //! commands recorded since the start of the frame, the other list is
+    //! executed by the render thread while the next frame is recorded
+    render::command_list _commands[2];
+    std::size_t _record_index;
+
+    //! execute the commands for a frame and present it
+    void execute_frame(render::command_list const& commands, vec2i window_size);
 
-    float _costbl[360];
-    float _sintbl[360];
+    //
+    // render thread
+    //
+
+    config::boolean _render_thread_enabled;
+
+    std::thread _render_thread;
+    std::mutex _render_mutex;
+    std::condition_variable _render_condition;
+    bool _render_pending; //!< a frame has been submitted and is not yet finished
+    bool _render_shutdown;
+
+    //! the GL context is current on the main thread, always true if the
+    //! render thread is not running
+    bool _main_context;
+
+    vec2i _present_size; //!< window size when the pending frame was submitted
+
+    time_value _submit_time; //!< time the previous frame was submitted
+    time_delta _render_time; //!< time the render thread spent on the last frame
+    frame_timing _frame_timing;
+
+    void start_render_thread();
+    void stop_render_thread();
+    void render_thread();
+
+    //! make the GL context current on the main thread for the lifetime of the
+    //! object so that resources can be created or destroyed
+    class context_scope
+    {
+    public:
+        context_scope(render::system* system);
+        ~context_scope();
+
+    protected:
+        render::system* _system;
+        bool _acquired;
+    };
+
+    render::gl_backend _gl_backend;
+    render::backend* _backend;
 
 private:
 
@@ -186,7 +366,6 @@ private:
     typedef void (APIENTRY* PFNGLGENFRAMEBUFFERS)(GLsizei n, GLuint* framebuffers);
     typedef void (APIENTRY* PFNGLFRAMEBUFFERRENDERBUFFER)(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
     typedef void (APIENTRY* PFNGLBLITFRAMEBUFFER)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
-    typedef void (APIENTRY* PFNGLBLENDCOLOR)(GLfloat red, GLfloat greed, GLfloat blue, GLfloat alpha);
 
     PFNGLBINDRENDERBUFFER glBindRenderbuffer = NULL;
     PFNGLDELETERENDERBUFFERS glDeleteRenderbuffers = NULL;
@@ -198,7 +377,6 @@ private:
     PFNGLGENFRAMEBUFFERS glGenFramebuffers = NULL;
     PFNGLFRAMEBUFFERRENDERBUFFER glFramebufferRenderbuffer = NULL;
     PFNGLBLITFRAMEBUFFER glBlitFramebuffer = NULL;
-    PFNGLBLENDCOLOR glBlendColor = NULL;
 };
 
 } // namespace render
@@ -1,8 +1,8 @@
 // r_model.cpp
 //
 
-#include "precompiled.h"
-#pragma hdrstop
+#include "cm_shared.h"
+#include "r_model.h"
 
 render::model tank_body_model({
     //  center        size          gamma
@@ -64,4 +64,14 @@ model::model(model::rect const* rects, std::size_t num_rects)
     }
 }
 
+//------------------------------------------------------------------------------
+bounds model::calculate_bounds(mat3 const& transform) const
+{
+    bounds b(_mins * transform, _mins * transform);
+    b.add(vec2(_maxs.x, _mins.y) * transform);
+    b.add(vec2(_mins.x, _maxs.y) * transform);
+    b.add(_maxs * transform);
+    return b;
+}
+
 } // namespace render
@@ -3,14 +3,18 @@
 
 #pragma once
 
-#include "cm_vector.h"
+#include "cm_bounds.h"
 #include "cm_color.h"
+#include "cm_matrix.h"
+#include "cm_vector.h"
 #include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace render {
 
 class system;
+class gl_backend;
+class software_backend;
 
 //------------------------------------------------------------------------------
 class model
@@ -28,8 +32,13 @@ public:
         : model(rects, Size)
     {}
 
+    //! axis-aligned bounds containing the model drawn with `transform`
+    bounds calculate_bounds(mat3 const& transform) const;
+
 protected:
     friend system;
+    friend gl_backend;
+    friend software_backend;
 
     std::vector<vec2> _vertices;
     std::vector<color3> _colors;
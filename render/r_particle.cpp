@@ -0,0 +1,447 @@
+// r_particle.cpp
+//
+
+#include "cm_shared.h"
+#include "r_particle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <xmmintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+namespace {
+
+//------------------------------------------------------------------------------
+//! Rational approximation of tanh for four values. Inputs are clamped to
+//! [-4.97, 4.97], where tanh is within 1e-4 of +/-1, and the absolute error
+//! of the approximation is below 1e-4 everywhere.
+__m128 tanh_ps(__m128 x)
+{
+    __m128 const limit = _mm_set1_ps(4.97f);
+    x = _mm_max_ps(_mm_min_ps(x, limit), _mm_sub_ps(_mm_setzero_ps(), limit));
+
+    __m128 x2 = _mm_mul_ps(x, x);
+    // x * (135135 + 17325 x^2 + 378 x^4 + x^6)
+    __m128 num = _mm_add_ps(_mm_set1_ps(378.f), x2);
+    num = _mm_add_ps(_mm_set1_ps(17325.f), _mm_mul_ps(num, x2));
+    num = _mm_add_ps(_mm_set1_ps(135135.f), _mm_mul_ps(num, x2));
+    num = _mm_mul_ps(num, x);
+    // 135135 + 62370 x^2 + 3150 x^4 + 28 x^6
+    __m128 den = _mm_add_ps(_mm_set1_ps(3150.f), _mm_mul_ps(_mm_set1_ps(28.f), x2));
+    den = _mm_add_ps(_mm_set1_ps(62370.f), _mm_mul_ps(den, x2));
+    den = _mm_add_ps(_mm_set1_ps(135135.f), _mm_mul_ps(den, x2));
+
+    __m128 const one = _mm_set1_ps(1.f);
+    __m128 y = _mm_div_ps(num, den);
+    return _mm_max_ps(_mm_min_ps(y, one), _mm_sub_ps(_mm_setzero_ps(), one));
+}
+
+//------------------------------------------------------------------------------
+//! Effective time of travel for particles slowed by drag, i.e. tanh(d t) / d,
+//! or `t` for particles without drag.
+__m128 drag_time_ps(__m128 t, __m128 drag)
+{
+    __m128 has_drag = _mm_cmpgt_ps(drag, _mm_setzero_ps());
+    // avoid dividing by zero in lanes without drag, they are masked out below
+    __m128 safe_drag = _mm_or_ps(_mm_and_ps(has_drag, drag), _mm_andnot_ps(has_drag, _mm_set1_ps(1.f)));
+    __m128 vt = _mm_div_ps(tanh_ps(_mm_mul_ps(safe_drag, t)), safe_drag);
+    return _mm_or_ps(_mm_and_ps(has_drag, vt), _mm_andnot_ps(has_drag, t));
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+particle_store::particle_store()
+    : _size(0)
+    , _base_time(time_value::zero)
+{}
+
+//------------------------------------------------------------------------------
+void particle_store::add(particle const& p)
+{
+    if (!_size) {
+        _base_time = p.time;
+    }
+
+    std::size_t index = _size++;
+    std::size_t capacity = (_size + block_size - 1) / block_size * block_size;
+    if (_columns[0].size() < capacity) {
+        for (auto& c : _columns) {
+            c.resize(capacity, 0.f);
+        }
+        _flags.resize(capacity, particle::flag_bits{});
+        _culled.resize(capacity / block_size, 0);
+    }
+
+    _columns[time_column][index] = (p.time - _base_time).to_seconds();
+    _columns[size_column][index] = p.size;
+    _columns[size_velocity_column][index] = p.size_velocity;
+    _columns[position_x_column][index] = p.position.x;
+    _columns[position_y_column][index] = p.position.y;
+    _columns[velocity_x_column][index] = p.velocity.x;
+    _columns[velocity_y_column][index] = p.velocity.y;
+    _columns[acceleration_x_column][index] = p.acceleration.x;
+    _columns[acceleration_y_column][index] = p.acceleration.y;
+    _columns[drag_column][index] = p.drag;
+    _columns[color_r_column][index] = p.color.r;
+    _columns[color_g_column][index] = p.color.g;
+    _columns[color_b_column][index] = p.color.b;
+    _columns[color_a_column][index] = p.color.a;
+    _columns[color_velocity_r_column][index] = p.color_velocity.r;
+    _columns[color_velocity_g_column][index] = p.color_velocity.g;
+    _columns[color_velocity_b_column][index] = p.color_velocity.b;
+    _columns[color_velocity_a_column][index] = p.color_velocity.a;
+    _flags[index] = p.flags;
+    _culled[index / block_size] &= static_cast<uint8_t>(~(1 << (index % block_size)));
+}
+
+//------------------------------------------------------------------------------
+void particle_store::clear()
+{
+    _size = 0;
+    for (auto& c : _columns) {
+        c.clear();
+    }
+    _flags.clear();
+    _culled.clear();
+}
+
+//------------------------------------------------------------------------------
+void particle_store::reserve(std::size_t count)
+{
+    std::size_t capacity = (count + block_size - 1) / block_size * block_size;
+    for (auto& c : _columns) {
+        c.reserve(capacity);
+    }
+    _flags.reserve(capacity);
+    _expired.reserve(capacity / block_size);
+    _culled.reserve(capacity / block_size);
+    _eviction_order.reserve(capacity);
+}
+
+//------------------------------------------------------------------------------
+void particle_store::evict(std::size_t count)
+{
+    if (count >= _size) {
+        _size = 0;
+        return;
+    } else if (!count) {
+        return;
+    }
+
+    float const* a = _columns[a_column].data();
+    float const* radius = _columns[radius_column].data();
+
+    // partition so that the first `count` particles are the least visible
+    _eviction_order.resize(_size);
+    std::iota(_eviction_order.begin(), _eviction_order.end(), 0);
+    std::nth_element(_eviction_order.begin(), _eviction_order.begin() + count, _eviction_order.end(),
+        [a, radius](uint32_t lhs, uint32_t rhs) {
+            return a[lhs] * radius[lhs] < a[rhs] * radius[rhs];
+        });
+
+    std::size_t num_blocks = (_size + block_size - 1) / block_size;
+    _expired.assign(num_blocks, 0);
+    for (std::size_t ii = 0; ii < count; ++ii) {
+        _expired[_eviction_order[ii] / block_size] |= static_cast<uint8_t>(1 << (_eviction_order[ii] % block_size));
+    }
+    if (_size % block_size) {
+        _expired[num_blocks - 1] |= static_cast<uint8_t>(0xf << (_size % block_size));
+    }
+
+    compact();
+}
+
+//------------------------------------------------------------------------------
+void particle_store::update(time_value time, time_delta tail_delay)
+{
+    if (!_size) {
+        return;
+    }
+
+    evaluate((time - _base_time).to_seconds(), tail_delay.to_seconds());
+    compact();
+}
+
+//------------------------------------------------------------------------------
+void particle_store::evaluate(float time, float tail_delay)
+{
+    std::size_t num_blocks = (_size + block_size - 1) / block_size;
+    _expired.resize(num_blocks);
+
+    float* c[num_columns];
+    for (int ii = 0; ii < num_columns; ++ii) {
+        c[ii] = _columns[ii].data();
+    }
+
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const half = _mm_set1_ps(.5f);
+    __m128 const now = _mm_set1_ps(time);
+    __m128 const delay = _mm_set1_ps(tail_delay);
+
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        std::size_t ii = block * block_size;
+
+        __m128 t = _mm_sub_ps(now, _mm_loadu_ps(c[time_column] + ii));
+        __m128 tail_t = _mm_max_ps(zero, _mm_sub_ps(t, delay));
+        __m128 drag = _mm_loadu_ps(c[drag_column] + ii);
+
+        // size and color change linearly with time
+        __m128 radius = _mm_add_ps(_mm_loadu_ps(c[size_column] + ii), _mm_mul_ps(_mm_loadu_ps(c[size_velocity_column] + ii), t));
+        __m128 r = _mm_add_ps(_mm_loadu_ps(c[color_r_column] + ii), _mm_mul_ps(_mm_loadu_ps(c[color_velocity_r_column] + ii), t));
+        __m128 g = _mm_add_ps(_mm_loadu_ps(c[color_g_column] + ii), _mm_mul_ps(_mm_loadu_ps(c[color_velocity_g_column] + ii), t));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(c[color_b_column] + ii), _mm_mul_ps(_mm_loadu_ps(c[color_velocity_b_column] + ii), t));
+        __m128 a = _mm_add_ps(_mm_loadu_ps(c[color_a_column] + ii), _mm_mul_ps(_mm_loadu_ps(c[color_velocity_a_column] + ii), t));
+
+        // position = p + v * vt + a * vt^2 / 2, where vt includes drag
+        __m128 vt = drag_time_ps(t, drag);
+        __m128 tail_vt = drag_time_ps(tail_t, drag);
+        __m128 at = _mm_mul_ps(half, _mm_mul_ps(vt, vt));
+        __m128 tail_at = _mm_mul_ps(half, _mm_mul_ps(tail_vt, tail_vt));
+
+        for (int axis = 0; axis < 2; ++axis) {
+            __m128 p = _mm_loadu_ps(c[position_x_column + axis] + ii);
+            __m128 v = _mm_loadu_ps(c[velocity_x_column + axis] + ii);
+            __m128 acc = _mm_loadu_ps(c[acceleration_x_column + axis] + ii);
+            _mm_storeu_ps(c[x_column + axis] + ii, _mm_add_ps(p, _mm_add_ps(_mm_mul_ps(v, vt), _mm_mul_ps(acc, at))));
+            _mm_storeu_ps(c[tail_x_column + axis] + ii, _mm_add_ps(p, _mm_add_ps(_mm_mul_ps(v, tail_vt), _mm_mul_ps(acc, tail_at))));
+        }
+
+        _mm_storeu_ps(c[age_column] + ii, t);
+        _mm_storeu_ps(c[radius_column] + ii, radius);
+        _mm_storeu_ps(c[r_column] + ii, r);
+        _mm_storeu_ps(c[g_column] + ii, g);
+        _mm_storeu_ps(c[b_column] + ii, b);
+        _mm_storeu_ps(c[a_column] + ii, a);
+
+        // particles expire when either their alpha or radius is negative
+        __m128 expired = _mm_or_ps(_mm_cmplt_ps(a, zero), _mm_cmplt_ps(radius, zero));
+        _expired[block] = static_cast<uint8_t>(_mm_movemask_ps(expired));
+    }
+
+    // padding lanes past the end of the last block are always expired
+    if (_size % block_size) {
+        _expired[num_blocks - 1] |= static_cast<uint8_t>(0xf << (_size % block_size));
+    }
+}
+
+//------------------------------------------------------------------------------
+void particle_store::compact()
+{
+    std::size_t num_blocks = (_size + block_size - 1) / block_size;
+    std::size_t count = 0;
+
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        std::size_t ii = block * block_size;
+        uint8_t expired = _expired[block];
+
+        // blocks with no expired particles only need to move if an earlier
+        // block had expired particles
+        if (!(expired & 0xf) && count == ii) {
+            count += block_size;
+            continue;
+        }
+
+        for (std::size_t lane = 0; lane < block_size; ++lane) {
+            if (expired & (1 << lane)) {
+                continue;
+            }
+            for (auto& c : _columns) {
+                c[count] = c[ii + lane];
+            }
+            _flags[count] = _flags[ii + lane];
+            ++count;
+        }
+    }
+
+    _size = count;
+    std::fill(_culled.begin(), _culled.end(), uint8_t(0));
+}
+
+//------------------------------------------------------------------------------
+std::size_t particle_store::cull(bounds const& view)
+{
+    std::size_t num_blocks = (_size + block_size - 1) / block_size;
+    std::size_t count = 0;
+
+    float const* x = _columns[x_column].data();
+    float const* y = _columns[y_column].data();
+    float const* tail_x = _columns[tail_x_column].data();
+    float const* tail_y = _columns[tail_y_column].data();
+    float const* radius = _columns[radius_column].data();
+
+    __m128 const view_min_x = _mm_set1_ps(view.mins().x);
+    __m128 const view_min_y = _mm_set1_ps(view.mins().y);
+    __m128 const view_max_x = _mm_set1_ps(view.maxs().x);
+    __m128 const view_max_y = _mm_set1_ps(view.maxs().y);
+
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        std::size_t ii = block * block_size;
+
+        // conservative bounds of the circle at the particle position and at
+        // its tail position, tails never extend beyond either circle
+        __m128 r = _mm_loadu_ps(radius + ii);
+        __m128 px = _mm_loadu_ps(x + ii);
+        __m128 py = _mm_loadu_ps(y + ii);
+        __m128 tx = _mm_loadu_ps(tail_x + ii);
+        __m128 ty = _mm_loadu_ps(tail_y + ii);
+
+        __m128 min_x = _mm_sub_ps(_mm_min_ps(px, tx), r);
+        __m128 min_y = _mm_sub_ps(_mm_min_ps(py, ty), r);
+        __m128 max_x = _mm_add_ps(_mm_max_ps(px, tx), r);
+        __m128 max_y = _mm_add_ps(_mm_max_ps(py, ty), r);
+
+        __m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(max_x, view_min_x), _mm_cmpgt_ps(min_x, view_max_x)),
+                                   _mm_or_ps(_mm_cmplt_ps(max_y, view_min_y), _mm_cmpgt_ps(min_y, view_max_y)));
+
+        int mask = _mm_movemask_ps(outside);
+        if (ii + block_size > _size) {
+            mask &= (1 << (_size - ii)) - 1;
+        }
+
+        _culled[block] = static_cast<uint8_t>(mask);
+        count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+    }
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+particle_tessellator::particle_tessellator()
+{
+    float k = 2.f * math::pi<float> / num_segments;
+    for (int ii = 0; ii < num_segments; ++ii) {
+        _sintbl[ii] = std::sin(k * ii);
+        _costbl[ii] = std::cos(k * ii);
+    }
+}
+
+//------------------------------------------------------------------------------
+int particle_tessellator::segment_step(float radius, bool tail)
+{
+    // Number of circle segments, approximation for pi / acos(1 - 1/2x)
+    int n = 1 + static_cast<int>(math::pi<float> * std::sqrt(std::max(0.f, radius - 0.25f)));
+    if (tail) {
+        // particle needs at least 4 verts to look reasonable
+        n = std::max<int>(4, n);
+    }
+    return std::max<int>(1, num_segments / n);
+}
+
+//------------------------------------------------------------------------------
+void particle_tessellator::tessellate(particle_store const& particles, float view_scale)
+{
+    std::size_t num_vertices = 0;
+    std::size_t num_indices = 0;
+
+    // count vertices first so that buffers are only resized once
+    _steps.resize(particles.size());
+    for (std::size_t idx = 0; idx < particles.size(); ++idx) {
+        if (particles.age(idx) < 0 || particles.culled(idx)) {
+            _steps[idx] = 0;
+            continue;
+        }
+
+        _steps[idx] = segment_step(particles.radius(idx) * view_scale, particles.flags(idx) & particle::tail);
+        num_vertices += 1 + ring_size(_steps[idx]);
+        num_indices += 3 * ring_size(_steps[idx]);
+    }
+
+    _vertices.resize(num_vertices);
+    _indices.resize(num_indices);
+
+    particle_vertex* vertex = _vertices.data();
+    uint32_t* index = _indices.data();
+    uint32_t base = 0;
+
+    for (std::size_t idx = 0; idx < particles.size(); ++idx) {
+        int k = _steps[idx];
+        if (!k) {
+            continue;
+        }
+
+        int n = ring_size(k);
+        float radius = particles.radius(idx);
+        color4 color = particles.color(idx);
+        vec2 position = particles.position(idx);
+        particle::flag_bits flags = particles.flags(idx);
+
+        color4 color_in = flags & particle::invert ? color * color4(1,1,1,0.25f) : color;
+        color4 color_out = flags & particle::invert ? color : color * color4(1,1,1,0.25f);
+
+        vertex[0].position = position;
+        vertex[0].color = color_in;
+        particle_vertex* ring = vertex + 1;
+
+        if (!(flags & particle::tail)) {
+            // circle outline, four vertices at a time
+            __m128 const px = _mm_set1_ps(position.x);
+            __m128 const py = _mm_set1_ps(position.y);
+            __m128 const r = _mm_set1_ps(radius);
+            __m128 const c = _mm_loadu_ps(color_out);
+
+            int ii = 0;
+            for (; ii + 4 <= n; ii += 4) {
+                int jj = ii * k;
+                __m128 cs = _mm_setr_ps(_costbl[jj], _costbl[jj + k], _costbl[jj + 2 * k], _costbl[jj + 3 * k]);
+                __m128 sn = _mm_setr_ps(_sintbl[jj], _sintbl[jj + k], _sintbl[jj + 2 * k], _sintbl[jj + 3 * k]);
+                __m128 x = _mm_add_ps(px, _mm_mul_ps(cs, r));
+                __m128 y = _mm_add_ps(py, _mm_mul_ps(sn, r));
+                __m128 lo = _mm_unpacklo_ps(x, y);
+                __m128 hi = _mm_unpackhi_ps(x, y);
+
+                _mm_storel_pi(reinterpret_cast<__m64*>(&ring[ii + 0].position.x), lo);
+                _mm_storeh_pi(reinterpret_cast<__m64*>(&ring[ii + 1].position.x), lo);
+                _mm_storel_pi(reinterpret_cast<__m64*>(&ring[ii + 2].position.x), hi);
+                _mm_storeh_pi(reinterpret_cast<__m64*>(&ring[ii + 3].position.x), hi);
+                _mm_storeu_ps(ring[ii + 0].color, c);
+                _mm_storeu_ps(ring[ii + 1].color, c);
+                _mm_storeu_ps(ring[ii + 2].color, c);
+                _mm_storeu_ps(ring[ii + 3].color, c);
+            }
+            for (; ii < n; ++ii) {
+                ring[ii].position = position + vec2(_costbl[ii * k], _sintbl[ii * k]) * radius;
+                ring[ii].color = color_out;
+            }
+        } else {
+            vec2 tail_position = particles.tail_position(idx);
+
+            // calculate forward and tangent vectors
+            vec2 normal = position - tail_position;
+            float distance = normal.length();
+            normal /= distance;
+            distance = std::max<float>(distance, radius);
+            vec2 tangent = vec2(-normal.y, normal.x);
+
+            for (int ii = 0; ii < n; ++ii) {
+                int jj = ii * k;
+                if (jj < num_segments / 2) {
+                    // forward-facing half-circle
+                    ring[ii].position = position + (tangent * _costbl[jj] + normal * _sintbl[jj]) * radius;
+                    ring[ii].color = color_in;
+                } else {
+                    // backward-facing elliptical tail
+                    float alpha = -_sintbl[jj];
+                    ring[ii].position = position + tangent * _costbl[jj] * radius + normal * _sintbl[jj] * distance;
+                    ring[ii].color = color_out * alpha + color_in * (1.0f - alpha);
+                }
+            }
+        }
+
+        // triangle fan around the center, closed by the first ring vertex
+        for (int ii = 0; ii < n; ++ii) {
+            index[0] = base;
+            index[1] = base + 1 + ii;
+            index[2] = base + 1 + (ii + 1) % n;
+            index += 3;
+        }
+
+        vertex += 1 + n;
+        base += 1 + n;
+    }
+}
+
+} // namespace render
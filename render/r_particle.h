@@ -3,10 +3,13 @@
 
 #pragma once
 
+#include "cm_bounds.h"
 #include "cm_time.h"
 #include "cm_vector.h"
 #include "cm_color.h"
 
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////
 namespace render {
 
@@ -30,4 +33,156 @@ struct particle
     flag_bits flags;
 };
 
+//------------------------------------------------------------------------------
+//! Particles stored as one array per component so that all particles can be
+//! evaluated by vectorized loops. Particles are added from `particle` records
+//! and evaluated in bulk by `update`, which also removes expired particles.
+class particle_store
+{
+public:
+    particle_store();
+
+    std::size_t size() const { return _size; }
+
+    void add(particle const& p);
+    void clear();
+
+    //! preallocate storage for `count` particles so that adding particles up
+    //! to that count does not allocate
+    void reserve(std::size_t count);
+
+    //! remove the `count` least visible particles, i.e. those with the lowest
+    //! product of alpha and radius as of the last call to `update`, particles
+    //! must not be added between `update` and `evict`
+    void evict(std::size_t count);
+
+    //! evaluate all particles at `time` and remove particles which have
+    //! faded out or shrunk to nothing, tails are evaluated at the position of
+    //! each particle `tail_delay` before `time`
+    void update(time_value time, time_delta tail_delay);
+
+    //! mark particles which are entirely outside of `view` as of the last
+    //! call to `update` so that they are not drawn, returns the number of
+    //! particles culled. Culling is cleared by the next `update`
+    std::size_t cull(bounds const& view);
+
+    //
+    //  evaluated state, valid until the next call to `add` or `clear`
+    //
+
+    //! seconds since the particle was spawned, negative if not yet spawned
+    float age(std::size_t index) const { return _columns[age_column][index]; }
+    float radius(std::size_t index) const { return _columns[radius_column][index]; }
+    vec2 position(std::size_t index) const { return vec2(_columns[x_column][index], _columns[y_column][index]); }
+    vec2 tail_position(std::size_t index) const { return vec2(_columns[tail_x_column][index], _columns[tail_y_column][index]); }
+    color4 color(std::size_t index) const {
+        return color4(_columns[r_column][index], _columns[g_column][index], _columns[b_column][index], _columns[a_column][index]);
+    }
+    particle::flag_bits flags(std::size_t index) const { return _flags[index]; }
+    bool culled(std::size_t index) const { return (_culled[index / block_size] >> (index % block_size)) & 1; }
+
+protected:
+    enum column {
+        // spawn state
+        time_column, //!< spawn time in seconds relative to `_base_time`
+        size_column,
+        size_velocity_column,
+        position_x_column,
+        position_y_column,
+        velocity_x_column,
+        velocity_y_column,
+        acceleration_x_column,
+        acceleration_y_column,
+        drag_column,
+        color_r_column,
+        color_g_column,
+        color_b_column,
+        color_a_column,
+        color_velocity_r_column,
+        color_velocity_g_column,
+        color_velocity_b_column,
+        color_velocity_a_column,
+
+        // evaluated state
+        age_column,
+        radius_column,
+        x_column,
+        y_column,
+        tail_x_column,
+        tail_y_column,
+        r_column,
+        g_column,
+        b_column,
+        a_column,
+
+        num_columns,
+    };
+
+    //! columns are padded to a multiple of this so that vectorized loops do
+    //! not need a scalar remainder
+    static constexpr std::size_t block_size = 4;
+
+    std::size_t _size;
+    std::vector<float> _columns[num_columns];
+    std::vector<particle::flag_bits> _flags;
+
+    //! spawn times are stored relative to this time so that they fit in a
+    //! float, it is reset whenever the store is empty
+    time_value _base_time;
+
+protected:
+    //! evaluate all particles at `time` seconds after `_base_time` and mark
+    //! expired particles in `_expired`
+    void evaluate(float time, float tail_delay);
+
+    //! remove expired particles, preserving the order of the remainder
+    void compact();
+
+    std::vector<uint8_t> _expired; //!< expired lanes of each block as a bit mask
+    std::vector<uint8_t> _culled; //!< culled lanes of each block as a bit mask
+    std::vector<uint32_t> _eviction_order; //!< scratch space for `evict`
+};
+
+//------------------------------------------------------------------------------
+struct particle_vertex
+{
+    vec2 position;
+    color4 color;
+};
+
+//------------------------------------------------------------------------------
+//! Converts evaluated particles into a single interleaved vertex buffer and
+//! triangle list so that all particles can be drawn with one draw call. Each
+//! particle is tessellated as a fan around its center with the number of
+//! segments chosen from its radius in pixels. Buffers are kept between calls
+//! so that steady state tessellation does not allocate.
+class particle_tessellator
+{
+public:
+    particle_tessellator();
+
+    //! tessellate all spawned particles in `particles` which have not been
+    //! culled, `view_scale` is the number of pixels per unit in the view
+    void tessellate(particle_store const& particles, float view_scale);
+
+    std::vector<particle_vertex> const& vertices() const { return _vertices; }
+    std::vector<uint32_t> const& indices() const { return _indices; }
+
+    //! number of segments in a full circle at the highest level of detail
+    static constexpr int num_segments = 360;
+
+    //! returns the index step into the segment tables for a particle with
+    //! the given radius in pixels, each particle has `ring_size` outer vertices
+    static int segment_step(float radius, bool tail);
+    static int ring_size(int step) { return (num_segments + step - 1) / step; }
+
+protected:
+    float _costbl[num_segments];
+    float _sintbl[num_segments];
+
+    std::vector<particle_vertex> _vertices;
+    std::vector<uint32_t> _indices;
+    std::vector<int> _steps; //!< segment step of each particle, or 0 if not drawn
+};
+
 } // namespace render
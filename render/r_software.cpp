@@ -0,0 +1,592 @@
+// r_software.cpp
+//
+
+#include "cm_shared.h"
+#include "cm_job.h"
+#include "r_software.h"
+#include "r_model.h"
+#include "r_particle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <xmmintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+//------------------------------------------------------------------------------
+//! Classic 5x7 pixel font for characters 0x20 through 0x7e. Each character is
+//! five columns from left to right, the lowest bit of each column is the top.
+constexpr uint8_t font_5x7[][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5f,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7f,0x14,0x7f,0x14}, //  !"#
+    {0x24,0x2a,0x7f,0x2a,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, // $%&'
+    {0x00,0x1c,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1c,0x00}, {0x08,0x2a,0x1c,0x2a,0x08}, {0x08,0x08,0x3e,0x08,0x08}, // ()*+
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02}, // ,-./
+    {0x3e,0x51,0x49,0x45,0x3e}, {0x00,0x42,0x7f,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4b,0x31}, // 0123
+    {0x18,0x14,0x12,0x7f,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3c,0x4a,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 4567
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1e}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00}, // 89:;
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, // <=>?
+    {0x32,0x49,0x79,0x41,0x3e}, {0x7e,0x11,0x11,0x11,0x7e}, {0x7f,0x49,0x49,0x49,0x36}, {0x3e,0x41,0x41,0x41,0x22}, // @ABC
+    {0x7f,0x41,0x41,0x22,0x1c}, {0x7f,0x49,0x49,0x49,0x41}, {0x7f,0x09,0x09,0x01,0x01}, {0x3e,0x41,0x41,0x51,0x32}, // DEFG
+    {0x7f,0x08,0x08,0x08,0x7f}, {0x00,0x41,0x7f,0x41,0x00}, {0x20,0x40,0x41,0x3f,0x01}, {0x7f,0x08,0x14,0x22,0x41}, // HIJK
+    {0x7f,0x40,0x40,0x40,0x40}, {0x7f,0x02,0x04,0x02,0x7f}, {0x7f,0x04,0x08,0x10,0x7f}, {0x3e,0x41,0x41,0x41,0x3e}, // LMNO
+    {0x7f,0x09,0x09,0x09,0x06}, {0x3e,0x41,0x51,0x21,0x5e}, {0x7f,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31}, // PQRS
+    {0x01,0x01,0x7f,0x01,0x01}, {0x3f,0x40,0x40,0x40,0x3f}, {0x1f,0x20,0x40,0x20,0x1f}, {0x7f,0x20,0x18,0x20,0x7f}, // TUVW
+    {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7f,0x41,0x41,0x00}, // XYZ[
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7f,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40}, // \]^_
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7f,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, // `abc
+    {0x38,0x44,0x44,0x48,0x7f}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7e,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3c}, // defg
+    {0x7f,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7d,0x40,0x00}, {0x20,0x40,0x44,0x3d,0x00}, {0x00,0x7f,0x10,0x28,0x44}, // hijk
+    {0x00,0x41,0x7f,0x40,0x00}, {0x7c,0x04,0x18,0x04,0x78}, {0x7c,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, // lmno
+    {0x7c,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7c}, {0x7c,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20}, // pqrs
+    {0x04,0x3f,0x44,0x40,0x20}, {0x3c,0x40,0x40,0x20,0x7c}, {0x1c,0x20,0x40,0x20,0x1c}, {0x3c,0x40,0x30,0x40,0x3c}, // tuvw
+    {0x44,0x28,0x10,0x28,0x44}, {0x0c,0x50,0x50,0x50,0x3c}, {0x44,0x64,0x54,0x4c,0x44}, {0x00,0x08,0x36,0x41,0x00}, // xyz{
+    {0x00,0x00,0x7f,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x10,0x08,0x08,0x10,0x08},                              // |}~
+};
+
+//------------------------------------------------------------------------------
+color4 saturate(color4 c)
+{
+    return color4(clamp(c.r, 0.f, 1.f),
+                  clamp(c.g, 0.f, 1.f),
+                  clamp(c.b, 0.f, 1.f),
+                  clamp(c.a, 0.f, 1.f));
+}
+
+//------------------------------------------------------------------------------
+//! Twice the signed area of the triangle `a`, `b`, `p`.
+float edge_function(vec2 a, vec2 b, vec2 p)
+{
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+//------------------------------------------------------------------------------
+//! Returns true if pixel centers that lie exactly on the edge from `a` to `b`
+//! belong to the triangle. Exactly one of two triangles sharing an edge in
+//! opposite directions owns the edge so that no pixel is drawn twice.
+bool is_top_left(vec2 a, vec2 b)
+{
+    return (b.y - a.y) > 0.f || ((b.y - a.y) == 0.f && (b.x - a.x) < 0.f);
+}
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+//------------------------------------------------------------------------------
+software_backend::software_backend(job::system* jobs)
+    : _jobs(jobs)
+    , _size(0, 0)
+    , _num_tiles(0, 0)
+    , _stride(0)
+    , _view_scale(1, 1)
+    , _view_offset(0, 0)
+{}
+
+//------------------------------------------------------------------------------
+void software_backend::resize(vec2i size)
+{
+    _size = vec2i(std::max(size.x, 0), std::max(size.y, 0));
+    _num_tiles = vec2i((_size.x + tile_size - 1) / tile_size,
+                       (_size.y + tile_size - 1) / tile_size);
+    _stride = _num_tiles.x * tile_size;
+
+    // rows and columns are padded so that tiles never need to be clipped
+    _pixels.assign(_stride * _num_tiles.y * tile_size, color4(0, 0, 0, 0));
+    _bins.resize(_num_tiles.x * _num_tiles.y);
+}
+
+//------------------------------------------------------------------------------
+void software_backend::execute(command_list const& commands)
+{
+    _primitives.clear();
+    set_view(render::view{vec2(_size) * .5f, vec2(_size), rect{}});
+
+    bool models_gathered = false;
+
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        command const& cmd = *it;
+
+        if (cmd.type != command_type::draw_model) {
+            models_gathered = false;
+        }
+
+        switch (cmd.type) {
+            case command_type::set_view:
+                set_view(cmd.as<set_view_command>().view);
+                break;
+
+            case command_type::draw_string:
+                add_string(cmd.as<draw_string_command>());
+                break;
+
+            case command_type::draw_line:
+                add_line(cmd.as<draw_line_command>());
+                break;
+
+            case command_type::draw_box:
+                add_box(cmd.as<draw_box_command>());
+                break;
+
+            case command_type::draw_image:
+                // images are only used by the menus
+                break;
+
+            case command_type::draw_particles:
+                add_particles(cmd.as<draw_particles_command>());
+                break;
+
+            case command_type::draw_model:
+                // models are drawn in the same order as the OpenGL backend
+                if (!models_gathered) {
+                    _models.gather(it, commands.end());
+                    add_models();
+                    models_gathered = true;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    bin_primitives();
+
+    int num_tiles = _num_tiles.x * _num_tiles.y;
+    if (_jobs) {
+        _jobs->parallel_for(0, num_tiles, 1, [this](std::size_t first, std::size_t last) {
+            for (std::size_t ii = first; ii < last; ++ii) {
+                rasterize_tile(static_cast<int>(ii));
+            }
+        });
+    } else {
+        for (int ii = 0; ii < num_tiles; ++ii) {
+            rasterize_tile(ii);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+color4 software_backend::pixel(int x, int y) const
+{
+    if (x < 0 || x >= _size.x || y < 0 || y >= _size.y) {
+        return color4(0, 0, 0, 0);
+    }
+    return _pixels[y * _stride + x];
+}
+
+//------------------------------------------------------------------------------
+result software_backend::write_image(char const* filename) const
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return result::failure;
+    }
+
+    // uncompressed true-color image with 8 bits of alpha and a top-left origin
+    uint8_t header[18] = {};
+    header[2] = 2;
+    header[12] = narrow_cast<uint8_t>(_size.x & 0xff);
+    header[13] = narrow_cast<uint8_t>(_size.x >> 8);
+    header[14] = narrow_cast<uint8_t>(_size.y & 0xff);
+    header[15] = narrow_cast<uint8_t>(_size.y >> 8);
+    header[16] = 32;
+    header[17] = 0x28;
+
+    std::vector<uint8_t> row(_size.x * 4);
+    bool success = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (int y = 0; y < _size.y && success; ++y) {
+        color4 const* src = _pixels.data() + y * _stride;
+        for (int x = 0; x < _size.x; ++x) {
+            row[x * 4 + 0] = static_cast<uint8_t>(clamp(src[x].b, 0.f, 1.f) * 255.f + .5f);
+            row[x * 4 + 1] = static_cast<uint8_t>(clamp(src[x].g, 0.f, 1.f) * 255.f + .5f);
+            row[x * 4 + 2] = static_cast<uint8_t>(clamp(src[x].r, 0.f, 1.f) * 255.f + .5f);
+            row[x * 4 + 3] = static_cast<uint8_t>(clamp(src[x].a, 0.f, 1.f) * 255.f + .5f);
+        }
+        success = fwrite(row.data(), row.size(), 1, file) == 1 || row.empty();
+    }
+
+    fclose(file);
+    return success ? result::success : result::failure;
+}
+
+//------------------------------------------------------------------------------
+void software_backend::set_view(render::view const& view)
+{
+    // equivalent to the orthographic projection used by the OpenGL backend,
+    // viewports are specified from the bottom-left corner of the framebuffer
+    vec2 viewport_mins(0, 0);
+    vec2 viewport_size(_size);
+    if (!view.viewport.empty()) {
+        viewport_size = vec2(view.viewport.size());
+        viewport_mins = vec2(float(view.viewport.mins().x),
+                             float(_size.y - view.viewport.mins().y) - viewport_size.y);
+    }
+
+    vec2 view_mins = view.origin - view.size * .5f;
+    _view_scale = vec2(viewport_size.x / view.size.x, viewport_size.y / view.size.y);
+    _view_offset = viewport_mins - view_mins * _view_scale;
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_triangle(vec2 p0, vec2 p1, vec2 p2, color4 c0, color4 c1, color4 c2, blend_mode blend)
+{
+    _primitives.push_back({primitive::triangle, blend, {p0, p1, p2}, {c0, c1, c2}});
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_rect(vec2 mins, vec2 maxs, color4 color)
+{
+    _primitives.push_back({primitive::rect, blend_mode::alpha, {mins, maxs, vec2(0, 0)}, {color, color, color}});
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_string(draw_string_command const& cmd)
+{
+    // glyphs are drawn at a fixed size in pixels like the bitmap fonts used by
+    // the OpenGL backend, scaled up on large framebuffers to remain legible
+    float s = std::max(1.f, std::floor(_size.y / 480.f + .5f));
+    vec2 cursor = to_screen(cmd.position);
+    cursor = vec2(std::floor(cursor.x + .5f), std::floor(cursor.y + .5f));
+
+    color4 default_color = saturate(cmd.color);
+    color4 color = default_color;
+
+    char const* text = cmd.text();
+    char const* end = text + cmd.length;
+
+    while (text < end) {
+        char const* next = find_color(text, end);
+        if (!next) {
+            next = end;
+        }
+
+        for (; text < next; ++text) {
+            uint8_t ch = static_cast<uint8_t>(*text);
+            if (ch >= 0x20 && ch < 0x7f) {
+                uint8_t const* glyph = font_5x7[ch - 0x20];
+                for (int x = 0; x < 5; ++x) {
+                    // draw each vertical run of lit pixels as a single rect
+                    for (int y = 0; y < 7; ++y) {
+                        if (!(glyph[x] & (1 << y))) {
+                            continue;
+                        }
+                        int y0 = y;
+                        while (y + 1 < 7 && (glyph[x] & (1 << (y + 1)))) {
+                            ++y;
+                        }
+                        add_rect(cursor + vec2(float(x), float(y0 - 7)) * s,
+                                 cursor + vec2(float(x + 1), float(y + 1 - 7)) * s,
+                                 color);
+                    }
+                }
+            }
+            cursor.x += 6.f * s;
+        }
+
+        if (text < end) {
+            int r, g, b;
+            if (get_color(text, r, g, b)) {
+                color = color4(r / 255.f, g / 255.f, b / 255.f, default_color.a);
+            } else {
+                color = default_color;
+            }
+            text += 4;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_line(draw_line_command const& cmd)
+{
+    vec2 start = to_screen(cmd.start);
+    vec2 end = to_screen(cmd.end);
+    vec2 dir = end - start;
+    float length = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+    if (length <= 0.f) {
+        return;
+    }
+
+    // lines are one pixel wide quads
+    vec2 normal = vec2(-dir.y, dir.x) * (.5f / length);
+    color4 c0 = saturate(cmd.start_color);
+    color4 c1 = saturate(cmd.end_color);
+
+    add_triangle(start - normal, start + normal, end + normal, c0, c0, c1, blend_mode::alpha);
+    add_triangle(start - normal, end + normal, end - normal, c0, c1, c1, blend_mode::alpha);
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_box(draw_box_command const& cmd)
+{
+    vec2 a = to_screen(cmd.position - cmd.size * .5f);
+    vec2 b = to_screen(cmd.position + cmd.size * .5f);
+    add_rect(vec2(std::min(a.x, b.x), std::min(a.y, b.y)),
+             vec2(std::max(a.x, b.x), std::max(a.y, b.y)),
+             saturate(cmd.color));
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_particles(draw_particles_command const& cmd)
+{
+    particle_vertex const* vertices = cmd.vertices();
+    uint32_t const* indices = cmd.indices();
+
+    for (uint32_t ii = 0; ii + 2 < cmd.num_indices; ii += 3) {
+        particle_vertex const& v0 = vertices[indices[ii + 0]];
+        particle_vertex const& v1 = vertices[indices[ii + 1]];
+        particle_vertex const& v2 = vertices[indices[ii + 2]];
+
+        // skip triangles which are completely transparent
+        if (v0.color.a <= 0.f && v1.color.a <= 0.f && v2.color.a <= 0.f) {
+            continue;
+        }
+
+        add_triangle(to_screen(v0.position), to_screen(v1.position), to_screen(v2.position),
+                     saturate(v0.color), saturate(v1.color), saturate(v2.color),
+                     blend_mode::alpha);
+    }
+}
+
+//------------------------------------------------------------------------------
+void software_backend::add_models()
+{
+    for (auto const& batch : _models.batches()) {
+        render::model const* model = batch.model;
+
+        for (std::size_t jj = 0; jj < batch.num_instances; ++jj) {
+            model_instance const& instance = _models.instances()[batch.first_instance + jj];
+            mat3 tx(instance.x_axis.x, instance.x_axis.y, 0,
+                    instance.y_axis.x, instance.y_axis.y, 0,
+                    instance.translation.x, instance.translation.y, 1);
+
+            // the OpenGL backend scales vertex colors by the instance color and
+            // the source replaces the destination
+            for (std::size_t ii = 0; ii + 2 < model->_indices.size(); ii += 3) {
+                uint16_t i0 = model->_indices[ii + 0];
+                uint16_t i1 = model->_indices[ii + 1];
+                uint16_t i2 = model->_indices[ii + 2];
+
+                add_triangle(to_screen(model->_vertices[i0] * tx),
+                             to_screen(model->_vertices[i1] * tx),
+                             to_screen(model->_vertices[i2] * tx),
+                             saturate(color4(model->_colors[i0]) * instance.color),
+                             saturate(color4(model->_colors[i1]) * instance.color),
+                             saturate(color4(model->_colors[i2]) * instance.color),
+                             blend_mode::replace);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void software_backend::bin_primitives()
+{
+    for (auto& bin : _bins) {
+        bin.clear();
+    }
+
+    for (std::size_t ii = 0; ii < _primitives.size(); ++ii) {
+        primitive const& p = _primitives[ii];
+
+        vec2 mins, maxs;
+        if (p.type == primitive::triangle) {
+            mins = vec2(std::min({p.position[0].x, p.position[1].x, p.position[2].x}),
+                        std::min({p.position[0].y, p.position[1].y, p.position[2].y}));
+            maxs = vec2(std::max({p.position[0].x, p.position[1].x, p.position[2].x}),
+                        std::max({p.position[0].y, p.position[1].y, p.position[2].y}));
+        } else {
+            mins = p.position[0];
+            maxs = p.position[1];
+        }
+
+        // conservative pixel bounds, clipped to the framebuffer
+        int x0 = std::max(0, static_cast<int>(std::floor(mins.x)));
+        int y0 = std::max(0, static_cast<int>(std::floor(mins.y)));
+        int x1 = std::min(_size.x - 1, static_cast<int>(std::floor(maxs.x)));
+        int y1 = std::min(_size.y - 1, static_cast<int>(std::floor(maxs.y)));
+        if (x0 > x1 || y0 > y1) {
+            continue;
+        }
+
+        for (int ty = y0 / tile_size; ty <= y1 / tile_size; ++ty) {
+            for (int tx = x0 / tile_size; tx <= x1 / tile_size; ++tx) {
+                _bins[ty * _num_tiles.x + tx].push_back(static_cast<uint32_t>(ii));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void software_backend::rasterize_tile(int tile_index)
+{
+    int x0 = (tile_index % _num_tiles.x) * tile_size;
+    int y0 = (tile_index / _num_tiles.x) * tile_size;
+    int x1 = x0 + tile_size;
+    int y1 = y0 + tile_size;
+
+    for (int y = y0; y < y1; ++y) {
+        std::fill_n(_pixels.data() + y * _stride + x0, tile_size, color4(0, 0, 0, 0));
+    }
+
+    // primitives are binned in submission order so blending matches the order
+    // in which commands were recorded
+    for (uint32_t index : _bins[tile_index]) {
+        primitive const& p = _primitives[index];
+        if (p.type == primitive::triangle) {
+            rasterize_triangle(p, x0, y0, x1, y1);
+        } else {
+            rasterize_rect(p, x0, y0, x1, y1);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void software_backend::rasterize_triangle(primitive const& p, int x0, int y0, int x1, int y1)
+{
+    vec2 v0 = p.position[0];
+    vec2 v1 = p.position[1];
+    vec2 v2 = p.position[2];
+    color4 c0 = p.color[0];
+    color4 c1 = p.color[1];
+    color4 c2 = p.color[2];
+
+    float area = edge_function(v0, v1, v2);
+    if (area == 0.f) {
+        return;
+    } else if (area < 0.f) {
+        std::swap(v1, v2);
+        std::swap(c1, c2);
+        area = -area;
+    }
+
+    // clip the triangle bounds to the tile, pixel centers are at half offsets
+    float min_x = std::min({v0.x, v1.x, v2.x});
+    float min_y = std::min({v0.y, v1.y, v2.y});
+    float max_x = std::max({v0.x, v1.x, v2.x});
+    float max_y = std::max({v0.y, v1.y, v2.y});
+
+    int bx0 = std::max(x0, static_cast<int>(std::floor(min_x)));
+    int by0 = std::max(y0, static_cast<int>(std::floor(min_y)));
+    int bx1 = std::min(x1, static_cast<int>(std::ceil(max_x)));
+    int by1 = std::min(y1, static_cast<int>(std::ceil(max_y)));
+    if (bx0 >= bx1 || by0 >= by1) {
+        return;
+    }
+
+    // pixels are processed in aligned groups of four
+    bx0 &= ~3;
+
+    // edge function coefficients, w = a * (x - v.x) + b * (y - v.y)
+    vec2 const e[3][2] = {{v1, v2}, {v2, v0}, {v0, v1}};
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const all_ones = _mm_cmpeq_ps(zero, zero);
+    __m128 ea[3], eb[3], ex[3], ey[3], owned[3];
+    for (int ii = 0; ii < 3; ++ii) {
+        ea[ii] = _mm_set1_ps(-(e[ii][1].y - e[ii][0].y));
+        eb[ii] = _mm_set1_ps(e[ii][1].x - e[ii][0].x);
+        ex[ii] = _mm_set1_ps(e[ii][0].x);
+        ey[ii] = _mm_set1_ps(e[ii][0].y);
+        owned[ii] = is_top_left(e[ii][0], e[ii][1])
+            ? all_ones : _mm_setzero_ps();
+    }
+
+    __m128 const one = _mm_set1_ps(1.f);
+    __m128 const inv_area = _mm_set1_ps(1.f / area);
+    __m128 const offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, .5f);
+
+    __m128 const r0 = _mm_set1_ps(c0.r), g0 = _mm_set1_ps(c0.g), b0 = _mm_set1_ps(c0.b), a0 = _mm_set1_ps(c0.a);
+    __m128 const r1 = _mm_set1_ps(c1.r), g1 = _mm_set1_ps(c1.g), b1 = _mm_set1_ps(c1.b), a1 = _mm_set1_ps(c1.a);
+    __m128 const r2 = _mm_set1_ps(c2.r), g2 = _mm_set1_ps(c2.g), b2 = _mm_set1_ps(c2.b), a2 = _mm_set1_ps(c2.a);
+
+    for (int y = by0; y < by1; ++y) {
+        __m128 py = _mm_set1_ps(y + .5f);
+        float* row = reinterpret_cast<float*>(_pixels.data() + y * _stride);
+
+        for (int x = bx0; x < bx1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+
+            __m128 w[3];
+            __m128 inside = all_ones;
+            for (int ii = 0; ii < 3; ++ii) {
+                w[ii] = _mm_add_ps(_mm_mul_ps(ea[ii], _mm_sub_ps(px, ex[ii])),
+                                   _mm_mul_ps(eb[ii], _mm_sub_ps(py, ey[ii])));
+                __m128 on_edge = _mm_and_ps(_mm_cmpeq_ps(w[ii], zero), owned[ii]);
+                inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(w[ii], zero), on_edge));
+            }
+
+            if (!_mm_movemask_ps(inside)) {
+                continue;
+            }
+
+            // interpolate vertex colors with barycentric coordinates
+            __m128 l0 = _mm_mul_ps(w[0], inv_area);
+            __m128 l1 = _mm_mul_ps(w[1], inv_area);
+            __m128 l2 = _mm_mul_ps(w[2], inv_area);
+
+            __m128 sr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, l0), _mm_mul_ps(r1, l1)), _mm_mul_ps(r2, l2));
+            __m128 sg = _mm_add_ps(_mm_add_ps(_mm_mul_ps(g0, l0), _mm_mul_ps(g1, l1)), _mm_mul_ps(g2, l2));
+            __m128 sb = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, l0), _mm_mul_ps(b1, l1)), _mm_mul_ps(b2, l2));
+            __m128 sa = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, l0), _mm_mul_ps(a1, l1)), _mm_mul_ps(a2, l2));
+
+            __m128 dr = _mm_loadu_ps(row + x * 4 + 0);
+            __m128 dg = _mm_loadu_ps(row + x * 4 + 4);
+            __m128 db = _mm_loadu_ps(row + x * 4 + 8);
+            __m128 da = _mm_loadu_ps(row + x * 4 + 12);
+            _MM_TRANSPOSE4_PS(dr, dg, db, da);
+
+            if (p.blend == blend_mode::alpha) {
+                // alpha test and source alpha blending
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(sa, zero));
+                __m128 ia = _mm_sub_ps(one, sa);
+                sr = _mm_add_ps(_mm_mul_ps(sr, sa), _mm_mul_ps(dr, ia));
+                sg = _mm_add_ps(_mm_mul_ps(sg, sa), _mm_mul_ps(dg, ia));
+                sb = _mm_add_ps(_mm_mul_ps(sb, sa), _mm_mul_ps(db, ia));
+                sa = _mm_add_ps(_mm_mul_ps(sa, sa), _mm_mul_ps(da, ia));
+            }
+
+            dr = _mm_or_ps(_mm_and_ps(inside, sr), _mm_andnot_ps(inside, dr));
+            dg = _mm_or_ps(_mm_and_ps(inside, sg), _mm_andnot_ps(inside, dg));
+            db = _mm_or_ps(_mm_and_ps(inside, sb), _mm_andnot_ps(inside, db));
+            da = _mm_or_ps(_mm_and_ps(inside, sa), _mm_andnot_ps(inside, da));
+
+            _MM_TRANSPOSE4_PS(dr, dg, db, da);
+            _mm_storeu_ps(row + x * 4 + 0, dr);
+            _mm_storeu_ps(row + x * 4 + 4, dg);
+            _mm_storeu_ps(row + x * 4 + 8, db);
+            _mm_storeu_ps(row + x * 4 + 12, da);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void software_backend::rasterize_rect(primitive const& p, int x0, int y0, int x1, int y1)
+{
+    color4 const& c = p.color[0];
+    if (c.a <= 0.f) {
+        return;
+    }
+
+    // pixels whose centers lie inside the rect, including the top-left edges
+    int bx0 = std::max(x0, static_cast<int>(std::ceil(p.position[0].x - .5f)));
+    int by0 = std::max(y0, static_cast<int>(std::ceil(p.position[0].y - .5f)));
+    int bx1 = std::min(x1, static_cast<int>(std::ceil(p.position[1].x - .5f)));
+    int by1 = std::min(y1, static_cast<int>(std::ceil(p.position[1].y - .5f)));
+
+    // rects are a solid color so each pixel is blended as a single vector
+    __m128 const src = _mm_mul_ps(_mm_loadu_ps(&c.r), _mm_set1_ps(c.a));
+    __m128 const inv_alpha = _mm_set1_ps(1.f - c.a);
+
+    for (int y = by0; y < by1; ++y) {
+        float* row = reinterpret_cast<float*>(_pixels.data() + y * _stride);
+        for (int x = bx0; x < bx1; ++x) {
+            __m128 dst = _mm_loadu_ps(row + x * 4);
+            _mm_storeu_ps(row + x * 4, _mm_add_ps(src, _mm_mul_ps(dst, inv_alpha)));
+        }
+    }
+}
+
+} // namespace render
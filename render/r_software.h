@@ -0,0 +1,95 @@
+// r_software.h
+//
+
+#pragma once
+
+#include "r_backend.h"
+
+#include <vector>
+
+namespace job {
+class system;
+} // namespace job
+
+////////////////////////////////////////////////////////////////////////////////
+namespace render {
+
+//------------------------------------------------------------------------------
+//! Executes command lists on the CPU into an in-memory framebuffer so that
+//! frames can be rendered without a GPU or a window. Primitives are converted
+//! to screen space and binned into square tiles, then each tile is rasterized
+//! independently with edge functions evaluated for four pixels at a time, so
+//! tiles can be rasterized in parallel with identical results. Images are not
+//! drawn and text is drawn with a built-in 5x7 pixel font.
+class software_backend : public backend
+{
+public:
+    //! tiles are rasterized in parallel by `jobs` if it is not null
+    software_backend(job::system* jobs = nullptr);
+
+    void resize(vec2i size);
+    vec2i size() const { return _size; }
+
+    virtual void execute(command_list const& commands) override;
+
+    //! returns the color of the pixel at `x`, `y` counting down from the top
+    color4 pixel(int x, int y) const;
+
+    //! write the framebuffer as an uncompressed 32-bit TGA image
+    result write_image(char const* filename) const;
+
+    //! width and height of tiles in pixels
+    static constexpr int tile_size = 64;
+
+protected:
+    enum class blend_mode
+    {
+        alpha, //!< blend with source alpha, discard fragments with zero alpha
+        replace, //!< replace destination, used by models
+    };
+
+    struct primitive
+    {
+        enum { triangle, rect } type;
+        blend_mode blend;
+        vec2 position[3]; //!< screen space vertices, or mins and maxs of a rect
+        color4 color[3];
+    };
+
+    job::system* _jobs;
+
+    vec2i _size;
+    vec2i _num_tiles;
+    int _stride; //!< pixels per row, padded to a multiple of the tile size
+    std::vector<color4> _pixels;
+
+    std::vector<primitive> _primitives;
+    std::vector<std::vector<uint32_t>> _bins; //!< primitives overlapping each tile
+
+    model_batcher _models;
+
+    //! transform from view space to screen space
+    vec2 _view_scale;
+    vec2 _view_offset;
+
+protected:
+    void set_view(render::view const& view);
+    vec2 to_screen(vec2 v) const { return v * _view_scale + _view_offset; }
+
+    void add_triangle(vec2 p0, vec2 p1, vec2 p2, color4 c0, color4 c1, color4 c2, blend_mode blend);
+    void add_rect(vec2 mins, vec2 maxs, color4 color);
+
+    void add_string(draw_string_command const& cmd);
+    void add_line(draw_line_command const& cmd);
+    void add_box(draw_box_command const& cmd);
+    void add_particles(draw_particles_command const& cmd);
+    //! add all models gathered by `_models`
+    void add_models();
+
+    void bin_primitives();
+    void rasterize_tile(int tile_index);
+    void rasterize_triangle(primitive const& p, int x0, int y0, int x1, int y1);
+    void rasterize_rect(primitive const& p, int x0, int y0, int x1, int y1);
+};
+
+} // namespace render
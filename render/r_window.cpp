@@ -332,6 +332,7 @@ void window::resize_for_dpi(RECT const* suggested, int dpi)
 
     _current_dpi = dpi;
 
+    _renderer.wait_for_frame();
     end_frame();
 }
 
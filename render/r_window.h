@@ -27,6 +27,7 @@ public:
 
     HWND hwnd() const { return _hwnd; }
     HDC hdc() const { return _hdc; }
+    HGLRC hrc() const { return _hrc; }
 
     bool active() const { return _active; }
     vec2i position() const { return _position; }
@@ -5,6 +5,9 @@
 
 #include "cm_vector.h"
 
+#include <cassert>
+#include <cstring>
+
 ////////////////////////////////////////////////////////////////////////////////
 
 //------------------------------------------------------------------------------
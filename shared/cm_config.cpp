@@ -36,7 +36,10 @@ variable_base::variable_base(string_view name, string_view value, string_view ty
     , _type(type_from_string(type_string))
     , _flags(atoi(flags_string.c_str()))
     , _description(description)
-{}
+    , _generation(0)
+{
+    update_value();
+}
 
 //------------------------------------------------------------------------------
 void variable_base::set(string_view value)
@@ -87,6 +90,18 @@ void variable_base::set_string(string_view s)
 {
     _value = string_buffer(s);
     _flags |= flags::modified;
+    update_value();
+}
+
+//------------------------------------------------------------------------------
+void variable_base::update_value()
+{
+    _integer = atoi(_value.c_str());
+    _boolean = _value == "true" ? true
+        : _value == "false" ? false
+        : _integer != 0;
+    _scalar = static_cast<float>(std::atof(_value.c_str()));
+    ++_generation;
 }
 
 //------------------------------------------------------------------------------
@@ -136,32 +151,6 @@ string_buffer variable_base::to_string(float f) const
     return string_buffer(s.c_str());
 }
 
-//------------------------------------------------------------------------------
-string_view variable_base::get_string() const
-{
-    return _value;
-}
-
-//------------------------------------------------------------------------------
-int variable_base::get_integer() const
-{
-    return atoi(_value.c_str());
-}
-
-//------------------------------------------------------------------------------
-bool variable_base::get_boolean() const
-{
-    return _value == "true" ? true
-        : _value == "false" ? false
-        : atoi(_value.c_str()) != 0; 
-}
-
-//------------------------------------------------------------------------------
-float variable_base::get_scalar() const
-{
-    return static_cast<float>(std::atof(_value.c_str()));
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //------------------------------------------------------------------------------
 variable::variable(string_view name, string_view value, value_type type, int flags, string_view description)
@@ -177,12 +166,6 @@ variable::variable(string_view name, string_view value, value_type type, int fla
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//------------------------------------------------------------------------------
-string::operator string_view() const
-{
-    return get_string();
-}
-
 //------------------------------------------------------------------------------
 config::string& string::operator=(string_view s)
 {
@@ -191,12 +174,6 @@ config::string& string::operator=(string_view s)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//------------------------------------------------------------------------------
-integer::operator int() const
-{
-    return get_integer();
-}
-
 //------------------------------------------------------------------------------
 config::integer& integer::operator=(int i)
 {
@@ -205,12 +182,6 @@ config::integer& integer::operator=(int i)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//------------------------------------------------------------------------------
-boolean::operator bool() const
-{
-    return get_boolean(); 
-}
-
 //------------------------------------------------------------------------------
 config::boolean& boolean::operator=(bool b)
 {
@@ -219,12 +190,6 @@ config::boolean& boolean::operator=(bool b)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//------------------------------------------------------------------------------
-scalar::operator float() const
-{
-    return get_scalar();
-}
-
 //------------------------------------------------------------------------------
 config::scalar& scalar::operator=(float f)
 {
@@ -338,6 +303,7 @@ void system::init()
                     log::warning("archived variable '^fff%s^xxx' has wrong type, reverting to default\n", text.tokens()[0].c_str());
                 } else {
                     it->second->_value = string_buffer(text.tokens()[1]);
+                    it->second->update_value();
                 }
             } else {
                 // create new variable
@@ -50,7 +50,10 @@ public:
         , _type(type)
         , _flags(flags)
         , _description(description)
-    {}
+        , _generation(0)
+    {
+        update_value();
+    }
     variable_base(string_view name, string_view value, string_view type_string, string_view flags_string, string_view description);
 
     string_view name() const { return _name; }
@@ -62,6 +65,10 @@ public:
     void reset() { _flags &= ~flags::modified; }
     void set(string_view value);
 
+    //! incremented each time the value changes, can be compared against a
+    //! previously saved generation to determine if derived values are stale
+    std::size_t generation() const { return _generation; }
+
 protected:
     friend system;
     friend variable;
@@ -72,11 +79,21 @@ protected:
     int _flags;
     value_type _type;
 
+    //! typed values are parsed once when the value changes
+    int _integer;
+    bool _boolean;
+    float _scalar;
+
+    std::size_t _generation;
+
 protected:
-    string_view get_string() const;
-    int get_integer() const;
-    bool get_boolean() const;
-    float get_scalar() const;
+    string_view get_string() const { return _value; }
+    int get_integer() const { return _integer; }
+    bool get_boolean() const { return _boolean; }
+    float get_scalar() const { return _scalar; }
+
+    //! parse typed values from the string value
+    void update_value();
 
     void set_string(string_view s);
     void set_integer(int i);
@@ -100,6 +117,7 @@ public:
     bool modified() const { return _base->modified(); }
     void reset() { _base->reset(); }
     void set(string_view value) { _base->set(value); }
+    std::size_t generation() const { return _base->generation(); }
 
 protected:
     friend system;
@@ -135,7 +153,7 @@ public:
         : variable(name, value, value_type::string, flags, description)
     {}
 
-    operator string_view() const;
+    operator string_view() const { return get_string(); }
     config::string& operator=(string_view s);
 };
 
@@ -147,7 +165,7 @@ public:
         : variable(name, to_string(value), value_type::integer, flags, description)
     {}
 
-    operator int() const;
+    operator int() const { return get_integer(); }
     config::integer& operator=(int i);
 };
 
@@ -159,7 +177,7 @@ public:
         : variable(name, to_string(value), value_type::boolean, flags, description)
     {}
 
-    operator bool() const;
+    operator bool() const { return get_boolean(); }
     config::boolean& operator=(bool b);
 };
 
@@ -171,7 +189,7 @@ public:
         : variable(name, to_string(value), value_type::scalar, flags, description)
     {}
 
-    operator float() const;
+    operator float() const { return get_scalar(); }
     config::scalar& operator=(float f);
 };
 
@@ -0,0 +1,184 @@
+// cm_job.cpp
+//
+
+#include "cm_job.h"
+
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace job {
+
+system* system::_singleton = nullptr;
+
+namespace {
+
+//! system which owns the calling thread, if any
+thread_local system const* t_system = nullptr;
+//! index of the queue owned by the calling thread
+thread_local std::size_t t_queue_index = 0;
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+system::system()
+    : _num_pending(0)
+    , _exit(false)
+{
+    assert(_singleton == nullptr);
+    _singleton = this;
+
+    // queue for jobs submitted by threads outside of the pool
+    _queues.push_back(std::make_unique<queue>());
+}
+
+//------------------------------------------------------------------------------
+system::~system()
+{
+    shutdown();
+
+    assert(_singleton == this);
+    _singleton = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void system::init(int num_threads)
+{
+    shutdown();
+
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+
+    _exit = false;
+    _queues.resize(1);
+    for (int ii = 0; ii < num_threads; ++ii) {
+        _queues.push_back(std::make_unique<queue>());
+    }
+    for (int ii = 0; ii < num_threads; ++ii) {
+        _workers.emplace_back(&system::worker_thread, this, ii + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+void system::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _exit = true;
+    }
+    _sleep_condition.notify_all();
+
+    for (auto& thread : _workers) {
+        thread.join();
+    }
+    _workers.clear();
+
+    for (auto& q : _queues) {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        for (auto& entry : q->jobs) {
+            entry.counter->_value.fetch_sub(1, std::memory_order_release);
+        }
+        q->jobs.clear();
+    }
+    _num_pending = 0;
+}
+
+//------------------------------------------------------------------------------
+void system::submit(std::function<void()>&& function, job::counter& counter)
+{
+    counter._value.fetch_add(1, std::memory_order_relaxed);
+
+    // jobs submitted by workers are pushed onto their own queue so that they
+    // run with warm caches unless another worker is idle and steals them
+    queue& q = *_queues[queue_index()];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.jobs.push_back({std::move(function), &counter});
+    }
+
+    // increment while holding the lock so that sleeping workers can not miss
+    // the notification between checking the count and waiting
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        ++_num_pending;
+    }
+    _sleep_condition.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void system::wait(job::counter& counter)
+{
+    std::size_t index = queue_index();
+    while (!counter.done()) {
+        if (!run_pending(index)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t system::queue_index() const
+{
+    return t_system == this ? t_queue_index : 0;
+}
+
+//------------------------------------------------------------------------------
+bool system::run_pending(std::size_t index)
+{
+    entry next{};
+    bool found = false;
+
+    // run the newest job from the thread's own queue
+    {
+        queue& q = *_queues[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.size()) {
+            next = std::move(q.jobs.back());
+            q.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // otherwise steal the oldest job from another queue
+    for (std::size_t ii = 1; !found && ii < _queues.size(); ++ii) {
+        queue& q = *_queues[(index + ii) % _queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.size()) {
+            next = std::move(q.jobs.front());
+            q.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    --_num_pending;
+    next.function();
+    next.counter->_value.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void system::worker_thread(std::size_t index)
+{
+    t_system = this;
+    t_queue_index = index;
+
+    while (true) {
+        if (run_pending(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _sleep_condition.wait(lock, [this]() { return _exit || _num_pending > 0; });
+        if (_exit) {
+            break;
+        }
+    }
+
+    t_system = nullptr;
+}
+
+} // namespace job
@@ -0,0 +1,139 @@
+// cm_job.h
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace job {
+
+class system;
+
+//------------------------------------------------------------------------------
+//! Number of outstanding jobs in a group. Jobs submitted with a counter
+//! increment it and decrement it when they complete, so waiting on a counter
+//! joins every job that was forked with it.
+class counter
+{
+public:
+    counter() : _value(0) {}
+
+    //! returns true if all jobs submitted with this counter have completed
+    bool done() const { return _value.load(std::memory_order_acquire) == 0; }
+
+protected:
+    friend system;
+
+    std::atomic<int> _value;
+
+protected:
+    counter(counter const&) = delete;
+    counter& operator=(counter const&) = delete;
+};
+
+//------------------------------------------------------------------------------
+//! Work-stealing thread pool. Each worker thread owns a queue of jobs which it
+//! runs newest first, and idle workers steal the oldest jobs from the queues
+//! of other workers. Jobs submitted from threads outside of the pool go into a
+//! shared queue. Threads which wait on a counter run pending jobs until the
+//! counter reaches zero so jobs may safely fork and join other jobs.
+class system
+{
+public:
+    system();
+    ~system();
+
+    //! start worker threads, if `num_threads` is zero then one thread is
+    //! started for each hardware thread except the calling thread
+    void init(int num_threads = 0);
+
+    //! stop all worker threads, pending jobs are discarded
+    void shutdown();
+
+    //! number of worker threads, not including threads that submit jobs
+    std::size_t num_threads() const { return _workers.size(); }
+
+    //! queue a job to be run on any thread
+    void submit(std::function<void()>&& function, job::counter& counter);
+
+    //! run pending jobs until all jobs in the counter have completed
+    void wait(job::counter& counter);
+
+    //! call `function(first, last)` on subranges of [begin, end) containing at
+    //! most `grain_size` elements and wait until all subranges are complete
+    template<typename function_type>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, function_type const& function);
+
+    //! returns the job system singleton, if one exists
+    static system* singleton() { return _singleton; }
+
+protected:
+    struct entry {
+        std::function<void()> function;
+        job::counter* counter;
+    };
+
+    struct queue {
+        std::mutex mutex;
+        std::deque<entry> jobs;
+    };
+
+    std::vector<std::unique_ptr<queue>> _queues; //!< one for each worker, and one for external threads
+    std::vector<std::thread> _workers;
+
+    std::mutex _sleep_mutex;
+    std::condition_variable _sleep_condition;
+    std::atomic<int> _num_pending; //!< number of jobs in all queues
+    std::atomic<bool> _exit;
+
+    static system* _singleton;
+
+protected:
+    void worker_thread(std::size_t index);
+
+    //! run a single pending job, returns false if no jobs are pending
+    bool run_pending(std::size_t index);
+
+    //! index of the queue owned by the calling thread
+    std::size_t queue_index() const;
+
+    system(system const&) = delete;
+    system& operator=(system const&) = delete;
+};
+
+//------------------------------------------------------------------------------
+template<typename function_type>
+void system::parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, function_type const& function)
+{
+    grain_size = std::max<std::size_t>(grain_size, 1);
+
+    if (end <= begin) {
+        return;
+    } else if (end - begin <= grain_size || !_workers.size()) {
+        function(begin, end);
+        return;
+    }
+
+    job::counter counter;
+
+    // the calling thread runs the final subrange itself
+    std::size_t first = begin;
+    for (; end - first > grain_size; first += grain_size) {
+        std::size_t last = first + grain_size;
+        submit([&function, first, last]() { function(first, last); }, counter);
+    }
+    function(first, end);
+
+    wait(counter);
+}
+
+} // namespace job
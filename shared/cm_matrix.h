@@ -28,7 +28,7 @@ public:
     bool operator==(mat2 const& M) const { return _rows[0] == M[0] && _rows[1] == M[1]; }
     bool operator!=(mat2 const& M) const { return _rows[0] != M[0] || _rows[1] != M[1]; }
     constexpr vec2 operator[](std::size_t idx) const { return _rows[idx]; }
-    vec2& operator[](std::size_t idx) { return _rows[idx]; }
+    constexpr vec2& operator[](std::size_t idx) { return _rows[idx]; }
 
 // basic functions
 
@@ -105,7 +105,7 @@ public:
     bool operator==(mat3 const& M) const { return _rows[0] == M[0] && _rows[1] == M[1] && _rows[2] == M[2]; }
     bool operator!=(mat3 const& M) const { return _rows[0] != M[0] || _rows[1] != M[1] || _rows[2] != M[2]; }
     constexpr vec3 operator[](std::size_t idx) const { return _rows[idx]; }
-    vec3& operator[](std::size_t idx) { return _rows[idx]; }
+    constexpr vec3& operator[](std::size_t idx) { return _rows[idx]; }
 
 // basic functions
 
@@ -218,7 +218,7 @@ public:
     bool operator==(mat4 const& M) const { return _rows[0] == M[0] && _rows[1] == M[1] && _rows[2] == M[2] && _rows[3] == M[3]; }
     bool operator!=(mat4 const& M) const { return _rows[0] != M[0] || _rows[1] != M[1] || _rows[2] != M[2] || _rows[3] != M[3]; }
     constexpr vec4 operator[](std::size_t idx) const { return _rows[idx]; }
-    vec4& operator[](std::size_t idx) { return _rows[idx]; }
+    constexpr vec4& operator[](std::size_t idx) { return _rows[idx]; }
 
 // basic functions
 
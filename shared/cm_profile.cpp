@@ -0,0 +1,280 @@
+// cm_profile.cpp
+//
+
+#include "cm_profile.h"
+#include "cm_shared.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace profile {
+
+namespace detail {
+std::atomic<bool> enabled(false);
+} // namespace detail
+
+namespace {
+
+static_assert((ring_size & (ring_size - 1)) == 0, "ring_size must be a power of two");
+
+//------------------------------------------------------------------------------
+//! Single producer, single consumer ring of zones recorded by one thread.
+struct thread_buffer
+{
+    std::array<zone_event, ring_size> events;
+    std::atomic<std::size_t> head; //!< next event written by the owning thread
+    std::atomic<std::size_t> tail; //!< next event read by `end_frame`
+    std::atomic<std::size_t> dropped;
+    std::size_t depth; //!< number of open zones, only used by the owning thread
+    std::size_t index; //!< thread id in captured traces
+    char name[SHORT_STRING];
+};
+
+//------------------------------------------------------------------------------
+struct captured_event
+{
+    zone_event event;
+    std::size_t thread;
+};
+
+//! guards the list of threads and all state below it
+std::mutex s_mutex;
+std::vector<std::unique_ptr<thread_buffer>> s_threads;
+
+bool s_enabled = false; //!< recording was requested by `set_enabled`
+std::size_t s_dropped = 0;
+
+std::vector<zone_summary> s_summary; //!< summary of the previous frame
+std::vector<zone_summary> s_frame_summary; //!< scratch space for `end_frame`
+
+std::string s_capture_filename;
+std::size_t s_capture_frames = 0; //!< remaining frames to capture
+std::vector<captured_event> s_capture;
+
+thread_local thread_buffer* t_buffer = nullptr;
+//! name of the calling thread, threads which are named but never enter a zone
+//! do not allocate a buffer
+thread_local char t_name[SHORT_STRING] = {};
+
+//------------------------------------------------------------------------------
+//! Returns the ring for the calling thread, registering it on first use.
+thread_buffer* get_thread_buffer()
+{
+    if (!t_buffer) {
+        auto buffer = std::make_unique<thread_buffer>();
+        buffer->head = 0;
+        buffer->tail = 0;
+        buffer->dropped = 0;
+        buffer->depth = 0;
+        memcpy(buffer->name, t_name, sizeof(buffer->name));
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        buffer->index = s_threads.size();
+        t_buffer = buffer.get();
+        s_threads.push_back(std::move(buffer));
+    }
+    return t_buffer;
+}
+
+//------------------------------------------------------------------------------
+//! Write `string` as a quoted JSON string.
+void write_string(FILE* file, char const* string)
+{
+    fputc('"', file);
+    for (char const* ch = string; *ch; ++ch) {
+        if (*ch == '"' || *ch == '\\') {
+            fputc('\\', file);
+            fputc(*ch, file);
+        } else if (static_cast<unsigned char>(*ch) >= ' ') {
+            fputc(*ch, file);
+        }
+    }
+    fputc('"', file);
+}
+
+//------------------------------------------------------------------------------
+//! Write captured zones in the Chrome trace-event format, zones are written as
+//! complete events and nesting is implied by their start times and durations.
+result write_trace(char const* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return result::failure;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+    for (auto const& buffer : s_threads) {
+        if (!buffer->name[0]) {
+            continue;
+        }
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":",
+                first ? "" : ",\n", buffer->index);
+        write_string(file, buffer->name);
+        fprintf(file, "}}");
+        first = false;
+    }
+
+    for (auto const& e : s_capture) {
+        fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        write_string(file, e.event.name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%lld,\"dur\":%lld}",
+                e.thread,
+                static_cast<long long>(e.event.start.to_microseconds()),
+                static_cast<long long>(e.event.duration.to_microseconds()));
+        first = false;
+    }
+
+    fprintf(file, "\n]}\n");
+
+    bool error = ferror(file) != 0;
+    fclose(file);
+    return error ? result::failure : result::success;
+}
+
+//------------------------------------------------------------------------------
+//! Add `e` to the totals for zones with the same name and depth.
+void accumulate(std::vector<zone_summary>& summary, zone_event const& e)
+{
+    for (auto& s : summary) {
+        if (s.depth == e.depth && (s.name == e.name || strcmp(s.name, e.name) == 0)) {
+            ++s.count;
+            s.total += e.duration;
+            s.start = std::min(s.start, e.start);
+            return;
+        }
+    }
+    summary.push_back({e.name, e.depth, 1, e.duration, e.start});
+}
+
+//------------------------------------------------------------------------------
+void update_enabled()
+{
+    detail::enabled.store(s_enabled || s_capture_frames, std::memory_order_relaxed);
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+void set_enabled(bool enable)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_enabled = enable;
+    update_enabled();
+}
+
+//------------------------------------------------------------------------------
+void set_thread_name(char const* name)
+{
+    strncpy(t_name, name, sizeof(t_name) - 1);
+    t_name[sizeof(t_name) - 1] = '\0';
+
+    if (t_buffer) {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        memcpy(t_buffer->name, t_name, sizeof(t_buffer->name));
+    }
+}
+
+//------------------------------------------------------------------------------
+void end_frame()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    s_frame_summary.clear();
+
+    for (auto const& buffer : s_threads) {
+        std::size_t tail = buffer->tail.load(std::memory_order_relaxed);
+        std::size_t head = buffer->head.load(std::memory_order_acquire);
+
+        for (; tail != head; ++tail) {
+            zone_event const& e = buffer->events[tail & (ring_size - 1)];
+            accumulate(s_frame_summary, e);
+            if (s_capture_frames) {
+                s_capture.push_back({e, buffer->index});
+            }
+        }
+
+        // the owning thread can reuse the drained events
+        buffer->tail.store(head, std::memory_order_release);
+        s_dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    // parent zones start before their children
+    std::sort(s_frame_summary.begin(), s_frame_summary.end(), [](zone_summary const& lhs, zone_summary const& rhs) {
+        return lhs.start < rhs.start || (lhs.start == rhs.start && lhs.depth < rhs.depth);
+    });
+    std::swap(s_summary, s_frame_summary);
+
+    if (s_capture_frames && --s_capture_frames == 0) {
+        if (failed(write_trace(s_capture_filename.c_str()))) {
+            log::warning("could not write profile capture to '%s'\n", s_capture_filename.c_str());
+        } else {
+            log::message("wrote %zu zones to '%s'\n", s_capture.size(), s_capture_filename.c_str());
+        }
+        s_capture.clear();
+        s_capture.shrink_to_fit();
+        update_enabled();
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<zone_summary> const& summary()
+{
+    return s_summary;
+}
+
+//------------------------------------------------------------------------------
+void capture(char const* filename, std::size_t num_frames)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_capture_filename = filename;
+    s_capture_frames = num_frames;
+    s_capture.clear();
+    update_enabled();
+}
+
+//------------------------------------------------------------------------------
+bool capturing()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_capture_frames != 0;
+}
+
+//------------------------------------------------------------------------------
+std::size_t dropped()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_dropped;
+}
+
+//------------------------------------------------------------------------------
+void scope::begin()
+{
+    ++get_thread_buffer()->depth;
+    _start = time_value::current();
+}
+
+//------------------------------------------------------------------------------
+void scope::end()
+{
+    time_value end = time_value::current();
+    thread_buffer* buffer = t_buffer;
+    std::size_t depth = --buffer->depth;
+
+    std::size_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) >= ring_size) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[head & (ring_size - 1)] = {_name, _start, end - _start, depth};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace profile
@@ -0,0 +1,111 @@
+// cm_profile.h
+//
+
+#pragma once
+
+#include "cm_time.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//! Time the enclosing scope as a zone named `name`, which must be a string
+//! literal or otherwise outlive the profiler.
+#define PROFILE_ZONE(name) profile::scope PROFILE_CONCAT(_profile_scope_, __LINE__)(name)
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_CONCAT_(a, b) a##b
+
+////////////////////////////////////////////////////////////////////////////////
+//! Hierarchical frame profiler. Zones are timed on the thread that enters them
+//! and pushed into a lock-free ring buffer owned by that thread, and the rings
+//! of all threads are drained by `end_frame`. When the profiler is disabled a
+//! zone only tests a flag, so zones can be left in shipping code.
+namespace profile {
+
+//! maximum number of zones each thread can record between calls to `end_frame`
+constexpr std::size_t ring_size = 8192;
+
+//------------------------------------------------------------------------------
+struct zone_event
+{
+    char const* name;
+    time_value start;
+    time_delta duration;
+    std::size_t depth; //!< number of enclosing zones on the same thread
+};
+
+//------------------------------------------------------------------------------
+//! Totals for all zones with the same name and depth in a single frame.
+struct zone_summary
+{
+    char const* name;
+    std::size_t depth;
+    std::size_t count;
+    time_delta total;
+    time_value start; //!< start of the earliest zone
+};
+
+namespace detail {
+extern std::atomic<bool> enabled;
+} // namespace detail
+
+//! returns true if zones are being recorded
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+//! enable or disable recording, recording stays enabled while capturing
+void set_enabled(bool enable);
+
+//! name the calling thread in captured traces
+void set_thread_name(char const* name);
+
+//! drain the zones recorded by all threads since the previous call, this must
+//! be called from one thread, typically at the end of the main loop
+void end_frame();
+
+//! zones of the most recently completed frame ordered by start time, this
+//! must be called from the same thread as `end_frame`
+std::vector<zone_summary> const& summary();
+
+//! record the next `num_frames` frames and write them to `filename` as a
+//! Chrome trace-event JSON file, which can be viewed in chrome://tracing
+void capture(char const* filename, std::size_t num_frames);
+
+//! returns true if a capture is in progress
+bool capturing();
+
+//! number of zones which were discarded because a ring buffer was full
+std::size_t dropped();
+
+//------------------------------------------------------------------------------
+//! Records the lifetime of the object as a zone, see `PROFILE_ZONE`.
+class scope
+{
+public:
+    explicit scope(char const* name)
+        : _name(enabled() ? name : nullptr)
+    {
+        if (_name) {
+            begin();
+        }
+    }
+
+    ~scope()
+    {
+        if (_name) {
+            end();
+        }
+    }
+
+protected:
+    char const* _name; //!< null if the profiler was disabled when entered
+    time_value _start;
+
+protected:
+    void begin();
+    void end();
+
+    scope(scope const&) = delete;
+    scope& operator=(scope const&) = delete;
+};
+
+} // namespace profile
@@ -5,6 +5,7 @@
 #include "cm_shared.h"
 
 #include <algorithm>
+#include <cstring>
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace string {
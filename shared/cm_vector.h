@@ -29,7 +29,7 @@ public:
     bool operator==(vec2 const& V) const { return x == V.x && y == V.y; }
     bool operator!=(vec2 const& V) const { return x != V.x || y != V.y; }
     constexpr float operator[](std::size_t idx) const { return (&x)[idx]; }
-    float& operator[](std::size_t idx) { return (&x)[idx]; }
+    constexpr float& operator[](std::size_t idx) { return (&x)[idx]; }
     operator float*() { return &x; }
     operator float const*() const { return &x; }
 
@@ -84,7 +84,7 @@ public:
     bool operator==(vec3 const& V) const {return x == V.x && y == V.y && z == V.z; }
     bool operator!=(vec3 const& V) const {return x != V.x || y != V.y || z != V.z; }
     constexpr float operator[](std::size_t idx) const { return (&x)[idx]; }
-    float& operator[](std::size_t idx) { return (&x)[idx]; }
+    constexpr float& operator[](std::size_t idx) { return (&x)[idx]; }
     operator float*() { return &x; }
     operator float const*() const { return &x; }
 
@@ -141,7 +141,7 @@ public:
     bool operator==(vec4 const& V) const { return x==V.x && y==V.y && z==V.z && w==V.w; }
     bool operator!=(vec4 const& V) const { return x!=V.x || y!=V.y || z!=V.z || w!=V.w; }
     constexpr float operator[](std::size_t idx) const { return (&x)[idx]; }
-    float& operator[](std::size_t idx) { return (&x)[idx]; }
+    constexpr float& operator[](std::size_t idx) { return (&x)[idx]; }
     operator float*() { return &x; }
     operator float const*() const { return &x; }
 
@@ -198,7 +198,7 @@ public:
     bool operator==(vec2i const& V) const { return x == V.x && y == V.y; }
     bool operator!=(vec2i const& V) const { return x != V.x || y != V.y; }
     constexpr int operator[](std::size_t idx) const { return (&x)[idx]; }
-    int& operator[](std::size_t idx) { return (&x)[idx]; }
+    constexpr int& operator[](std::size_t idx) { return (&x)[idx]; }
     operator int*() { return &x; }
     operator int const*() const { return &x; }
 
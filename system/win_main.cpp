@@ -6,6 +6,7 @@
 
 #include "cm_keys.h"
 
+#include <timeapi.h>
 #include <WS2tcpip.h>
 #include <XInput.h>
 
@@ -52,6 +53,7 @@ application::application(HINSTANCE hInstance)
     , _window(hInstance, wndproc)
     , _exit_code(0)
     , _mouse_state(0)
+    , _job_threads("sys_jobThreads", 0, config::archive, "number of job system worker threads, 0 for automatic")
 {
     _singleton = this;
 }
@@ -66,12 +68,20 @@ int application::main(LPSTR szCmdLine, int /*nCmdShow*/)
         return shutdown();
     }
 
+    // dedicated servers sleep between frames so use the finest timer
+    // resolution in order to wake up close to the scheduled frame time
+    if (_game._dedicated) {
+        timeBeginPeriod(1);
+    }
+
     previous_time = time_value::current();
 
     while (true) {
 
-        // inactive/idle loop
-        if (!_window.active()) {
+        // dedicated servers block until a packet arrives or a frame is due,
+        // otherwise sleep in the inactive/idle loop. dedicated servers also
+        // sleep if there is no running match server to wait on
+        if (!_game.wait_frame() && (_game._dedicated || !_window.active())) {
             Sleep(1);
         }
 
@@ -91,6 +101,9 @@ int application::main(LPSTR szCmdLine, int /*nCmdShow*/)
         current_time = time_value::current();
         _game.run_frame(current_time - previous_time);
         previous_time = current_time;
+
+        // collect zones recorded by all threads during the frame
+        profile::end_frame();
     }
 }
 
@@ -105,8 +118,13 @@ result application::init(HINSTANCE hInstance, LPSTR szCmdLine)
 
     srand(static_cast<unsigned int>(get_ticks()));
 
+    profile::set_thread_name("main");
+
     _config.init();
 
+    // start job system worker threads
+    _jobs.init(_job_threads);
+
     // initialize networking
     {
         WSADATA wsadata = {};
@@ -138,9 +156,16 @@ int application::shutdown()
     // shutdown opengl
     _window.destroy();
 
+    if (_game._dedicated) {
+        timeEndPeriod(1);
+    }
+
     // shutdown game
     _game.shutdown( );
 
+    // stop job system worker threads
+    _jobs.shutdown();
+
     // shutdown sound
     sound::system::destroy();
 
@@ -34,7 +34,10 @@ protected:
 
     string::view _init_string;
 
+    config::integer _job_threads;
+
     render::window _window;
+    job::system _jobs;
     game::session _game;
     config::system _config;
 